@@ -22,6 +22,7 @@
 #ifndef NDEBUG
 #include <QDebug>
 #endif
+#include "BufferPool.h"
 #include "DisplayTrace.h"
 #include "renderarea.h"
 #include <vector>
@@ -46,7 +47,11 @@ p_xdata{ std::make_unique<std::vector<double>>(xy_trace.size())}
 	set_ymin_ymax();
 }
 
-
+DisplayTrace::~DisplayTrace()
+{
+	// recycle the sample buffer, so replacing the oldest trace during playback needs no allocation
+	hkLib::BufferPool::global().release(std::move(m_data));
+}
 
 void DisplayTrace::reset()
 {
@@ -35,6 +35,7 @@ public:
     DisplayTrace(const QString& xunit, const QString& yunit, double x0,
         double deltax, std::vector<double>&& m_data);
     DisplayTrace(const std::vector<std::array<double, 2>>& xy_trace, const std::string_view& DACunit);
+    ~DisplayTrace();
     DisplayTrace& operator=(const DisplayTrace& dtrace) {
         m_x0 = dtrace.m_x0;
         m_deltax = dtrace.m_deltax;
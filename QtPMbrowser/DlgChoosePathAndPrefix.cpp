@@ -42,6 +42,12 @@ ui(new Ui::DlgChoosePathAndPrefix)
 	ui->comboBoxLevel->setCurrentIndex(
 		settings.value("DlgChoosePathAndPrefix/last_export_level", 1).toInt()
 	);
+	ui->checkBoxManifest->setChecked(
+		settings.value("DlgChoosePathAndPrefix/create_manifest", 0).toBool()
+	);
+	ui->comboBoxDataType->setCurrentIndex(
+		settings.value("DlgChoosePathAndPrefix/data_type", 0).toInt()
+	);
 	export_type = static_cast<ExportType>(settings.value("DlgChoosePathAndPrefix/export_type", 0).toInt());
 	switch (export_type) {
 	case ExportType::Igor:
@@ -99,6 +105,8 @@ void DlgChoosePathAndPrefix::accept()
 	pxp_export = ui->checkBox_pxp_export->isChecked();
 	create_datafolders = ui->checkBox_create_datafolders->isChecked();
 	level_last_folder = ui->comboBoxLevel->currentIndex();
+	create_manifest = ui->checkBoxManifest->isChecked();
+	data_type = static_cast<hkLib::ExportDataType>(ui->comboBoxDataType->currentIndex());
 
 	if (ui->radioButtonIgor->isChecked()) {
 		export_type = ExportType::Igor;
@@ -122,5 +130,7 @@ void DlgChoosePathAndPrefix::accept()
 	settings.setValue("DlgChoosePathAndPrefix/create_folders", create_datafolders);
 	settings.setValue("DlgChoosePathAndPrefix/last_export_level", level_last_folder);
 	settings.setValue("DlgChoosePathAndPrefix/export_type", static_cast<int>(export_type));
+	settings.setValue("DlgChoosePathAndPrefix/create_manifest", create_manifest);
+	settings.setValue("DlgChoosePathAndPrefix/data_type", static_cast<int>(data_type));
 	QDialog::accept();
 }
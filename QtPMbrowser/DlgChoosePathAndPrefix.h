@@ -22,6 +22,7 @@
 #include <QWidget>
 #include <QString>
 #include <QDialog>
+#include "SampleEncoder.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class DlgChoosePathAndPrefix; }
@@ -44,9 +45,10 @@ public:
 	~DlgChoosePathAndPrefix();
     void accept() override;
 	QString path, prefix{};
-    bool pxp_export{}, create_datafolders{};
+    bool pxp_export{}, create_datafolders{}, create_manifest{};
     int level_last_folder{};
     ExportType export_type{ ExportType::Igor };
+    hkLib::ExportDataType data_type{ hkLib::ExportDataType::Float64 };
 
 private slots:
 	void choosePath();
@@ -40,6 +40,10 @@ DlgPreferences::DlgPreferences(QWidget *parent)
 	ui->lineEditImon->setText(settings.value("Imon", "Imon").toString());
 	ui->checkBoxSysLocale->setChecked(!settings.value("use_C_locale", false).toBool());
 	ui->checkBoxZapSettings->setChecked(zap_settings);
+	ui->spinBoxPrefetchSweeps->setValue(settings.value("prefetch_sweeps", 2).toInt());
+	ui->spinBoxTraceCacheMB->setValue(settings.value("trace_cache_MB", 256).toInt());
+	ui->spinBoxExportThreads->setValue(settings.value("export_threads", 0).toInt());
+	ui->checkBoxCreateIndex->setChecked(settings.value("create_index_files", false).toBool());
 
 	settings.endGroup();
 }
@@ -63,6 +67,10 @@ void DlgPreferences::accept()
 	settings.setValue("Vmon", ui->lineEditVmon->text());
 	settings.setValue("Imon", ui->lineEditImon->text());
 	settings.setValue("use_C_locale", !ui->checkBoxSysLocale->isChecked());
+	settings.setValue("prefetch_sweeps", ui->spinBoxPrefetchSweeps->value());
+	settings.setValue("trace_cache_MB", ui->spinBoxTraceCacheMB->value());
+	settings.setValue("export_threads", ui->spinBoxExportThreads->value());
+	settings.setValue("create_index_files", ui->checkBoxCreateIndex->isChecked());
 	settings.endGroup();
 	switch (selection) {
 	case 0:
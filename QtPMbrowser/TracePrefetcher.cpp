@@ -0,0 +1,130 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <vector>
+#include "TracePrefetcher.h"
+#include "PositionalReader.h"
+
+using namespace hkLib;
+
+TracePrefetcher::TracePrefetcher()
+{
+    worker = std::thread(&TracePrefetcher::run, this);
+}
+
+TracePrefetcher::~TracePrefetcher()
+{
+    {
+        std::lock_guard lk(mtx);
+        quit = true;
+        pending.clear();
+    }
+    cv_work.notify_all();
+    worker.join();
+}
+
+void TracePrefetcher::setSource(std::shared_ptr<MappedFile> new_mapping, TraceCache* new_cache)
+{
+    clear();
+    std::lock_guard lk(mtx);
+    mapping = std::move(new_mapping);
+    cache = new_cache;
+}
+
+void TracePrefetcher::clear()
+{
+    std::unique_lock lk(mtx);
+    pending.clear();
+    cv_idle.wait(lk, [this] { return !busy; });
+    mapping.reset();
+    cache = nullptr;
+}
+
+void TracePrefetcher::setWindow(int sweeps)
+{
+    std::lock_guard lk(mtx);
+    window = std::max(0, sweeps);
+    if (window == 0) {
+        pending.clear();
+    }
+}
+
+void TracePrefetcher::prefetchAround(const hkTreeNode* trace)
+{
+    std::lock_guard lk(mtx);
+    pending.clear();
+    if (window == 0 || !mapping || !cache || trace->getLevel() != hkTreeNode::LevelTrace) {
+        return;
+    }
+    const auto* sweep = trace->getParent();
+    const auto& sweeps = sweep->getParent()->Children;
+    const auto n_sweeps = static_cast<std::ptrdiff_t>(sweeps.size());
+    const auto index = sweep - &sweeps.front();
+    auto enqueue = [this](const hkTreeNode& sw) {
+        for (const auto& tr : sw.Children) {
+            if (!cache->contains(&tr)) {
+                pending.push_back(&tr);
+            }
+        }
+    };
+    // siblings first, then sweeps in order of increasing distance, next before previous
+    enqueue(*sweep);
+    for (std::ptrdiff_t d = 1; d <= window; ++d) {
+        if (index + d < n_sweeps) {
+            enqueue(sweeps[index + d]);
+        }
+        if (index - d >= 0) {
+            enqueue(sweeps[index - d]);
+        }
+    }
+    if (!pending.empty()) {
+        cv_work.notify_one();
+    }
+}
+
+void TracePrefetcher::run()
+{
+    std::unique_lock lk(mtx);
+    while (true) {
+        cv_work.wait(lk, [this] { return quit || (!pending.empty() && mapping && cache); });
+        if (quit) {
+            return;
+        }
+        const auto* trace = pending.front();
+        pending.pop_front();
+        if (cache->contains(trace)) {
+            continue;
+        }
+        auto source = mapping;
+        auto* target = cache;
+        busy = true;
+        lk.unlock();
+        try {
+            PositionalReader reader(source);
+            target->insert(trace, TraceCache::load(reader, *trace));
+        }
+        catch (const std::exception&) {
+            // ignored here, the error will be reported if the trace is actually displayed
+        }
+        lk.lock();
+        busy = false;
+        cv_idle.notify_all();
+    }
+}
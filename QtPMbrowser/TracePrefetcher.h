@@ -0,0 +1,87 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACEPREFETCHER_H
+#define TRACEPREFETCHER_H
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "hkTree.h"
+#include "MappedFile.h"
+#include "TraceCache.h"
+
+/// <summary>
+/// Loads and converts the traces of neighbouring sweeps of the current series
+/// (and the sibling traces of the current sweep) on a worker thread into the trace cache
+/// of the DatFile, so that stepping through sweeps does not have to wait for the file.
+/// The worker reads the shared memory mapping of the data file with a PositionalReader,
+/// so it never touches the stream used by the GUI.
+/// </summary>
+class TracePrefetcher
+{
+public:
+    TracePrefetcher();
+    ~TracePrefetcher();
+    TracePrefetcher(const TracePrefetcher&) = delete;
+    TracePrefetcher& operator=(const TracePrefetcher&) = delete;
+
+    /// <summary>
+    /// set data file mapping and cache to fill, must be called whenever a file is opened
+    /// </summary>
+    void setSource(std::shared_ptr<hkLib::MappedFile> mapping, hkLib::TraceCache* cache);
+
+    /// <summary>
+    /// stop pending work, must be called before the DatFile the nodes and the cache
+    /// belong to is destroyed (i.e. when the file is closed)
+    /// </summary>
+    void clear();
+
+    /// <summary>
+    /// number of sweeps before and after the current one to prefetch, 0 disables prefetching
+    /// </summary>
+    void setWindow(int sweeps);
+    int getWindow() const { return window; };
+
+    /// <summary>
+    /// Schedule loading of the neighbourhood of trace. Pending requests for
+    /// a previous neighbourhood are dropped.
+    /// </summary>
+    void prefetchAround(const hkLib::hkTreeNode* trace);
+
+private:
+    void run();
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv_work, cv_idle;
+    std::deque<const hkLib::hkTreeNode*> pending;
+    std::shared_ptr<hkLib::MappedFile> mapping;
+    hkLib::TraceCache* cache{ nullptr };
+    int window{ 2 };
+    bool busy{ false };
+    bool quit{ false };
+};
+
+#endif // TRACEPREFETCHER_H
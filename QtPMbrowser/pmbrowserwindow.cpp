@@ -34,15 +34,24 @@
 #include <QStandardPaths>
 #include <QDesktopServices>
 #include <QTableView>
+#include <algorithm>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 #include <iostream>
 #include <ctime>
+#include <locale>
 #include <cstring>
 #include "pmbrowserwindow.h"
+#include "BufferPool.h"
 #include "exportIBW.h"
 #include "exportNPY.h"
+#include "ExportManifest.h"
+#include "MetadataBlockCache.h"
+#include "ParallelPipeline.h"
+#include "PositionalReader.h"
+#include "RecordFields.h"
 #include "hkTree.h"
 #include "StimTree.h"
 #include "helpers.h"
@@ -71,8 +80,8 @@ Q_DECLARE_METATYPE(hkTreeNode*)
 
 
 static QString MakeSweepLabel(const hkLib::hkTreeNode& sweep_node) {
-    QString label = QString("Sweep %1").arg(sweep_node.extractInt32(SwSweepCount));
-    auto sw_label = qs_from_sv(sweep_node.getString(SwLabel));
+    QString label = QString("Sweep %1").arg(sweep_node.get(Sweep::SweepCount));
+    auto sw_label = qs_from_sv(sweep_node.get(Sweep::Label));
     if (sw_label.length() > 0) {
         label += ' ' + sw_label;
     }
@@ -86,16 +95,16 @@ void PMbrowserWindow::populateTreeView()
     auto& pultree = datfile->GetPulTree();
     QList<QTreeWidgetItem *> grpitems;
     for(auto& group : pultree.GetRootNode().Children) {
-        QString count=QString("%1").arg(group.extractInt32(GrGroupCount));
-        QString label = qs_from_sv(group.getString(GrLabel));
+        QString count=QString("%1").arg(group.get(Group::GroupCount));
+        QString label = qs_from_sv(group.get(Group::Label));
         QStringList qsl;
         qsl.append(count+" "+label);
         QTreeWidgetItem* grpitem = new QTreeWidgetItem(static_cast<QTreeWidget *>(nullptr), qsl);
         grpitem->setData(0, Qt::UserRole, QVariant::fromValue(&group));
         grpitems.append(grpitem);
         for(auto& series : group.Children) {
-            QString label2 = QString("%1").arg(series.extractInt32(SeSeriesCount))+
-                " "+qs_from_sv(series.getString(SeLabel));
+            QString label2 = QString("%1").arg(series.get(Series::SeriesCount))+
+                " "+qs_from_sv(series.get(Series::Label));
             auto seriesitem = new QTreeWidgetItem(grpitem, QStringList(label2));
             seriesitem->setData(0, Qt::UserRole, QVariant::fromValue(&series));
             for(auto& sweep : series.Children) {
@@ -103,7 +112,7 @@ void PMbrowserWindow::populateTreeView()
                 auto sweepitem = new QTreeWidgetItem(seriesitem, QStringList(label3));
                 sweepitem->setData(0, Qt::UserRole, QVariant::fromValue(&sweep));
                 for(auto& trace : sweep.Children) {
-                    QString tracelabel{ QString::fromUtf8(formTraceName(trace, trace.extractInt32(TrTraceID))) };
+                    QString tracelabel{ QString::fromUtf8(formTraceName(trace, trace.get(Trace::TraceID))) };
                     auto traceitem = new QTreeWidgetItem(sweepitem, QStringList(tracelabel));
                     traceitem->setData(0,Qt::UserRole, QVariant::fromValue(&trace)); // store pointer to trace for later use
                 }
@@ -117,7 +126,7 @@ void PMbrowserWindow::populateTreeView()
 void PMbrowserWindow::traceSelected(const QTreeWidgetItem* item, const hkTreeNode* trace)
 {
     (void)item;
-    int indextrace = trace->extractInt32(TrTraceID);
+    int indextrace = trace->get(Trace::TraceID);
     auto trace_label = formTraceName(*trace, indextrace);
     QString tracename = QString("Trace ") + QString::fromUtf8(trace_label.data(), trace_label.size());
     ui->textEdit->append(tracename);
@@ -137,8 +146,29 @@ void PMbrowserWindow::traceSelected(const QTreeWidgetItem* item, const hkTreeNod
     formatParamListPrint(*trace, parametersTrace, str);
     info.append("\n");
     info.append(str.c_str());
+    if (const auto* stats = datfile->GetTraceStats(*trace)) {
+        info.append(QString("min=%L1 max=%L2 mean=%L3 %4").arg(stats->min).arg(stats->max).arg(stats->mean)
+            .arg(QLatin1StringView(yunit)));
+    }
     ui->textEdit->append(info);
-    ui->renderArea->renderTrace(trace, this->infile);
+    renderTrace(trace);
+    prefetcher.prefetchAround(trace);
+}
+
+bool PMbrowserWindow::renderTrace(const hkTreeNode* trace)
+{
+    hkLib::TraceCache::TraceData data;
+    try {
+        data = datfile->GetTraceData(infile, *trace);
+    }
+    catch (const std::exception& e) {
+        QMessageBox::warning(this, "File Error", e.what());
+        return false;
+    }
+    // the display keeps its own copy, take it from the pool so that playback doesn't allocate per trace
+    auto buffer = hkLib::BufferPool::global().acquire(data->size());
+    std::copy(data->begin(), data->end(), buffer.begin());
+    return ui->renderArea->renderTrace(trace, std::move(buffer));
 }
 
 void PMbrowserWindow::collectChildTraces(const QTreeWidgetItem* item, int level, std::vector<hkTreeNode*>& trace_list)
@@ -172,7 +202,7 @@ void PMbrowserWindow::animateTraceList(const QString& info_text, const std::vect
         if (progress.wasCanceled()) {
             break;
         }
-        if(!ui->renderArea->renderTrace(trace_list.at(i), infile)) {
+        if(!renderTrace(trace_list.at(i))) {
             break;
         }
         ui->renderArea->repaint();
@@ -246,8 +276,8 @@ void PMbrowserWindow::sweepSelected(const QTreeWidgetItem* item, const hkTreeNod
 void PMbrowserWindow::seriesSelected(const QTreeWidgetItem* item, const hkTreeNode* series)
 {
     (void)item;
-    QString label = qs_from_sv(series->getString(SeLabel));
-    int32_t count = series->extractInt32(SeSeriesCount);
+    QString label = qs_from_sv(series->get(Series::Label));
+    int32_t count = series->get(Series::SeriesCount);
     QString txt = QString("Series %1 %2").arg(label).arg(count);
     std::string str;
     formatParamListPrint(*series, parametersSeries, str);
@@ -259,8 +289,8 @@ void PMbrowserWindow::seriesSelected(const QTreeWidgetItem* item, const hkTreeNo
 void PMbrowserWindow::groupSelected(const QTreeWidgetItem* item, const hkTreeNode* group)
 {
     (void)item;
-    QString label = qs_from_sv(group->getString(GrLabel));
-    int32_t count = group->extractInt32(GrGroupCount);
+    QString label = qs_from_sv(group->get(Group::Label));
+    int32_t count = group->get(Group::GroupCount);
     QString txt = QString("Group %1 %2").arg(label).arg(count);
     std::string str;
     formatParamListPrint(*group, parametersGroup, str);
@@ -276,6 +306,12 @@ void PMbrowserWindow::closeFile()
         ui->renderArea->clearTrace();
         ui->treePulse->clear();
         this->setWindowTitle(myAppName);
+        // the worker threads use the nodes of datfile
+        indexer.request_stop();
+        if (indexer.joinable()) {
+            indexer.join();
+        }
+        prefetcher.clear();
         //delete datfile;
         datfile = nullptr;
         infile.close();
@@ -290,11 +326,11 @@ void PMbrowserWindow::loadFile(QString filename)
     }
     ui->textEdit->append("loading file " + filename);
 #ifdef _WIN32
-    infile.open(filename.toStdWString(), std::ios::in | std::ios::binary);
+    const std::filesystem::path filepath(filename.toStdWString());
 #else
-    auto encoded_filename = QFile::encodeName(filename);
-    infile.open(encoded_filename, std::ios::in | std::ios::binary);
+    const std::filesystem::path filepath(QFile::encodeName(filename).constData());
 #endif // _WIN32
+    infile.open(filepath);
     if (!infile) {
         QMessageBox::warning(this, QString("File Error"),
             QString("error opening file:\n") + QString(std::strerror(errno)));
@@ -305,9 +341,12 @@ void PMbrowserWindow::loadFile(QString filename)
     QSettings settings;
     settings.setValue("pmbrowserwindow/lastloadpath", lastloadpath);
     datfile = std::make_unique<DatFile>();
+    datfile->GetTraceCache().setBudget(trace_cache_budget);
     bool do_retry = false;
     try {
-        datfile->InitFromStream(infile);
+        if (datfile->InitFromStream(infile, filepath, hkLib::IndexMode::Use)) {
+            ui->textEdit->append("using index file");
+        }
     }
     catch (const hkLib::fileformat_error& e) {
         datfile = nullptr;
@@ -327,21 +366,22 @@ void PMbrowserWindow::loadFile(QString filename)
         try {
             // we might habe an unbundled dat file
             datfile = std::make_unique<DatFile>();
+            datfile->GetTraceCache().setBudget(trace_cache_budget);
             std::filesystem::path path(QFile::encodeName(filename).constData());
             path.replace_extension(hkLib::ExtPul);
-            std::ifstream pulstream(path, std::ios_base::binary | std::ios_base::in);
+            hkLib::MappedFileStream pulstream(path);
             if (!pulstream) {
                 throw std::runtime_error(std::string("could not open pul file, ") + ::strerror(errno));
             }
             auto pullength = std::filesystem::file_size(path);
             path.replace_extension(hkLib::ExtPgf);
-            std::ifstream pgfstream(path, std::ios_base::binary | std::ios_base::in);
+            hkLib::MappedFileStream pgfstream(path);
             if (!pgfstream) {
                 throw std::runtime_error(std::string("could not open pgf file, ") + ::strerror(errno));
             }
             auto pgflength = std::filesystem::file_size(path);
             path.replace_extension(hkLib::ExtAmp);
-            std::ifstream ampstream(path, std::ios_base::binary | std::ios_base::in);
+            hkLib::MappedFileStream ampstream(path);
             if (!ampstream) {
                 datfile->InitFromStream(infile, pulstream, pullength, pgfstream, pgflength, nullptr, 0);
             }
@@ -358,6 +398,7 @@ void PMbrowserWindow::loadFile(QString filename)
         }
     }
     if(datfile) {
+        prefetcher.setSource(infile.rdbuf()->getMapping(), &datfile->GetTraceCache());
         populateTreeView();
         this->setWindowTitle(myAppName + " - " + filename.split("/").back());
         QString txt = QString("PM Version ") + QString::fromStdString(datfile->getVersion());
@@ -385,6 +426,23 @@ void PMbrowserWindow::loadFile(QString filename)
         ui->textEdit->append(txt);
         ui->textEdit->append(QString::fromUtf8("file date: ")
             + QString::fromStdString(datfile->getFileDate()));
+        if (create_index_files && datfile->canCreateIndex()) {
+            // reads all trace data, so this is done in the background, while the file is already shown
+            ui->textEdit->append("creating index file");
+            indexer = std::jthread([this, df = datfile.get(), mapping = infile.rdbuf()->getMapping()](std::stop_token stop) {
+                try {
+                    hkLib::PositionalReader reader(mapping);
+                    if (df->CreateIndex(reader, stop)) {
+                        QMetaObject::invokeMethod(this, [this] { ui->textEdit->append("index file created"); },
+                            Qt::QueuedConnection);
+                    }
+                }
+                catch (const std::exception& e) {
+                    // the index is only a cache, we can do without
+                    qDebug() << e.what();
+                }
+            });
+        }
     }
 }
 
@@ -479,32 +537,36 @@ bool PMbrowserWindow::assertDatFileOpen()
     return true;
 }
 
-void PMbrowserWindow::exportSubTree(QTreeWidgetItem* item, const QString& path, const QString& prefix, ExportType export_type, std::ostream* poutfile, bool create_datafolders, int folder_level)
+void PMbrowserWindow::collectExportJobs(QTreeWidgetItem* item, const QString& prefix, ExportType export_type, bool pxp_export, bool create_datafolders, int folder_level, std::vector<ExportJob>& jobs)
 {
     if (item->isHidden()) { return; } // export only visible items
     int N = item->childCount();
     if (N > 0) {
         bool new_datafolder{ false };
         if (export_type == ExportType::Igor) {
-            if (create_datafolders && poutfile != nullptr) {
+            if (create_datafolders && pxp_export) {
                 auto node = item->data(0, Qt::UserRole).value<hkTreeNode*>();
-                new_datafolder = (poutfile != nullptr) && (node->getLevel() >= hkTreeNode::LevelGroup &&
-                    node->getLevel() <= folder_level);
+                new_datafolder = node->getLevel() >= hkTreeNode::LevelGroup &&
+                    node->getLevel() <= folder_level;
             }
             if (new_datafolder) {
                 PackedFileRecordHeader pfrh{ kDataFolderStartRecord,0,32 };
                 char buf[32]{};
                 item->text(0).toStdString().copy(buf, 31);
-                poutfile->write(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
-                poutfile->write(buf, 32);
+                ExportJob job{};
+                job.record.append(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
+                job.record.append(buf, 32);
+                jobs.push_back(std::move(job));
             }
         }
         for (int i = 0; i < N; ++i) {
-            exportSubTree(item->child(i), path, prefix, export_type, poutfile, create_datafolders, folder_level);
+            collectExportJobs(item->child(i), prefix, export_type, pxp_export, create_datafolders, folder_level, jobs);
         }
         if (export_type == ExportType::Igor && new_datafolder) {
             PackedFileRecordHeader pfrh{ kDataFolderEndRecord,0,0 };
-            poutfile->write(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
+            ExportJob job{};
+            job.record.append(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
+            jobs.push_back(std::move(job));
         }
     }
     else {
@@ -521,54 +583,109 @@ void PMbrowserWindow::exportSubTree(QTreeWidgetItem* item, const QString& path,
         hkTreeNode* traceentry = v.value<hkTreeNode*>();
         auto tracelabel = QString::fromStdString(formTraceName(*traceentry, indextrace));
         QString wavename = prefix + QString("_%1_%2_%3_%4").arg(indexgroup).arg(indexseries).arg(indexsweep).arg(tracelabel);
-        ui->textEdit->append("exporting " + wavename);
+        jobs.push_back({ traceentry, wavename, {} });
+    }
+}
 
-        if (export_type == ExportType::Igor) {
-            auto wname = wavename.toStdString();
-            unsigned err{0};
-            if (poutfile == nullptr) { // multi-file export
-                QString filename = path + wavename + ".ibw";
-                std::ofstream outfile(QFile::encodeName(filename), std::ios::out | std::ios::binary);
-                if (!outfile) {
-                    std::stringstream msg;
-                    msg << "error opening file '" << filename.toStdString() << "' for writing: " << strerror(errno);
-                    throw std::runtime_error(msg.str());
+void PMbrowserWindow::runExportJobs(const std::vector<ExportJob>& jobs, const QString& path, const QString& prefix, ExportType export_type, std::ostream* poutfile)
+{
+    struct Result {
+        std::string record; // ibw data for pxp export
+        std::string wname;
+        unsigned err{};
+    };
+    if (export_type != ExportType::Igor && export_type != ExportType::NPY && export_type != ExportType::BIN) {
+        throw std::runtime_error("unexpected export type");
+    }
+    const bool with_manifest = export_manifest && export_type != ExportType::Igor;
+    std::ofstream manifest_file;
+    if (with_manifest) {
+        QString filename = path + prefix + "_manifest.jsonl";
+        manifest_file.open(QFile::encodeName(filename), std::ios::out);
+        if (!manifest_file) {
+            throw std::runtime_error("error opening file '" + filename.toStdString() + "' for writing");
+        }
+    }
+    hkLib::ManifestWriter manifest(manifest_file, export_data_type);
+    // parameters of root, group, series and sweep are formatted once, not for every trace
+    hkLib::MetadataBlockCache blocks(export_type == ExportType::Igor ?
+        hkLib::MetadataBlockCache::Format::WaveNote : hkLib::MetadataBlockCache::Format::JSON);
+    hkLib::PositionalReader reader(infile.rdbuf()->getMapping());
+    // traces are read, converted and written (or formatted, for pxp export) by worker threads,
+    // the results are handled here in tree order, so the output does not depend on the number of threads
+    hkLib::RunOrderedPipeline(jobs.size(), export_threads,
+        [&](std::size_t i) {
+            const auto& job = jobs[i];
+            Result res{};
+            if (!job.trace) {
+                return res;
+            }
+            // traces already in the display cache are taken from there (unless raw samples are needed
+            // for native export), all others are streamed, so an export doesn't displace the cached traces
+            const auto dtype = export_data_type;
+            auto export_trace = [&](auto&& write) {
+                if (dtype != hkLib::ExportDataType::Native) {
+                    if (auto data = datfile->GetTraceCache().find(job.trace)) {
+                        return write(std::span<const double>(*data));
+                    }
+                }
+                hkLib::TraceChunkReader chunks(reader, *job.trace);
+                return write(chunks);
+            };
+            if (export_type == ExportType::Igor) {
+                res.wname = job.wavename.toStdString();
+                if (poutfile == nullptr) { // multi-file export
+                    QString filename = path + job.wavename + ".ibw";
+                    std::ofstream outfile(QFile::encodeName(filename), std::ios::out | std::ios::binary);
+                    if (!outfile) {
+                        std::stringstream msg;
+                        msg << "error opening file '" << filename.toStdString() << "' for writing: " << strerror(errno);
+                        throw std::runtime_error(msg.str());
+                    }
+                    res.err = export_trace([&](auto&& data) { return ExportTrace(data, *job.trace, outfile, res.wname, dtype, &blocks); });
+                }
+                else {
+                    std::ostringstream record;
+                    res.err = export_trace([&](auto&& data) { return ExportTrace(data, *job.trace, record, res.wname, dtype, &blocks); });
+                    res.record = std::move(record).str();
                 }
-                err = ExportTrace(infile, *traceentry, outfile, wname);
             }
             else {
-                PackedFileRecordHeader pfrh{};
-                pfrh.recordType = kWaveRecord;
-                size_t offset_record = poutfile->tellp();
-                poutfile->write(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
-                err = ExportTrace(infile, *traceentry, *poutfile, wname);
-                size_t offset_end = poutfile->tellp();
-                pfrh.numDataBytes = static_cast<std::int32_t>(offset_end - offset_record - sizeof(PackedFileRecordHeader));
-                poutfile->seekp(offset_record);
-                poutfile->write(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
-                poutfile->seekp(offset_end);
-            }
-            if(err & WARNFLAG_WNAMETRUNCATED){
-                ui->textEdit->append("Warning: wavename truncated to " + QString::fromUtf8(wname));
+                QString filename{ path + job.wavename };
+                filename.append(export_type == ExportType::NPY ? ".npy" : ".bin");
+                export_trace([&](auto&& data) {
+                    NPYorBINExportTrace(data, *job.trace, QDir(filename).filesystemPath(), !with_manifest, dtype, &blocks);
+                    return 0u;
+                });
             }
-        }
-        else
-        {
-            QString filename{path + wavename};
-            if (export_type == ExportType::NPY)
-            {
-                filename.append(".npy");
+            return res;
+        },
+        [&](std::size_t i, Result res) {
+            const auto& job = jobs[i];
+            if (!job.trace) {
+                // data folder record, only used for pxp export
+                poutfile->write(job.record.data(), job.record.size());
+                return;
             }
-            else if (export_type == ExportType::BIN)
-            {
-                filename.append(".bin");
+            ui->textEdit->append("exporting " + job.wavename);
+            if (with_manifest) {
+                manifest.addTrace(*job.trace, (job.wavename + (export_type == ExportType::NPY ? ".npy" : ".bin")).toStdString());
             }
-            else
-            {
-                throw std::runtime_error("unexpected export type");
+            if (export_type == ExportType::Igor) {
+                if (poutfile != nullptr) {
+                    PackedFileRecordHeader pfrh{};
+                    pfrh.recordType = kWaveRecord;
+                    pfrh.numDataBytes = static_cast<std::int32_t>(res.record.size());
+                    poutfile->write(reinterpret_cast<char*>(&pfrh), sizeof(PackedFileRecordHeader));
+                    poutfile->write(res.record.data(), res.record.size());
+                }
+                if (res.err & WARNFLAG_WNAMETRUNCATED) {
+                    ui->textEdit->append("Warning: wavename truncated to " + QString::fromUtf8(res.wname));
+                }
             }
-            NPYorBINExportTrace(infile, *traceentry, QDir(filename).filesystemPath(), true);
-        }
+        });
+    if (with_manifest && !manifest_file) {
+        throw std::runtime_error("error while writing manifest file");
     }
 }
 
@@ -590,6 +707,8 @@ bool PMbrowserWindow::choosePathAndPrefix(QString& path, QString& prefix, Export
             path.append('/');
         }
         export_type = dlg.export_type;
+        export_data_type = dlg.data_type;
+        export_manifest = dlg.create_manifest;
         pxp_export = dlg.pxp_export;
         create_datafolders = dlg.create_datafolders;
         last_folder_level = dlg.level_last_folder + hkTreeNode::LevelGroup; // combo box starts with Group
@@ -638,19 +757,17 @@ void PMbrowserWindow::exportAllVisibleTraces()
                 auto encoded_filename = QFile::encodeName(path);
                 hkLib::NPYExportTreeSweepsAsArray(infile, tree,
                     {encoded_filename.data(), static_cast<std::size_t>(encoded_filename.size())},
-                    prefix.toStdString(), true);
+                    prefix.toStdString(), true, &datfile->GetTraceCache());
             }
             else {
                 // TODO: use getVisibleTraces and move the following to hekatoolslib
+                bool to_pxp = export_type == ExportType::Igor && pxp_export;
+                std::vector<ExportJob> jobs;
                 int N = ui->treePulse->topLevelItemCount();
                 for (int i = 0; i < N; ++i) {
-                    if (export_type == ExportType::Igor && pxp_export) {
-                        exportSubTree(ui->treePulse->topLevelItem(i), path, prefix, export_type, &outfile, create_datafolders, folder_level);
-                    }
-                    else {
-                        exportSubTree(ui->treePulse->topLevelItem(i), path, prefix, export_type, nullptr, false, 0);
-                    }
+                    collectExportJobs(ui->treePulse->topLevelItem(i), prefix, export_type, to_pxp, create_datafolders, folder_level, jobs);
                 }
+                runExportJobs(jobs, path, prefix, export_type, to_pxp ? &outfile : nullptr);
                 if (export_type == ExportType::Igor && pxp_export && create_datafolders) {
                     WriteIgorProcedureRecord(outfile);
                 }
@@ -669,35 +786,43 @@ void PMbrowserWindow::formatStimMetadataAsTableExport(std::ostream& os, int max_
         throw std::runtime_error("max_level exceeds LevelTrace(=4)");
     }
     DatFile::metadataCreateTableHeader(os);
+    const ParamFormatPlan grp_plan(parametersGroup), se_plan(parametersSeries),
+        sw_plan(parametersSweep), tr_plan(parametersTrace);
+    const auto loc = os.getloc();
+    std::string grp_entry, se_entry, sw_entry, tr_entry;
     try {
         int N = ui->treePulse->topLevelItemCount();
         for (int i = 0; i < N; ++i) { // level: group
             const auto tli = ui->treePulse->topLevelItem(i);
             if (tli->isHidden()) continue;
             const auto& grp = *(tli->data(0, Qt::UserRole).value<hkTreeNode*>());
-            auto gpr_count = grp.extractValue<std::int32_t>(GrGroupCount);
-            std::string grp_entry = formatParamListExportTable(grp, parametersGroup);
+            auto gpr_count = grp.get(Group::GroupCount);
+            grp_entry.clear();
+            grp_plan.appendTable(grp, grp_entry, loc);
             int Nse = tli->childCount();
             for (int j = 0; j < Nse; ++j) { // level: series
                 const auto se_item = tli->child(j);
                 if (se_item->isHidden()) continue;
                 const auto& series = *(se_item->data(0, Qt::UserRole).value<hkTreeNode*>());
-                auto se_count = series.extractValue<std::int32_t>(SeSeriesCount);
-                std::string se_entry = formatParamListExportTable(series, parametersSeries);
+                auto se_count = series.get(Series::SeriesCount);
+                se_entry.clear();
+                se_plan.appendTable(series, se_entry, loc);
                 int M = se_item->childCount();
                 for (int k = 0; k < M; ++k) { // level: sweep
                     const auto sw_item = se_item->child(k);
                     if (sw_item->isHidden()) continue;
                     const auto& sweep = *(sw_item->data(0, Qt::UserRole).value<hkTreeNode*>());
-                    auto sw_count = sweep.extractValue<std::int32_t>(SwSweepCount);
-                    std::string sw_entry = formatParamListExportTable(sweep, parametersSweep);
+                    auto sw_count = sweep.get(Sweep::SweepCount);
+                    sw_entry.clear();
+                    sw_plan.appendTable(sweep, sw_entry, loc);
                     int Nsw = sw_item->childCount();
                     for (int l = 0; l < Nsw; ++l) { // level: trace
                         const auto tr_item = sw_item->child(l);
                         if (tr_item->isHidden()) continue;
                         const auto& trace = *(tr_item->data(0, Qt::UserRole).value<hkTreeNode*>());
-                        auto tr_count = trace.extractValue<std::int32_t>(TrTraceCount);
-                        std::string tr_entry = formatParamListExportTable(trace, parametersTrace);
+                        auto tr_count = trace.get(Trace::TraceID);
+                        tr_entry.clear();
+                        tr_plan.appendTable(trace, tr_entry, loc);
                         os << gpr_count << '\t' << se_count << '\t' << sw_count << '\t'
                             << tr_count <<
                             grp_entry << se_entry << sw_entry << tr_entry << '\n';
@@ -738,12 +863,10 @@ void PMbrowserWindow::exportSubTreeAsIBW(QTreeWidgetItem* root)
             }
         }
         try {
-            if (export_type == ExportType::Igor && pxp_export) {
-                exportSubTree(root, path, prefix, export_type, &outfile, create_datafolders, folder_level);
-            }
-            else {
-                exportSubTree(root, path, prefix, export_type, nullptr, false, 0);
-            }
+            bool to_pxp = export_type == ExportType::Igor && pxp_export;
+            std::vector<ExportJob> jobs;
+            collectExportJobs(root, prefix, export_type, to_pxp, create_datafolders, folder_level, jobs);
+            runExportJobs(jobs, path, prefix, export_type, to_pxp ? &outfile : nullptr);
             if (export_type == ExportType::Igor && pxp_export && create_datafolders) {
                 WriteIgorProcedureRecord(outfile);
             }
@@ -852,7 +975,8 @@ void PMbrowserWindow::on_actionExport_All_as_IBW_triggered()
             }
             ui->textEdit->append("exporting...");
             try {
-                auto err = ExportAllTraces(infile, *datfile, path.toStdString(), prefix.toStdString());
+                auto err = ExportAllTraces(infile, *datfile, path.toStdString(), prefix.toStdString(), export_threads,
+                    export_data_type);
                 if(err & hkLib::WARNFLAG_WNAMETRUNCATED) {
                     ui->textEdit->append("wavename(s) truncated in export");
                 }
@@ -875,13 +999,12 @@ void PMbrowserWindow::on_actionExport_Metadata_as_Table_triggered()
     DlgExportMetadata dlg(this);
     if (dlg.exec()) {
         try {
-            hkLib::locale_manager lm;
+            // the locale is imbued into the output stream only, the global locale
+            // is left alone, since exports might be running in the background
+            std::locale loc = std::locale::classic();
             if (dlg.useSystemLocale()) {
                 // for macOS, we need to jump to some hoops
-                lm.setLocale(QLocale::system().name().toUtf8());
-            }
-            else {
-                lm.setLocale("C");
+                loc = std::locale(QLocale::system().name().toUtf8().constData());
             }
             auto selected = dlg.getSelection();
             if (selected < 0)
@@ -893,6 +1016,7 @@ void PMbrowserWindow::on_actionExport_Metadata_as_Table_triggered()
             }
             if (dlg.doCopy() || dlg.doShow()) {
                 std::ostringstream s;
+                s.imbue(loc);
                 this->formatStimMetadataAsTableExport(s, selected);
                 QString txt = QString::fromUtf8(s.str());
                 if(dlg.doCopy()) QGuiApplication::clipboard()->setText(txt);
@@ -908,6 +1032,7 @@ void PMbrowserWindow::on_actionExport_Metadata_as_Table_triggered()
                             QString("Cannot open file '%1'\nfor saving").arg(export_file_name));
                         return;
                     }
+                    export_file.imbue(loc);
                     this->formatStimMetadataAsTableExport(export_file, selected);
                 }
             }
@@ -1176,7 +1301,7 @@ void PMbrowserWindow::printStimProtocol(const hkLib::hkTreeNode* sweep)
 {
     try{
     assert(sweep->getLevel() == hkTreeNode::LevelSweep);
-    int stim_index = sweep->extractInt32(SwStimCount) - 1;
+    int stim_index = sweep->get(Sweep::StimCount) - 1;
     const auto& stim_node = datfile->GetPgfTree().GetRootNode().Children.at(stim_index);
     std::stringstream s;
     hkLib::stimRecordToCSV(stim_node, s, false, true, false);
@@ -1190,8 +1315,8 @@ void PMbrowserWindow::printStimProtocol(const hkLib::hkTreeNode* sweep)
 void PMbrowserWindow::create_stim_trace(const hkTreeNode* sweep, DisplayTrace& dt) const
 {
     assert(sweep->getLevel() == hkTreeNode::LevelSweep);
-        int stim_index = sweep->extractInt32(SwStimCount) - 1,
-        sweep_index = sweep->extractInt32(SwSweepCount) - 1;
+        int stim_index = sweep->get(Sweep::StimCount) - 1,
+        sweep_index = sweep->get(Sweep::SweepCount) - 1;
     StimRootRecord root(datfile->GetPgfTree().GetRootNode());
     const auto& stim = root.Stims.at(stim_index);
     auto stim_trace = stim.constructStimTrace(sweep_index);
@@ -1252,7 +1377,16 @@ void PMbrowserWindow::openHelp()
 void PMbrowserWindow::openPreferences()
 {
     DlgPreferences dlg(this);
-    dlg.exec();
+    if (dlg.exec() == QDialog::Accepted) {
+        QSettings settings;
+        prefetcher.setWindow(settings.value("Preferences/prefetch_sweeps", prefetcher.getWindow()).toInt());
+        trace_cache_budget = std::size_t(settings.value("Preferences/trace_cache_MB", int(trace_cache_budget >> 20)).toInt()) << 20;
+        export_threads = static_cast<unsigned>(settings.value("Preferences/export_threads", 0).toInt());
+        create_index_files = settings.value("Preferences/create_index_files", false).toBool();
+        if (datfile) {
+            datfile->GetTraceCache().setBudget(trace_cache_budget);
+        }
+    }
 }
 
 void PMbrowserWindow::dragEnterEvent(QDragEnterEvent* event)
@@ -1430,5 +1564,9 @@ void PMbrowserWindow::loadSettings()
 		global_hkSettings.ext_Vmon.clear();
 		global_hkSettings.ext_Imon.clear();
 	}
+    prefetcher.setWindow(settings.value("prefetch_sweeps", prefetcher.getWindow()).toInt());
+    trace_cache_budget = std::size_t(settings.value("trace_cache_MB", int(trace_cache_budget >> 20)).toInt()) << 20;
+    export_threads = static_cast<unsigned>(settings.value("export_threads", 0).toInt());
+    create_index_files = settings.value("create_index_files", false).toBool();
     settings.endGroup();
 }
@@ -29,7 +29,12 @@
 #include "ui_pmbrowserwindow.h"
 #include <fstream>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include "DatFile.h"
+#include "MappedFile.h"
+#include "TracePrefetcher.h"
 #include "DlgChoosePathAndPrefix.h"
 #include <hkTreeView.h>
 
@@ -82,6 +87,7 @@ private:
     void seriesSelected(const QTreeWidgetItem* item, const hkLib::hkTreeNode* node);
     void sweepSelected(const QTreeWidgetItem* item, const hkLib::hkTreeNode* node);
     void traceSelected(const QTreeWidgetItem* item, const hkLib::hkTreeNode* trace);
+    bool renderTrace(const hkLib::hkTreeNode* trace); // render trace using the trace cache
     void collectChildTraces(const QTreeWidgetItem* item, int level, std::vector<hkLib::hkTreeNode*>& trace_list);
     void animateTraceList(const QString& info_text, const std::vector<hkLib::hkTreeNode*>& trace_list);
     hkLib::hkTreeView getVisibleNodes();
@@ -95,7 +101,13 @@ private:
     void drawStimuliSeries(const hkLib::hkTreeNode* sweep);
     void create_stim_trace(const hkLib::hkTreeNode* sweep, DisplayTrace& dt) const;
     bool assertDatFileOpen();
-    void exportSubTree(QTreeWidgetItem* item, const QString& path, const QString& prefix, ExportType export_type, std::ostream *outfile, bool create_datafolders, int folder_level);
+    struct ExportJob {
+        hkLib::hkTreeNode* trace{}; // nullptr for pxp data folder records
+        QString wavename;
+        std::string record; // data folder record, written as is
+    };
+    void collectExportJobs(QTreeWidgetItem* item, const QString& prefix, ExportType export_type, bool pxp_export, bool create_datafolders, int folder_level, std::vector<ExportJob>& jobs);
+    void runExportJobs(const std::vector<ExportJob>& jobs, const QString& path, const QString& prefix, ExportType export_type, std::ostream* poutfile);
     bool choosePathAndPrefix(QString& path, QString& prefix, ExportType& export_type, bool& pxp_export, bool& create_datafolders, int & last_folder_level);
     void exportSubTreeAsIBW(QTreeWidgetItem* root);
     void exportAllVisibleTraces();
@@ -109,8 +121,15 @@ private:
     QString currentFile;
     QUrl help_url{};
     QAction actHelp{ "&Help" };
-    std::ifstream infile;
+    hkLib::MappedFileStream infile; // memory mapped, trees and trace data are accessed without copying
     std::unique_ptr<hkLib::DatFile> datfile;
+    TracePrefetcher prefetcher; // must be declared after datfile, the worker thread uses its nodes and cache
+    std::jthread indexer; // creates a missing index file in the background, must be declared after datfile, too
+    std::size_t trace_cache_budget{ hkLib::TraceCache::DefaultBudget };
+    unsigned export_threads{ 0 }; // 0: one per core
+    bool create_index_files{ false }; // create sidecar index (.pmidx) after opening a file, existing ones are always used
+    hkLib::ExportDataType export_data_type{ hkLib::ExportDataType::Float64 }; // as chosen in last export dialog
+    bool export_manifest{ false }; // NPY/BIN export: single manifest instead of one JSON file per trace
     QString lastloadpath, lastexportpath;
     QString filterStrGrp, filterStrSer, filterStrSwp, filterStrTr;
     bool settings_modified;
@@ -39,6 +39,7 @@
 #include "DlgGraphSettings.h"
 #include "renderarea.h"
 #include "DatFile.h"
+#include "TraceView.h"
 #include "DisplayTrace.h"
 #include "qstring_helper.h"
 
@@ -759,40 +760,36 @@ void RenderArea::zoomIn(double x_center, double y_center, double factor)
 bool RenderArea::renderTrace(const hkLib::hkTreeNode* TrRecord, std::istream& infile)
 {
     using namespace hkLib;
-    char dataformat = TrRecord->getChar(TrDataFormat);
-    uint16_t tracedatakind = TrRecord->extractUInt16(TrDataKind);
+    std::vector<double> new_data;
+	try {
+        TraceView trace_view(infile, *TrRecord);
+        new_data = trace_view.toVector();
+	}
+	catch (const std::exception& e) {
+//        newYtrace.data.clear();
+		QMessageBox::warning(nullptr, "File Error", e.what());
+		return false;
+	}
+    return renderTrace(TrRecord, std::move(new_data));
+}
+
+bool RenderArea::renderTrace(const hkLib::hkTreeNode* TrRecord, std::vector<double>&& data)
+{
+    using namespace hkLib;
+    uint16_t tracedatakind = TrRecord->get(Trace::DataKind);
     clipped = tracedatakind & ClipBit;
-    ndatapoints = TrRecord->extractValue<uint32_t>(TrDataPoints);
+    ndatapoints = TrRecord->get(Trace::DataPoints);
 	try {
-        std::vector<double> new_data(ndatapoints);
-		if (dataformat == DFT_int16) {
-			ReadScaleAndConvert<int16_t>(infile, *TrRecord, ndatapoints, new_data.data());
-		}
-		else if (dataformat == DFT_int32) {
-			ReadScaleAndConvert<int32_t>(infile, *TrRecord, ndatapoints, new_data.data());
-		}
-		else if (dataformat == DFT_float) {
-			ReadScaleAndConvert<float>(infile, *TrRecord, ndatapoints, new_data.data());
-		}
-		else if (dataformat == DFT_double) {
-			ReadScaleAndConvert<double>(infile, *TrRecord, ndatapoints, new_data.data());
-		}
-		else {
-			QMessageBox::warning(this, QString("Data Format Error"), QString("Unknown Dataformat"));
-			return false;
-		}
-        
         addTrace(DisplayTrace(
             qs_from_sv(TrRecord->getString<8>(TrXUnit)),
             qs_from_sv(TrRecord->getString<8>(TrYUnit)),
-            TrRecord->extractLongReal(TrXStart),
-            TrRecord->extractLongReal(TrXInterval),
-            std::move(new_data)
+            TrRecord->get(Trace::XStart),
+            TrRecord->get(Trace::XInterval),
+            std::move(data)
             )
         );
 	}
 	catch (const std::exception& e) {
-//        newYtrace.data.clear();
 		QMessageBox::warning(nullptr, "File Error", e.what());
 		return false;
 	}
@@ -50,6 +50,7 @@ public:
     ~RenderArea();
     bool noData() { return !yTrace.isValid(); };
     bool renderTrace(const hkLib::hkTreeNode* trace, std::istream& infile);
+    bool renderTrace(const hkLib::hkTreeNode* trace, std::vector<double>&& data); // data already loaded and converted
     void addTrace(DisplayTrace&& dt);
 
     /// <summary>
@@ -0,0 +1,147 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// small tool to benchmark the conversion kernels used to scale trace data,
+// reports throughput (of raw input data) for each data format and instruction set
+// and checks that all instruction sets yield identical results
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "ConvertKernels.h"
+#include "hkTree.h"
+
+using namespace hkLib;
+
+namespace {
+    const char* formatName(char dataformat)
+    {
+        switch (dataformat) {
+        case DFT_int16: return "int16";
+        case DFT_int32: return "int32";
+        case DFT_float: return "float";
+        default: return "double";
+        }
+    }
+
+    std::size_t sampleSize(char dataformat)
+    {
+        switch (dataformat) {
+        case DFT_int16: return 2;
+        case DFT_int32: return 4;
+        case DFT_float: return 4;
+        default: return 8;
+        }
+    }
+
+    template<typename Out> double bench(char dataformat, const std::vector<char>& raw, std::size_t count,
+        bool need_swap, std::vector<Out>& target, int repeats)
+    {
+        using clock = std::chrono::steady_clock;
+        double best = 1e300;
+        for (int r = 0; r < repeats; ++r) {
+            auto t0 = clock::now();
+            ConvertSamples(dataformat, raw.data(), count, need_swap, 1.0 / 3276.8, target.data());
+            std::chrono::duration<double> dt = clock::now() - t0;
+            best = std::min(best, dt.count());
+        }
+        return double(raw.size()) / best * 1e-9;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t count = 1 << 22;
+    int repeats = 10;
+    if (argc > 1) {
+        count = std::stoul(argv[1]);
+    }
+    if (argc > 2) {
+        repeats = std::stoi(argv[2]);
+    }
+    if (count == 0 || repeats <= 0) {
+        std::cerr << "usage: " << argv[0] << " [<number of samples> [<repeats>]]\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto maxlevel = DetectSimdLevel();
+    std::cout << "detected instruction set: " << SimdLevelName(maxlevel) << '\n'
+        << "samples: " << count << ", throughput in GB/s of raw data (best of " << repeats << ")\n\n"
+        << "format\tswap\ttarget";
+    for (int l = 0; l <= int(maxlevel); ++l) {
+        std::cout << '\t' << SimdLevelName(SimdLevel(l));
+    }
+    std::cout << '\n';
+
+    std::mt19937_64 rng(42);
+    bool all_equal = true;
+    for (char fmt : { DFT_int16, DFT_int32, DFT_float, DFT_double }) {
+        // random bytes are fine for integers, floating point data is generated properly
+        std::vector<char> raw(count * sampleSize(fmt));
+        for (std::size_t i = 0; i < count; ++i) {
+            if (fmt == DFT_float) {
+                float x = float(rng() % 200001) / 1000.0f - 100.0f;
+                std::memcpy(raw.data() + i * 4, &x, 4);
+            }
+            else if (fmt == DFT_double) {
+                double x = double(rng() % 2000001) / 10000.0 - 100.0;
+                std::memcpy(raw.data() + i * 8, &x, 8);
+            }
+            else {
+                auto x = rng();
+                std::memcpy(raw.data() + i * sampleSize(fmt), &x, sampleSize(fmt));
+            }
+        }
+        for (bool swap : { false, true }) {
+            for (bool to_float : { false, true }) {
+                std::cout << formatName(fmt) << '\t' << (swap ? "yes" : "no") << '\t'
+                    << (to_float ? "float" : "double");
+                std::vector<double> ref_d, res_d(count);
+                std::vector<float> ref_f, res_f(count);
+                for (int l = 0; l <= int(maxlevel); ++l) {
+                    SetSimdLevel(SimdLevel(l));
+                    double gbs{};
+                    if (to_float) {
+                        gbs = bench(fmt, raw, count, swap, res_f, repeats);
+                        if (l == 0) ref_f = res_f;
+                        else all_equal = all_equal && std::memcmp(ref_f.data(), res_f.data(), count * sizeof(float)) == 0;
+                    }
+                    else {
+                        gbs = bench(fmt, raw, count, swap, res_d, repeats);
+                        if (l == 0) ref_d = res_d;
+                        else all_equal = all_equal && std::memcmp(ref_d.data(), res_d.data(), count * sizeof(double)) == 0;
+                    }
+                    std::cout << '\t' << gbs;
+                }
+                std::cout << '\n';
+            }
+        }
+    }
+    SetSimdLevel(maxlevel);
+    if (!all_equal) {
+        std::cerr << "error: results differ between instruction sets\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "\nall instruction sets yield identical results\n";
+    return EXIT_SUCCESS;
+}
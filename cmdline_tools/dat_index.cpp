@@ -0,0 +1,69 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// small tool to create (or refresh) the sidecar index (<file>.pmidx) of dat files,
+// e.g. for a whole archive, so PMbrowser and the other tools can open the files faster
+
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include "DatFile.h"
+#include "DatIndex.h"
+#include "MappedFile.h"
+
+using namespace hkLib;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <filename>.dat [<filename>.dat ...]\n"
+            "creates the index file <filename>.dat" << DatIndex::FileExtension << " unless it is up to date\n";
+        return EXIT_FAILURE;
+    }
+    int result = EXIT_SUCCESS;
+    for (int i = 1; i < argc; ++i) {
+        const std::filesystem::path path(argv[i]);
+        MappedFileStream infile(path);
+        if (!infile) {
+            std::cerr << "error opening file " << argv[i] << '\n';
+            result = EXIT_FAILURE;
+            continue;
+        }
+        try {
+            DatFile df;
+            if (df.InitFromStream(infile, path, IndexMode::Use)) {
+                std::cout << argv[i] << ": index is up to date\n";
+                continue;
+            }
+            DatIndex::FileStamp stamp;
+            if (!DatIndex::GetStamp(path, infile.rdbuf()->mappedData().first(BundleHeaderSize), stamp)) {
+                throw std::runtime_error("cannot determine size or modification time");
+            }
+            auto index = DatIndex::Create(df, infile, stamp);
+            index.Save(DatIndex::PathFor(path));
+            std::cout << argv[i] << ": indexed " << index.getTraces().size() << " traces\n";
+        }
+        catch (const std::exception& e) {
+            std::cerr << "error " << e.what() << " processing file " << argv[i] << '\n';
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,182 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// small tool to select traces of a dat file by labels and parameter values (see TreeQuery),
+// the matching traces are listed or exported as npy files (one array per series and trace, see NPYExportTreeSweepsAsArray)
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "DatFile.h"
+#include "MappedFile.h"
+#include "RecordFields.h"
+#include "TreeQuery.h"
+#include "exportNPY.h"
+#include "helpers.h"
+
+using namespace hkLib;
+
+namespace {
+    constexpr std::array<std::string_view, 5> LevelNames{ "root", "group", "series", "sweep", "trace" };
+
+    // parse number, empty string gives fallback
+    double toDouble(std::string_view s, double fallback)
+    {
+        if (s.empty()) {
+            return fallback;
+        }
+        std::size_t pos{};
+        const double v = std::stod(std::string(s), &pos);
+        if (pos != s.size()) {
+            throw std::invalid_argument("not a number: " + std::string(s));
+        }
+        return v;
+    }
+
+    bool isNumber(std::string_view s)
+    {
+        try {
+            toDouble(s, 0.0);
+            return !s.empty();
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // term is <level>.<name><op><value>, see usage
+    void addTerm(TreeQuery& query, std::string_view term)
+    {
+        const auto dot = term.find('.');
+        const auto op = term.find_first_of("=~", dot);
+        if (dot == std::string_view::npos || op == std::string_view::npos) {
+            throw std::invalid_argument("invalid term: " + std::string(term));
+        }
+        const auto level_name = term.substr(0, dot), name = term.substr(dot + 1, op - dot - 1), value = term.substr(op + 1);
+        int level = -1;
+        for (std::size_t l = 0; l < LevelNames.size(); ++l) {
+            if (LevelNames[l] == level_name) {
+                level = static_cast<int>(l);
+            }
+        }
+        if (level < 0) {
+            throw std::invalid_argument("unknown level: " + std::string(level_name));
+        }
+        if (term[op] == '~') {
+            if (name == "label") {
+                query.label(level, value);
+            }
+            else {
+                query.matches(level, name, value);
+            }
+            return;
+        }
+        constexpr auto inf = std::numeric_limits<double>::infinity();
+        const auto colon = value.find(':');
+        if (name == "time") {
+            if (colon == std::string_view::npos) {
+                throw std::invalid_argument("time window must be given as <t_start>:<t_end>");
+            }
+            query.timeWindow(level, toDouble(value.substr(0, colon), -inf), toDouble(value.substr(colon + 1), inf));
+        }
+        else if (colon != std::string_view::npos) {
+            query.range(level, name, toDouble(value.substr(0, colon), -inf), toDouble(value.substr(colon + 1), inf));
+        }
+        else if (isNumber(value)) {
+            query.equals(level, name, toDouble(value, 0.0));
+        }
+        else {
+            query.equals(level, name, value);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <filename>.dat [--npy <prefix>] <term> [<term> ...]\n"
+            "lists (or exports as npy files) the traces matching all terms, terms are\n"
+            "  <level>.label~<regex>        label (for traces the trace name) matches regex\n"
+            "  <level>.<param>~<regex>      text parameter matches regex\n"
+            "  <level>.<param>=<value>      parameter equals value (number or text)\n"
+            "  <level>.<param>=<min>:<max>  numeric parameter in range, a bound may be omitted\n"
+            "  <level>.time=<t0>:<t1>       series or sweep time (in s, relative to start of file) in [t0, t1)\n"
+            "with <level> one of root, group, series, sweep, trace and <param> a parameter name\n"
+            "as shown by PMbrowser, e.g. trace.Rs=20e6: (Rs >= 20 MOhm)\n";
+        return EXIT_FAILURE;
+    }
+    std::string npy_prefix;
+    TreeQuery query;
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string_view arg(argv[i]);
+            if (arg == "--npy" && i + 1 < argc) {
+                npy_prefix = argv[++i];
+            }
+            else {
+                addTerm(query, arg);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "error " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    MappedFileStream infile(argv[1]);
+    if (!infile) {
+        std::cerr << "error opening file " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+    DatFile df;
+    try {
+        df.InitFromStream(infile, argv[1], IndexMode::Use);
+        const auto selection = query.run(df.GetPulTree());
+        const auto traces = selection.GetNodeListForLevel(hkTreeNode::LevelTrace);
+        if (npy_prefix.empty()) {
+            // group, series, sweep and trace are counted from 1, as used by trace_slicer
+            for (const auto* trace : traces) {
+                const auto* sweep = trace->getParent();
+                const auto* series = sweep->getParent();
+                const auto* group = series->getParent();
+                auto index = [](const hkTreeNode* node) {
+                    const auto& siblings = node->getParent()->Children;
+                    return node - &siblings.at(0) + 1;
+                };
+                std::cout << index(group) << ' ' << index(series) << ' ' << index(sweep) << ' ' << index(trace)
+                    << '\t' << iso_8859_1_to_utf8(series->get(Series::Label)) << '\t'
+                    << formTraceName(*trace, trace->get(Trace::TraceID)) << '\n';
+            }
+        }
+        else {
+            NPYExportTreeSweepsAsArray(infile, selection, "./", npy_prefix, true);
+        }
+        std::cerr << traces.size() << " matching traces\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << "error " << e.what() << " processing file " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
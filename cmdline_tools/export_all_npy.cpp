@@ -22,14 +22,18 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include "DatFile.h"
+#include "MappedFile.h"
 #include "exportNPY.h"
 
 using namespace hkLib;
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "usage: " << argv[0] << " <filename>.dat [<prefix>]\n";
+        std::cerr << "usage: " << argv[0] << " <filename>.dat [<prefix> [<number of threads, 0: automatic>"
+            " [<data type: float64 | float32 | native> [manifest]]]]\n"
+            "with option manifest, metadata is written to a single JSON Lines file instead of one JSON file per trace\n";
         return EXIT_FAILURE;
     }
 
@@ -37,15 +41,30 @@ int main(int argc, char** argv) {
     if (argc > 2) {
         prefix = argv[2];
     }
-    std::ifstream infile(argv[1], std::ios::binary);
+    unsigned num_threads{ 0 };
+    if (argc > 3) {
+        num_threads = static_cast<unsigned>(std::stoul(argv[3]));
+    }
+    ExportDataType dtype{ ExportDataType::Float64 };
+    if (argc > 4) {
+        try {
+            dtype = ParseExportDataType(argv[4]);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "error " << e.what() << ": " << argv[4] << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    const bool manifest = argc > 5 && std::string_view(argv[5]) == "manifest";
+    MappedFileStream infile(argv[1]);
     if (!infile) {
         std::cerr << "error opening file " << argv[1] << '\n';
         return EXIT_FAILURE;
     }
     DatFile df;
     try {
-        df.InitFromStream(infile);
-        NPYExportAllTraces(infile, df, "./", prefix);
+        df.InitFromStream(infile, argv[1], IndexMode::Use);
+        NPYExportAllTraces(infile, df, "./", prefix, num_threads, dtype, manifest);
     }
     catch (const std::exception& e) {
         std::cerr << "error " << e.what() << " processing file " << argv[1] << '\n';
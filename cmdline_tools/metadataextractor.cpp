@@ -20,6 +20,7 @@
 #include<iostream>
 #include<fstream>
 #include"DatFile.h"
+#include"MappedFile.h"
 
 using namespace hkLib;
 
@@ -32,14 +33,14 @@ int main(int argc, char** argv) {
     if (argc > 2) {
         max_level = std::strtol(argv[2],nullptr,10);
     }
-    std::ifstream infile(argv[1], std::ios::binary);
+    MappedFileStream infile(argv[1]);
     if (!infile) {
         std::cerr << "error opening file " << argv[1] << '\n';
         return EXIT_FAILURE;
     }
     DatFile df;
     try {
-        df.InitFromStream(infile);
+        df.InitFromStream(infile, argv[1], IndexMode::Use);
 //        auto& pulsetree = df.GetPulTree();
         df.formatStimMetadataAsTableExport(std::cout, max_level);
     }catch(const std::exception& e) {
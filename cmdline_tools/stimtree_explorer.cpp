@@ -76,7 +76,7 @@ int main(int argc, char** argv) {
         std::cout << "pfg file detected\n";
         try {
             hkTree stimtree{};
-            stimtree.InitFromStream(".pgf", infile, 0, static_cast<int>(std::filesystem::file_size(inpath)));
+            stimtree.InitFromStream(".pgf", infile, 0, std::filesystem::file_size(inpath));
             do_exploring(stimtree.GetRootNode(), stim_index, ch_index);
         }
         catch (const std::exception& e) {
@@ -87,7 +87,7 @@ int main(int argc, char** argv) {
     else {
         DatFile df{};
         try {
-            df.InitFromStream(infile);
+            df.InitFromStream(infile, inpath, IndexMode::Use);
             auto& stimtree = df.GetPgfTree();
             do_exploring(stimtree.GetRootNode(), stim_index, ch_index);
         }
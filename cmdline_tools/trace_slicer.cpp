@@ -0,0 +1,116 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// small tool to write a time window of a trace to stdout as raw binary (native double)
+// only the data of the window is read from the file
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <string>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <stdio.h>
+#endif
+#include "DatFile.h"
+#include "MappedFile.h"
+#include "TraceChunkReader.h"
+
+using namespace hkLib;
+
+namespace {
+    // index of first sample at or after time t, clamped to [0, numpoints]
+    std::size_t sampleIndex(double t, double x0, double dx, std::size_t numpoints)
+    {
+        const double i = std::ceil((t - x0) / dx);
+        if (!(i > 0.0)) {
+            return 0;
+        }
+        return i >= double(numpoints) ? numpoints : static_cast<std::size_t>(i);
+    }
+
+    int usage(const char* name)
+    {
+        std::cerr << "usage: " << name << " <filename>.dat <group> <series> <sweep> <trace> <t_start> <t_end>\n"
+            << "writes samples with t_start <= t < t_end (in s) of the trace as raw binary (double) to stdout,\n"
+            << "group, series, sweep and trace are counted from 1, t_start and t_end must be finite with t_start <= t_end\n";
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 8) {
+        return usage(argv[0]);
+    }
+    double t_start{}, t_end{};
+    try {
+        t_start = std::stod(argv[6]);
+        t_end = std::stod(argv[7]);
+    }
+    catch (const std::exception&) {
+        return usage(argv[0]);
+    }
+    // nan would select the whole trace
+    if (!std::isfinite(t_start) || !std::isfinite(t_end) || t_end < t_start) {
+        return usage(argv[0]);
+    }
+    MappedFileStream infile(argv[1]);
+    if (!infile) {
+        std::cerr << "error opening file " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+    DatFile df;
+    try {
+        df.InitFromStream(infile, argv[1], IndexMode::Use);
+        const hkTreeNode* node = &df.GetPulTree().GetRootNode();
+        for (int arg = 2; arg < 6; ++arg) {
+            const auto index = std::stoul(argv[arg]);
+            if (index == 0) {
+                throw std::out_of_range("indices are counted from 1");
+            }
+            node = &node->Children.at(index - 1);
+        }
+        const double x0 = node->get(Trace::XStart), dx = node->get(Trace::XInterval);
+        TraceChunkReader reader(infile, *node);
+        const auto numpoints = reader.size();
+        const auto first = sampleIndex(t_start, x0, dx, numpoints);
+        const auto last = std::max(first, sampleIndex(t_end, x0, dx, numpoints));
+        reader.setRange(first, last);
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        while (!reader.done()) {
+            auto chunk = reader.next();
+            std::cout.write(reinterpret_cast<const char*>(chunk.data()), chunk.size_bytes());
+        }
+        std::cout.flush();
+        if (!std::cout) {
+            throw std::runtime_error("error writing output");
+        }
+        std::cerr << "wrote samples [" << first << ", " << last << ") of " << numpoints << '\n';
+    }
+    catch (const std::exception& e) {
+        std::cerr << "error " << e.what() << " processing file " << argv[1] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
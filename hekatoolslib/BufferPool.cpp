@@ -0,0 +1,135 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <bit>
+#include "BufferPool.h"
+
+namespace hkLib {
+
+    BufferPool& BufferPool::global()
+    {
+        static auto* pool = new BufferPool(); // intentionally leaked
+        return *pool;
+    }
+
+    BufferPool::Buffer BufferPool::acquire(std::size_t n)
+    {
+        if (n < MinPooledSize) {
+            return Buffer(n);
+        }
+        // class k may hold buffers with a capacity of at least n, all buffers in class k + 1 have
+        const std::size_t k = std::bit_width(n) - 1;
+        Buffer buf;
+        {
+            std::lock_guard lk(mtx);
+            std::vector<Buffer>* from = nullptr;
+            auto& list = idle[k];
+            auto it = std::find_if(list.rbegin(), list.rend(), [n](const Buffer& b) { return b.capacity() >= n; });
+            if (it != list.rend()) {
+                std::swap(*it, list.back());
+                from = &list;
+            }
+            else if (k + 1 < NumClasses && !idle[k + 1].empty()) {
+                from = &idle[k + 1];
+            }
+            if (from) {
+                buf = std::move(from->back());
+                from->pop_back();
+                bytes -= buf.capacity() * sizeof(double);
+                ++hits;
+            }
+            else {
+                ++misses;
+            }
+        }
+        if (buf.capacity() == 0) {
+            // exactly the requested size, rounding up would waste up to half of the memory
+            buf.reserve(n);
+        }
+        // idle buffers are kept filled to their capacity (see release), so for a reused
+        // buffer this only shrinks the size and does not overwrite its contents
+        buf.resize(n);
+        return buf;
+    }
+
+    void BufferPool::release(Buffer&& buf)
+    {
+        const auto capacity = buf.capacity();
+        if (capacity < MinPooledSize) {
+            buf = Buffer();
+            return;
+        }
+        // fill the unused tail (if any) once here instead of on every acquire
+        buf.resize(capacity);
+        const std::size_t k = std::bit_width(capacity) - 1;
+        std::lock_guard lk(mtx);
+        if (bytes + capacity * sizeof(double) > budget) {
+            buf = Buffer();
+            return;
+        }
+        idle[k].push_back(std::move(buf));
+        bytes += capacity * sizeof(double);
+    }
+
+    std::shared_ptr<const BufferPool::Buffer> BufferPool::share(Buffer&& buf)
+    {
+        return std::shared_ptr<const Buffer>(new Buffer(std::move(buf)), [this](Buffer* p) {
+            release(std::move(*p));
+            delete p;
+        });
+    }
+
+    void BufferPool::trim()
+    {
+        for (auto k = NumClasses; bytes > budget && k-- > 0;) {
+            while (bytes > budget && !idle[k].empty()) {
+                bytes -= idle[k].back().capacity() * sizeof(double);
+                idle[k].pop_back();
+            }
+        }
+    }
+
+    void BufferPool::clear()
+    {
+        std::lock_guard lk(mtx);
+        for (auto& list : idle) {
+            list.clear();
+        }
+        bytes = 0;
+    }
+
+    void BufferPool::setBudget(std::size_t budget_bytes)
+    {
+        std::lock_guard lk(mtx);
+        budget = budget_bytes;
+        trim();
+    }
+
+    BufferPool::Stats BufferPool::getStats() const
+    {
+        std::lock_guard lk(mtx);
+        std::size_t n = 0;
+        for (const auto& list : idle) {
+            n += list.size();
+        }
+        return { hits, misses, n, bytes, budget };
+    }
+}
@@ -0,0 +1,100 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hkLib {
+
+    /// <summary>
+    /// Thread-safe pool of std::vector<double> buffers, used for converted trace data.
+    /// Buffers are allocated with exactly the requested size and kept in size classes
+    /// (powers of two of their capacity), so a released buffer can serve any later request
+    /// of up to its capacity. When browsing or exporting, traces are mostly of similar length,
+    /// so after warming up no allocations are needed.
+    /// The total capacity of idle buffers is limited by a memory budget; buffers that would
+    /// exceed it, and small ones, are simply freed.
+    /// </summary>
+    class BufferPool {
+    public:
+        using Buffer = std::vector<double>;
+        static constexpr std::size_t DefaultBudget = std::size_t(64) << 20;
+        static constexpr std::size_t MinPooledSize = 1024; //!< smaller buffers are not worth pooling
+
+        struct Stats {
+            std::uint64_t hits{}, misses{};
+            std::size_t buffers{}, bytes{}, budget{};
+        };
+
+        explicit BufferPool(std::size_t budget_bytes = DefaultBudget) : budget{ budget_bytes } {};
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        /// <summary>
+        /// pool shared by the library and the applications, never destroyed,
+        /// so buffers can still be released during static destruction
+        /// </summary>
+        static BufferPool& global();
+
+        /// <summary>
+        /// get a buffer, reusing an idle one if possible
+        /// </summary>
+        /// <param name="n">number of elements</param>
+        /// <returns>vector of size n, contents are unspecified (a reused buffer is not cleared,
+        /// only newly allocated ones are zero-initialized)</returns>
+        Buffer acquire(std::size_t n);
+
+        /// <summary>
+        /// hand a buffer back to the pool, buf is left empty
+        /// </summary>
+        void release(Buffer&& buf);
+
+        /// <summary>
+        /// wrap buffer in a shared pointer that releases it to this pool when the last reference is gone,
+        /// the pool must outlive all copies of the pointer
+        /// </summary>
+        std::shared_ptr<const Buffer> share(Buffer&& buf);
+
+        void clear();
+        void setBudget(std::size_t budget_bytes);
+        Stats getStats() const;
+
+    private:
+        static constexpr std::size_t NumClasses = 64;
+        void trim(); // mtx must be locked
+
+        mutable std::mutex mtx;
+        std::array<std::vector<Buffer>, NumClasses> idle; // idle[k]: buffers with capacity in [2^k, 2^(k+1))
+        std::size_t budget;
+        std::size_t bytes{ 0 };
+        std::uint64_t hits{ 0 }, misses{ 0 };
+    };
+}
+
+#endif // !BUFFER_POOL_H
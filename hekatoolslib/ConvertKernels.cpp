@@ -0,0 +1,452 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "ConvertKernels.h"
+#include "hkTree.h"
+#include "helpers.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HK_CONVERT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define HK_TARGET(isa)
+#else
+#define HK_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace hkLib {
+
+    namespace {
+
+        template<typename T, typename Out> void convert_scalar(const char* source, std::size_t count,
+            bool need_swap, double datascaler, Out* target)
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                T x;
+                std::memcpy(&x, source + i * sizeof(T), sizeof(T));
+                if (need_swap) { x = swap_bytes(x); }
+                target[i] = static_cast<Out>(datascaler * x);
+            }
+        }
+
+#ifdef HK_CONVERT_X86
+        // Each kernel loads a block of raw samples, swaps bytes if needed, widens them
+        // to double (exact for all formats), multiplies by the scaler and stores the
+        // result as double or float. The remainder is handled by convert_scalar,
+        // which does exactly the same arithmetic, hence all kernels agree bit by bit.
+
+        namespace sse2 {
+            // 4 samples per block; SSE2 is part of the x86-64 baseline
+
+            inline __m128i bswap16(__m128i v)
+            {
+                return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            }
+            inline __m128i bswap32(__m128i v)
+            {
+                v = bswap16(v);
+                return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+            }
+            inline __m128i bswap64(__m128i v)
+            {
+                v = bswap16(v);
+                return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+            }
+            inline void int32_to_pd(__m128i w, __m128d& lo, __m128d& hi)
+            {
+                lo = _mm_cvtepi32_pd(w);
+                hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(w, 0xEE));
+            }
+            inline void load(int16_t*, const char* p, bool swap, __m128d& lo, __m128d& hi)
+            {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+                if (swap) v = bswap16(v);
+                int32_to_pd(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), lo, hi);
+            }
+            inline void load(int32_t*, const char* p, bool swap, __m128d& lo, __m128d& hi)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (swap) v = bswap32(v);
+                int32_to_pd(v, lo, hi);
+            }
+            inline void load(float*, const char* p, bool swap, __m128d& lo, __m128d& hi)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (swap) v = bswap32(v);
+                __m128 f = _mm_castsi128_ps(v);
+                lo = _mm_cvtps_pd(f);
+                hi = _mm_cvtps_pd(_mm_movehl_ps(f, f));
+            }
+            inline void load(double*, const char* p, bool swap, __m128d& lo, __m128d& hi)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+                if (swap) {
+                    a = bswap64(a);
+                    b = bswap64(b);
+                }
+                lo = _mm_castsi128_pd(a);
+                hi = _mm_castsi128_pd(b);
+            }
+            inline void store(double* d, __m128d lo, __m128d hi)
+            {
+                _mm_storeu_pd(d, lo);
+                _mm_storeu_pd(d + 2, hi);
+            }
+            inline void store(float* d, __m128d lo, __m128d hi)
+            {
+                _mm_storeu_ps(d, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+            }
+
+            template<typename T, typename Out> void convert(const char* source, std::size_t count,
+                bool need_swap, double datascaler, Out* target)
+            {
+                constexpr std::size_t block = 4;
+                const __m128d s = _mm_set1_pd(datascaler);
+                std::size_t i = 0;
+                for (; i + block <= count; i += block) {
+                    __m128d lo, hi;
+                    load(static_cast<T*>(nullptr), source + i * sizeof(T), need_swap, lo, hi);
+                    store(target + i, _mm_mul_pd(lo, s), _mm_mul_pd(hi, s));
+                }
+                convert_scalar<T>(source + i * sizeof(T), count - i, need_swap, datascaler, target + i);
+            }
+        }
+
+        namespace avx2 {
+            // 8 samples per block
+
+#define HK_AVX2 HK_TARGET("avx2")
+            HK_AVX2 inline __m256i bswap(__m256i v, int size)
+            {
+                const __m256i mask16 = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+                const __m256i mask32 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+                const __m256i mask64 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+                return _mm256_shuffle_epi8(v, size == 2 ? mask16 : size == 4 ? mask32 : mask64);
+            }
+            HK_AVX2 inline __m256i loadu(const char* p)
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+            HK_AVX2 inline void int32_to_pd(__m256i w, __m256d& lo, __m256d& hi)
+            {
+                lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(w));
+                hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(w, 1));
+            }
+            HK_AVX2 inline void load(int16_t*, const char* p, bool swap, __m256d& lo, __m256d& hi)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (swap) v = _mm256_castsi256_si128(bswap(_mm256_castsi128_si256(v), 2));
+                int32_to_pd(_mm256_cvtepi16_epi32(v), lo, hi);
+            }
+            HK_AVX2 inline void load(int32_t*, const char* p, bool swap, __m256d& lo, __m256d& hi)
+            {
+                __m256i v = loadu(p);
+                if (swap) v = bswap(v, 4);
+                int32_to_pd(v, lo, hi);
+            }
+            HK_AVX2 inline void load(float*, const char* p, bool swap, __m256d& lo, __m256d& hi)
+            {
+                __m256i v = loadu(p);
+                if (swap) v = bswap(v, 4);
+                __m256 f = _mm256_castsi256_ps(v);
+                lo = _mm256_cvtps_pd(_mm256_castps256_ps128(f));
+                hi = _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1));
+            }
+            HK_AVX2 inline void load(double*, const char* p, bool swap, __m256d& lo, __m256d& hi)
+            {
+                __m256i a = loadu(p), b = loadu(p + 32);
+                if (swap) {
+                    a = bswap(a, 8);
+                    b = bswap(b, 8);
+                }
+                lo = _mm256_castsi256_pd(a);
+                hi = _mm256_castsi256_pd(b);
+            }
+            HK_AVX2 inline void store(double* d, __m256d lo, __m256d hi)
+            {
+                _mm256_storeu_pd(d, lo);
+                _mm256_storeu_pd(d + 4, hi);
+            }
+            HK_AVX2 inline void store(float* d, __m256d lo, __m256d hi)
+            {
+                _mm_storeu_ps(d, _mm256_cvtpd_ps(lo));
+                _mm_storeu_ps(d + 4, _mm256_cvtpd_ps(hi));
+            }
+
+            template<typename T, typename Out> HK_AVX2 void convert(const char* source, std::size_t count,
+                bool need_swap, double datascaler, Out* target)
+            {
+                constexpr std::size_t block = 8;
+                const __m256d s = _mm256_set1_pd(datascaler);
+                std::size_t i = 0;
+                for (; i + block <= count; i += block) {
+                    __m256d lo, hi;
+                    load(static_cast<T*>(nullptr), source + i * sizeof(T), need_swap, lo, hi);
+                    store(target + i, _mm256_mul_pd(lo, s), _mm256_mul_pd(hi, s));
+                }
+                convert_scalar<T>(source + i * sizeof(T), count - i, need_swap, datascaler, target + i);
+            }
+#undef HK_AVX2
+        }
+
+#if defined(__GNUC__) && !defined(__clang__)
+        // GCC reports false positives for the undefined upper halves used inside the avx512 conversion intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+        namespace avx512 {
+            // 16 samples per block, byte swapping is done on 256 bit halves
+            // so that AVX512F suffices (no AVX512BW needed)
+
+#define HK_AVX512 HK_TARGET("avx512f,avx2")
+            HK_AVX512 inline __m256i loadu(const char* p, bool swap, int size)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                return swap ? avx2::bswap(v, size) : v;
+            }
+            HK_AVX512 inline void load(int16_t*, const char* p, bool swap, __m512d& lo, __m512d& hi)
+            {
+                __m512i w = _mm512_cvtepi16_epi32(loadu(p, swap, 2));
+                lo = _mm512_cvtepi32_pd(_mm512_castsi512_si256(w));
+                hi = _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(w, 1));
+            }
+            HK_AVX512 inline void load(int32_t*, const char* p, bool swap, __m512d& lo, __m512d& hi)
+            {
+                lo = _mm512_cvtepi32_pd(loadu(p, swap, 4));
+                hi = _mm512_cvtepi32_pd(loadu(p + 32, swap, 4));
+            }
+            HK_AVX512 inline void load(float*, const char* p, bool swap, __m512d& lo, __m512d& hi)
+            {
+                lo = _mm512_cvtps_pd(_mm256_castsi256_ps(loadu(p, swap, 4)));
+                hi = _mm512_cvtps_pd(_mm256_castsi256_ps(loadu(p + 32, swap, 4)));
+            }
+            HK_AVX512 inline __m512d combine(__m256i a, __m256i b)
+            {
+                return _mm512_castsi512_pd(_mm512_inserti64x4(_mm512_zextsi256_si512(a), b, 1));
+            }
+            HK_AVX512 inline void load(double*, const char* p, bool swap, __m512d& lo, __m512d& hi)
+            {
+                lo = combine(loadu(p, swap, 8), loadu(p + 32, swap, 8));
+                hi = combine(loadu(p + 64, swap, 8), loadu(p + 96, swap, 8));
+            }
+            HK_AVX512 inline void store(double* d, __m512d lo, __m512d hi)
+            {
+                _mm512_storeu_pd(d, lo);
+                _mm512_storeu_pd(d + 8, hi);
+            }
+            HK_AVX512 inline void store(float* d, __m512d lo, __m512d hi)
+            {
+                _mm256_storeu_ps(d, _mm512_cvtpd_ps(lo));
+                _mm256_storeu_ps(d + 8, _mm512_cvtpd_ps(hi));
+            }
+
+            template<typename T, typename Out> HK_AVX512 void convert(const char* source, std::size_t count,
+                bool need_swap, double datascaler, Out* target)
+            {
+                constexpr std::size_t block = 16;
+                const __m512d s = _mm512_set1_pd(datascaler);
+                std::size_t i = 0;
+                for (; i + block <= count; i += block) {
+                    __m512d lo, hi;
+                    load(static_cast<T*>(nullptr), source + i * sizeof(T), need_swap, lo, hi);
+                    store(target + i, _mm512_mul_pd(lo, s), _mm512_mul_pd(hi, s));
+                }
+                convert_scalar<T>(source + i * sizeof(T), count - i, need_swap, datascaler, target + i);
+            }
+#undef HK_AVX512
+        }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+        SimdLevel detect()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            const int max_leaf = info[0];
+            __cpuid(info, 1);
+            const bool osxsave = info[2] & (1 << 27), avx = info[2] & (1 << 28);
+            if (!(osxsave && avx) || max_leaf < 7) return SimdLevel::SSE2;
+            const auto xcr0 = _xgetbv(0);
+            if ((xcr0 & 0x6) != 0x6) return SimdLevel::SSE2; // OS does not save YMM state
+            __cpuidex(info, 7, 0);
+            const bool avx2 = info[1] & (1 << 5), avx512f = info[1] & (1 << 16);
+            if (avx512f && avx2 && (xcr0 & 0xe6) == 0xe6) return SimdLevel::AVX512;
+            return avx2 ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+            // libgcc also checks that the OS saves the extended register state
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")) return SimdLevel::AVX512;
+            if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+            return SimdLevel::SSE2;
+#endif
+        }
+#else
+        SimdLevel detect()
+        {
+            return SimdLevel::Scalar;
+        }
+#endif // HK_CONVERT_X86
+
+        template<typename Out> using ConvertFunc = void (*)(const char*, std::size_t, bool, double, Out*);
+
+        /// <summary>
+        /// table of conversion functions for one instruction set,
+        /// indexed by data format (DFT_int16 ... DFT_double)
+        /// </summary>
+        struct KernelTable {
+            ConvertFunc<double> toDouble[4];
+            ConvertFunc<float> toFloat[4];
+        };
+
+        template<template<typename, typename> class K> constexpr KernelTable makeTable()
+        {
+            return {
+                { K<int16_t, double>::f, K<int32_t, double>::f, K<float, double>::f, K<double, double>::f },
+                { K<int16_t, float>::f, K<int32_t, float>::f, K<float, float>::f, K<double, float>::f }
+            };
+        }
+
+        template<typename T, typename Out> struct ScalarKernel {
+            static void f(const char* s, std::size_t n, bool sw, double sc, Out* t)
+            {
+                convert_scalar<T>(s, n, sw, sc, t);
+            }
+        };
+#ifdef HK_CONVERT_X86
+        template<typename T, typename Out> struct SSE2Kernel {
+            static void f(const char* s, std::size_t n, bool sw, double sc, Out* t)
+            {
+                sse2::convert<T>(s, n, sw, sc, t);
+            }
+        };
+        template<typename T, typename Out> struct AVX2Kernel {
+            static void f(const char* s, std::size_t n, bool sw, double sc, Out* t)
+            {
+                avx2::convert<T>(s, n, sw, sc, t);
+            }
+        };
+        template<typename T, typename Out> struct AVX512Kernel {
+            static void f(const char* s, std::size_t n, bool sw, double sc, Out* t)
+            {
+                avx512::convert<T>(s, n, sw, sc, t);
+            }
+        };
+#endif
+
+        const KernelTable* tableFor(SimdLevel level)
+        {
+            static constexpr KernelTable scalar = makeTable<ScalarKernel>();
+#ifdef HK_CONVERT_X86
+            static constexpr KernelTable sse2 = makeTable<SSE2Kernel>(),
+                avx2 = makeTable<AVX2Kernel>(), avx512 = makeTable<AVX512Kernel>();
+            switch (level) {
+            case SimdLevel::SSE2:
+                return &sse2;
+            case SimdLevel::AVX2:
+                return &avx2;
+            case SimdLevel::AVX512:
+                return &avx512;
+            default:
+                break;
+            }
+#endif
+            (void)level;
+            return &scalar;
+        }
+
+        struct Dispatch {
+            SimdLevel level;
+            const KernelTable* table;
+            Dispatch() : level{ DetectSimdLevel() }, table{ tableFor(level) } {}
+        };
+
+        Dispatch& dispatch()
+        {
+            static Dispatch d;
+            return d;
+        }
+
+        int formatIndex(char dataformat)
+        {
+            if (dataformat < DFT_int16 || dataformat > DFT_double) {
+                throw std::runtime_error("unknown data format type");
+            }
+            return dataformat - DFT_int16;
+        }
+    }
+
+    SimdLevel DetectSimdLevel()
+    {
+        static const SimdLevel level = detect();
+        return level;
+    }
+
+    SimdLevel GetSimdLevel()
+    {
+        return dispatch().level;
+    }
+
+    SimdLevel SetSimdLevel(SimdLevel level)
+    {
+        auto& d = dispatch();
+        d.level = std::min(level, DetectSimdLevel());
+        d.table = tableFor(d.level);
+        return d.level;
+    }
+
+    const char* SimdLevelName(SimdLevel level)
+    {
+        switch (level) {
+        case SimdLevel::Scalar:
+            return "scalar";
+        case SimdLevel::SSE2:
+            return "SSE2";
+        case SimdLevel::AVX2:
+            return "AVX2";
+        case SimdLevel::AVX512:
+            return "AVX-512";
+        default:
+            return "unknown";
+        }
+    }
+
+    void ConvertSamples(char dataformat, const char* source, std::size_t count, bool need_swap,
+        double datascaler, double* target)
+    {
+        dispatch().table->toDouble[formatIndex(dataformat)](source, count, need_swap, datascaler, target);
+    }
+
+    void ConvertSamples(char dataformat, const char* source, std::size_t count, bool need_swap,
+        double datascaler, float* target)
+    {
+        dispatch().table->toFloat[formatIndex(dataformat)](source, count, need_swap, datascaler, target);
+    }
+}
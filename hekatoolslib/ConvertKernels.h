@@ -0,0 +1,88 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * Kernels that convert raw trace data (int16, int32, float or double,
+ * in either byte order) to double or float in one pass:
+ * byte-swap, scale and convert.
+ * On x86-64 vectorized versions (SSE2, AVX2, AVX-512) are selected at runtime.
+ * All versions produce bit-identical results, since the scaling is always
+ * done in double precision (and for float targets rounded once).
+ */
+
+#ifndef CONVERT_KERNELS_H
+#define CONVERT_KERNELS_H
+
+#pragma once
+
+#include <cstddef>
+
+namespace hkLib {
+
+    enum class SimdLevel {
+        Scalar = 0,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+
+    /// <summary>
+    /// highest instruction set supported by CPU (and OS) that we have kernels for
+    /// </summary>
+    SimdLevel DetectSimdLevel();
+
+    /// <summary>
+    /// instruction set currently used by ConvertSamples()
+    /// </summary>
+    SimdLevel GetSimdLevel();
+
+    /// <summary>
+    /// Select instruction set used by ConvertSamples(), mainly for benchmarking and testing.
+    /// Levels not supported by the CPU are reduced to the highest supported level.
+    /// Not thread-safe, must not be called while conversions are running.
+    /// </summary>
+    /// <param name="level">requested level</param>
+    /// <returns>level actually selected</returns>
+    SimdLevel SetSimdLevel(SimdLevel level);
+
+    const char* SimdLevelName(SimdLevel level);
+
+    /// <summary>
+    /// byte-swap (if needed), scale and convert raw samples to double,
+    /// target[i] = datascaler * source[i]
+    /// </summary>
+    /// <param name="dataformat">format of raw data (DFT_int16, DFT_int32, DFT_float or DFT_double)</param>
+    /// <param name="source">raw data, needn't be aligned; may also lie at the tail of target
+    /// (ending where target ends), i.e. conversion can be done in place</param>
+    /// <param name="count">number of samples</param>
+    /// <param name="need_swap">true if byte order of raw data differs from machine byte order</param>
+    /// <param name="datascaler">scaling factor</param>
+    /// <param name="target">buffer receiving count doubles</param>
+    void ConvertSamples(char dataformat, const char* source, std::size_t count, bool need_swap,
+        double datascaler, double* target);
+
+    /// <summary>
+    /// byte-swap (if needed), scale and convert raw samples to float,
+    /// target[i] = float(datascaler * source[i]), the product is calculated in double precision
+    /// </summary>
+    void ConvertSamples(char dataformat, const char* source, std::size_t count, bool need_swap,
+        double datascaler, float* target);
+}
+
+#endif // !CONVERT_KERNELS_H
@@ -25,25 +25,121 @@
 #include <cassert>
 #include <cinttypes>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
 #include "time_handling.h"
 #include "helpers.h"
 #include "DatFile.h"
 #include "machineinfo.h"
 #include "PMparameters.h"
+#include "TraceView.h"
+#include "TreeByteOrder.h"
 #include <iomanip>
 
 using namespace hkLib;
 
+namespace {
+    void ReadBundleHeader(std::istream& infile, BundleHeader& bh)
+    {
+        if (!infile) {
+            throw std::runtime_error("cannot access file");
+        }
+        infile.read(reinterpret_cast<char*>(&bh), BundleHeaderSize);
+        if (!infile) {
+            throw std::runtime_error("cannot read file");
+        }
+    }
+
+    void ReadBundleHeader(const PositionalReader& reader, BundleHeader& bh)
+    {
+        if (reader.size() < BundleHeaderSize) {
+            throw std::runtime_error("cannot read file");
+        }
+        reader.read(0, reinterpret_cast<char*>(&bh), BundleHeaderSize);
+    }
+
+    std::uint64_t FileSize(std::istream& infile)
+    {
+        if (const auto* mapped = getMappedFileBuf(infile)) {
+            return mapped->mappedData().size();
+        }
+        const auto pos = infile.tellg();
+        const auto end = infile.seekg(0, std::ios::end).tellg();
+        infile.seekg(pos);
+        if (!infile || end < 0) {
+            throw std::runtime_error("cannot determine file size");
+        }
+        return static_cast<std::uint64_t>(end);
+    }
+
+    std::uint64_t FileSize(const PositionalReader& reader)
+    {
+        return reader.size();
+    }
+
+    // check that [offset, offset + len) lies within the file
+    bool InFile(std::uint64_t offset, std::uint64_t len, std::uint64_t filesize)
+    {
+        return offset <= filesize && len <= filesize - offset;
+    }
+}
+
 void DatFile::InitFromStream(std::istream& infile)
 {
-    if (!infile) {
-        throw std::runtime_error("cannot access file");
-    }
+    InitFromBundle(infile);
+}
+
+void DatFile::InitFromStream(const PositionalReader& reader)
+{
+    InitFromBundle(reader);
+}
+
+bool DatFile::InitFromStream(std::istream& infile, const std::filesystem::path& path, IndexMode mode)
+{
+    return InitFromBundle(infile, &path, mode);
+}
+
+bool DatFile::InitFromStream(const PositionalReader& reader, const std::filesystem::path& path, IndexMode mode)
+{
+    return InitFromBundle(reader, &path, mode);
+}
+
+template<typename Source> bool DatFile::InitFromBundle(Source& infile, const std::filesystem::path* path, IndexMode mode)
+{
+    traceCache.clear();
+    traceStats.clear();
+    indexStamp.reset();
     auto bh = std::make_unique<BundleHeader>();
-    infile.read(reinterpret_cast<char*>(bh.get()), BundleHeaderSize);
-    if (!infile) {
-        throw std::runtime_error("cannot read file");
+    ReadBundleHeader(infile, *bh);
+
+    // the stamp must be taken before any fields of the header are byte-swapped
+    DatIndex::FileStamp stamp{};
+    const bool have_stamp = path && mode != IndexMode::None
+        && DatIndex::GetStamp(*path, std::span(reinterpret_cast<const char*>(bh.get()), BundleHeaderSize), stamp);
+    std::optional<DatIndex> index;
+    if (have_stamp) {
+        index = DatIndex::Load(DatIndex::PathFor(*path), stamp);
     }
+    const auto filesize = FileSize(infile);
+    auto initTree = [&](hkTree& tree, const char* ext, const BundleItem& item) {
+        if (!InFile(item.Start, item.Length, filesize)) {
+            return false;
+        }
+        if (index) {
+            try {
+                if (tree.InitFromStream(ext, infile, item.Start, item.Length, index->getLayout(ext))
+                    && (&tree != &PulTree || index->matches(tree))) {
+                    return true;
+                }
+            }
+            catch (const std::runtime_error&) {
+                // layout doesn't fit, fall back to parsing
+            }
+            index.reset();
+        }
+        return tree.InitFromStream(ext, infile, item.Start, item.Length);
+    };
 
     bool isValid = std::memcmp(bh->Signature, BundleSignature, 8) == 0;
     if (!isValid) {
@@ -80,20 +176,20 @@ void DatFile::InitFromStream(std::istream& infile)
         if (std::strcmp(item.Extension, ExtDat) == 0) {
             offsetDat = item.Start;
             lenDat = item.Length;
-            if (offsetDat < 0 || lenDat <= 0) throw std::runtime_error("invalid data offset or length");
+            if (!InFile(offsetDat, lenDat, filesize)) throw std::runtime_error("invalid data offset or length");
         }
         else if (std::strcmp(item.Extension, ExtPul) == 0) {
             // process pulse tree
-            res = PulTree.InitFromStream(ExtPul, infile, item.Start, item.Length);
+            res = initTree(PulTree, ExtPul, item);
             PulTree.GetRootNode().setAsTime0();
         }
         else if (std::strcmp(item.Extension, ExtPgf) == 0) {
             // process pgf tree
-            res = PgfTree.InitFromStream(ExtPgf, infile, item.Start, item.Length);
+            res = initTree(PgfTree, ExtPgf, item);
         }
         else if (std::strcmp(item.Extension, ExtAmp) == 0) {
             // process amp tree
-            res = AmpTree.InitFromStream(ExtAmp, infile, item.Start, item.Length);
+            res = initTree(AmpTree, ExtAmp, item);
         }
         if (!res) {
             throw std::runtime_error("error processing tree");
@@ -103,11 +199,68 @@ void DatFile::InitFromStream(std::istream& infile)
     if (lenDat == 0) throw std::runtime_error("no data in file");
     if (!PulTree.isValid()) throw std::runtime_error("no valid Pulse tree in file");
     if (!PgfTree.isValid())throw std::runtime_error("no valid Pgf in file");
+    MakeTreesNative();
+
+    const bool from_index = index.has_value();
+    if (!index && have_stamp && mode == IndexMode::UseOrCreate) {
+        index = DatIndex::Create(*this, infile, stamp);
+        try {
+            index->Save(DatIndex::PathFor(*path));
+        }
+        catch (const std::runtime_error&) {
+            // the index is only a cache, we can do without
+        }
+    }
+    if (!index && have_stamp && mode == IndexMode::Use) {
+        indexPath = DatIndex::PathFor(*path);
+        indexStamp = stamp;
+    }
+    if (index) {
+        const auto entries = index->getTraces();
+        traceStats.reserve(entries.size());
+        for (const auto& entry : entries) {
+            traceStats.push_back(entry.stats);
+        }
+    }
+    return from_index;
+}
+
+bool DatFile::CreateIndex(const PositionalReader& reader, std::stop_token stop)
+{
+    if (!indexStamp) {
+        return false;
+    }
+    const auto index = DatIndex::Create(*this, reader, *indexStamp, stop);
+    if (!index) {
+        return false;
+    }
+    try {
+        index->Save(indexPath);
+    }
+    catch (const std::runtime_error&) {
+        // the index is only a cache, we can do without
+        return false;
+    }
+    return true;
+}
+
+const TraceStats* DatFile::GetTraceStats(const hkTreeNode& TrRecord)
+{
+    const auto traces = PulTree.GetLevelNodes(hkTreeNode::LevelTrace);
+    const std::less<const hkTreeNode*> before;
+    if (traceStats.size() != traces.size() || traces.empty()
+        || before(&TrRecord, traces.data()) || !before(&TrRecord, traces.data() + traces.size())) {
+        return nullptr;
+    }
+    return &traceStats[&TrRecord - traces.data()];
 }
 
 void hkLib::DatFile::InitFromStream(std::istream& infile, std::istream& pulstream, std::uintmax_t pullength, std::istream& pgfstream,
     std::uintmax_t pgflength, std::istream* ampstream, std::uintmax_t amplength)
 {
+    traceCache.clear();
+    traceStats.clear();
+    indexStamp.reset();
     if (!infile) {
         throw std::runtime_error("cannot access file");
     }
@@ -127,17 +280,31 @@ void hkLib::DatFile::InitFromStream(std::istream& infile, std::istream& pulstrea
             swapInPlace(Time);
         }
     }
-    if(!PulTree.InitFromStream(ExtPul, pulstream, 0, static_cast<unsigned int>(pullength))){
+    if(!PulTree.InitFromStream(ExtPul, pulstream, 0, pullength)){
         throw std::runtime_error("error processing pulse tree");
 	}
-    if (!PgfTree.InitFromStream(ExtPgf, pgfstream, 0, static_cast<unsigned int>(pgflength))) {
+    if (!PgfTree.InitFromStream(ExtPgf, pgfstream, 0, pgflength)) {
         throw std::runtime_error("error processing pgf tree");
     }
     if (ampstream && amplength) {
-        if (!AmpTree.InitFromStream(ExtAmp, *ampstream, 0, static_cast<unsigned int>(amplength))) {
+        if (!AmpTree.InitFromStream(ExtAmp, *ampstream, 0, amplength)) {
             throw std::runtime_error("error processing amp tree");
 		}
     }
+    MakeTreesNative();
+}
+
+void DatFile::MakeTreesNative()
+{
+    // one-time conversion of swapped trees, so that field accesses need not swap bytes
+    if (!convertTrees) {
+        return;
+    }
+    for (auto* tree : { &PulTree, &PgfTree, &AmpTree }) {
+        if (tree->isValid()) {
+            MakeNativeByteOrder(*tree);
+        }
+    }
 }
 
 std::string DatFile::getFileDate() const
@@ -164,55 +331,75 @@ void DatFile::formatStimMetadataAsTableExport(std::ostream& os, int max_level)
         throw std::runtime_error("max_level exceeds LevelTrace(=4)");
     }
     os << std::setprecision(10);
-    auto& rootnode = GetPulTree().GetRootNode();
     metadataCreateTableHeader(os);
-    for (const auto& grp : rootnode.Children) {
-        auto gpr_count = grp.extractValue<std::int32_t>(GrGroupCount);
-        std::string grp_entry = formatParamListExportTable(grp, parametersGroup);
-        for (const auto& series : grp.Children) {
-            auto se_count = series.extractValue<std::int32_t>(SeSeriesCount);
-            std::string se_entry = formatParamListExportTable(series, parametersSeries);
-            for (const auto& sweep : series.Children) {
-                auto sw_count = sweep.extractValue<std::int32_t>(SwSweepCount);
-                std::string sw_entry = formatParamListExportTable(sweep, parametersSweep);
-                for (const auto& trace : sweep.Children) {
-                    auto tr_count = trace.extractValue<std::int32_t>(TrTraceCount);
-                    std::string tr_entry = formatParamListExportTable(trace, parametersTrace);
-                    os << gpr_count << '\t' << se_count << '\t' << sw_count << '\t'
-                        << tr_count  <<
-                        grp_entry 
-                        << se_entry << sw_entry << tr_entry << '\n';
-                    if (max_level < hkTreeNode::LevelTrace) break;
-                }
-                if (max_level < hkTreeNode::LevelSweep) break;
-            }
-            if (max_level < hkTreeNode::LevelSeries) break;
+    // One line per node of level max_level, for lower levels only the first child is used.
+    // All nodes of a level are stored contiguously, thus we can simply scan them,
+    // parent entries are only formatted when the parent changes.
+    const hkTreeNode* last_grp{}, * last_series{}, * last_sweep{};
+    std::int32_t gpr_count{}, se_count{}, sw_count{};
+    std::string grp_entry, se_entry, sw_entry, tr_entry;
+    const ParamFormatPlan grp_plan(parametersGroup), se_plan(parametersSeries),
+        sw_plan(parametersSweep), tr_plan(parametersTrace);
+    const auto loc = os.getloc();
+    for (const auto& node : GetPulTree().GetLevelNodes(max_level)) {
+        const hkTreeNode* p_trace = &node;
+        while (p_trace && p_trace->getLevel() < hkTreeNode::LevelTrace) {
+            p_trace = p_trace->Children.empty() ? nullptr : &p_trace->Children[0];
         }
-        if (max_level < hkTreeNode::LevelGroup) break;
+        if (!p_trace) continue;
+        const auto& trace = *p_trace;
+        const auto& sweep = *trace.getParent();
+        const auto& series = *sweep.getParent();
+        const auto& grp = *series.getParent();
+        if (&grp != last_grp) {
+            gpr_count = grp.get(Group::GroupCount);
+            grp_entry.clear();
+            grp_plan.appendTable(grp, grp_entry, loc);
+            last_grp = &grp;
+        }
+        if (&series != last_series) {
+            se_count = series.get(Series::SeriesCount);
+            se_entry.clear();
+            se_plan.appendTable(series, se_entry, loc);
+            last_series = &series;
+        }
+        if (&sweep != last_sweep) {
+            sw_count = sweep.get(Sweep::SweepCount);
+            sw_entry.clear();
+            sw_plan.appendTable(sweep, sw_entry, loc);
+            last_sweep = &sweep;
+        }
+        auto tr_count = trace.get(Trace::TraceID);
+        tr_entry.clear();
+        tr_plan.appendTable(trace, tr_entry, loc);
+        os << gpr_count << '\t' << se_count << '\t' << sw_count << '\t'
+            << tr_count <<
+            grp_entry
+            << se_entry << sw_entry << tr_entry << '\n';
     }
 }
 
 double DatFile::getTraceHolding(const hkTreeNode& trace, std::string& unit)
 {
     assert(trace.getLevel() == hkTreeNode::LevelTrace);
-    double holding = trace.extractLongRealNoThrow(TrTrHolding);
-    int mode = trace.getChar(TrRecordingMode);
+    double holding = trace.get(Trace::Holding, std::numeric_limits<double>::quiet_NaN());
+    int mode = trace.get(Trace::RecordingMode);
     unit = "V";
     if (mode == CClamp) {
         unit = "A";
     }
     if (std::isnan(holding)) {
         // we can also try to get this info from the stim tree (usuful for old files):
-        auto linkedDAchannel = trace.extractValue<std::int32_t>(TrLinkDAChannel) - 1;
+        auto linkedDAchannel = trace.get(Trace::LinkDAChannel) - 1;
         assert(linkedDAchannel >= 0);
         const auto& sweep_record = *trace.getParent();
-        int stim_index = sweep_record.extractValue<std::int32_t>(SwStimCount) - 1;
+        int stim_index = sweep_record.get(Sweep::StimCount) - 1;
         const auto& stim_node = GetPgfTree().GetRootNode().Children.at(stim_index);
         const auto& channel0_record = stim_node.Children.at(linkedDAchannel);
-        int linked_channel = channel0_record.extractInt32(chLinkedChannel) - 1;
+        int linked_channel = channel0_record.get(Channel::LinkedChannel) - 1;
         const auto& stimchannel_record = stim_node.Children.at(linked_channel);
-        unit = stimchannel_record.getString(chDacUnit);
-        holding = stimchannel_record.extractLongRealNoThrow(chHolding);
+        unit = stimchannel_record.get(Channel::DacUnit);
+        holding = stimchannel_record.get(Channel::Holding, std::numeric_limits<double>::quiet_NaN());
         if (unit == "A") {
             holding *= 1e-6; // for some strange reason this is in microA
         }
@@ -223,3 +410,369 @@ double DatFile::getTraceHolding(const hkTreeNode& trace, std::string& unit)
     }
     return holding;
 }
+
+std::span<const char> hkLib::GetContiguousRawTraceData(std::span<const char> filedata, const hkTreeNode& TrRecord,
+    std::size_t nbytes)
+{
+    if (TrRecord.get(Trace::InterleaveSize, 0) != 0) {
+        return {};
+    }
+    const auto trdata = TraceDataOffset(TrRecord);
+    if (!InFile(trdata, nbytes, filedata.size())) {
+        throw std::runtime_error("error while reading datafile");
+    }
+    return filedata.subspan(static_cast<std::size_t>(trdata), nbytes);
+}
+
+namespace {
+    /// <summary>
+    /// raw data of one trace to be read, offsets and sizes in bytes
+    /// </summary>
+    struct RawTraceRequest {
+        std::size_t start; // file offset of 1st block
+        std::size_t nbytes; // total size of trace data
+        char* target;
+    };
+
+    std::size_t checkedOffset(const hkTreeNode& TrRecord)
+    {
+        const auto trdata = TraceDataOffset(TrRecord);
+        if (!std::in_range<std::size_t>(trdata)) {
+            throw std::runtime_error("error while reading datafile");
+        }
+        return static_cast<std::size_t>(trdata);
+    }
+
+    /// <summary>
+    /// size of interleave blocks and distance from block-start to block-start,
+    /// contiguous data is treated as a single block
+    /// </summary>
+    std::pair<std::size_t, std::size_t> getInterleave(const hkTreeNode& TrRecord, std::size_t nbytes)
+    {
+        int32_t interleavesize = TrRecord.get(Trace::InterleaveSize, 0),
+            interleaveskip = TrRecord.get(Trace::InterleaveSkip, 0);
+        if (interleavesize == 0) {
+            return { nbytes, nbytes };
+        }
+        if (interleavesize < 0 || interleaveskip < interleavesize) {
+            throw std::runtime_error("invalid interleave size or skip");
+        }
+        return { std::size_t(interleavesize), std::size_t(interleaveskip) };
+    }
+
+    /// <summary>
+    /// Gather the blocks of one or more interleaved traces that share the same interleave pattern.
+    /// The file is processed in chunks of whole blocks; for each chunk the file span covering the
+    /// blocks of all traces is requested by a single call of fetch(pos, len), which must
+    /// return a pointer to len bytes of file data starting at pos.
+    /// </summary>
+    template<typename Fetch> void GatherInterleaved(std::span<const RawTraceRequest> reqs,
+        std::size_t blocksize, std::size_t blockskip, Fetch&& fetch)
+    {
+        // aim for about 1 MiB of file data per chunk
+        constexpr std::size_t chunk_target = std::size_t(1) << 20;
+        const std::size_t blocks_per_chunk = std::max<std::size_t>(1, chunk_target / blockskip);
+        std::size_t nblocks = 0;
+        for (const auto& r : reqs) {
+            nblocks = std::max(nblocks, (r.nbytes + blocksize - 1) / blocksize);
+        }
+        for (std::size_t k0 = 0; k0 < nblocks; k0 += blocks_per_chunk) {
+            const std::size_t k1 = std::min(nblocks, k0 + blocks_per_chunk);
+            // file span needed for blocks [k0, k1) of all traces
+            std::size_t begin = SIZE_MAX, end = 0;
+            for (const auto& r : reqs) {
+                if (k0 * blocksize >= r.nbytes) continue;
+                const std::size_t klast = std::min(k1, (r.nbytes + blocksize - 1) / blocksize) - 1;
+                begin = std::min(begin, r.start + k0 * blockskip);
+                end = std::max(end, r.start + klast * blockskip + std::min(blocksize, r.nbytes - klast * blocksize));
+            }
+            const char* chunk = fetch(begin, end - begin);
+            for (const auto& r : reqs) {
+                for (std::size_t k = k0; k < k1 && k * blocksize < r.nbytes; ++k) {
+                    std::memcpy(r.target + k * blocksize, chunk + (r.start + k * blockskip - begin),
+                        std::min(blocksize, r.nbytes - k * blocksize));
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Gather the bytes [first_byte, first_byte + nbytes) of the raw data of an interleaved trace
+    /// starting at file offset start. The range may begin and end anywhere within a block.
+    /// Like GatherInterleaved, the file is processed in chunks of whole blocks,
+    /// fetch(pos, len) is called once per chunk.
+    /// </summary>
+    template<typename Fetch> void GatherRange(std::size_t start, std::size_t blocksize, std::size_t blockskip,
+        std::size_t first_byte, std::size_t nbytes, char* target, Fetch&& fetch)
+    {
+        constexpr std::size_t chunk_target = std::size_t(1) << 20;
+        const std::size_t blocks_per_chunk = std::max<std::size_t>(1, chunk_target / blockskip);
+        const std::size_t end_byte = first_byte + nbytes;
+        std::size_t pos = first_byte;
+        while (pos < end_byte) {
+            const std::size_t k0 = pos / blocksize;
+            const std::size_t chunk_end = std::min(end_byte, (k0 + blocks_per_chunk) * blocksize);
+            const std::size_t k1 = (chunk_end - 1) / blocksize; // last block of chunk
+            const std::size_t begin = start + k0 * blockskip + (pos - k0 * blocksize);
+            const std::size_t end = start + k1 * blockskip + (chunk_end - k1 * blocksize);
+            const char* chunk = fetch(begin, end - begin);
+            for (std::size_t k = k0; k <= k1; ++k) {
+                const std::size_t lo = std::max(pos, k * blocksize), hi = std::min(chunk_end, (k + 1) * blocksize);
+                std::memcpy(target + (lo - first_byte), chunk + (start + k * blockskip + (lo - k * blocksize) - begin), hi - lo);
+            }
+            pos = chunk_end;
+        }
+    }
+
+    void GatherInterleaved(std::istream& datafile, std::span<const RawTraceRequest> reqs,
+        std::size_t blocksize, std::size_t blockskip)
+    {
+        if (const auto* mapped = getMappedFileBuf(datafile)) {
+            auto filedata = mapped->mappedData();
+            GatherInterleaved(reqs, blocksize, blockskip, [&](std::size_t pos, std::size_t len) {
+                if (pos > filedata.size() || len > filedata.size() - pos) {
+                    throw std::runtime_error("error while reading datafile");
+                }
+                return filedata.data() + pos;
+            });
+        }
+        else {
+            std::vector<char> buffer;
+            GatherInterleaved(reqs, blocksize, blockskip, [&](std::size_t pos, std::size_t len) {
+                buffer.resize(len);
+                datafile.seekg(pos).read(buffer.data(), len);
+                if (!datafile) {
+                    throw std::runtime_error("error while reading datafile");
+                }
+                return buffer.data();
+            });
+        }
+    }
+
+    void GatherInterleaved(const PositionalReader& reader, std::span<const RawTraceRequest> reqs,
+        std::size_t blocksize, std::size_t blockskip)
+    {
+        auto filedata = reader.mappedData();
+        std::vector<char> buffer;
+        GatherInterleaved(reqs, blocksize, blockskip, [&](std::size_t pos, std::size_t len) -> const char* {
+            if (!filedata.empty()) {
+                if (pos > filedata.size() || len > filedata.size() - pos) {
+                    throw std::runtime_error("error while reading datafile");
+                }
+                return filedata.data() + pos;
+            }
+            buffer.resize(len);
+            reader.read(pos, buffer.data(), len);
+            return buffer.data();
+        });
+    }
+}
+
+void hkLib::ReadRawTraceData(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t nbytes, char* target)
+{
+    if (TrRecord.get(Trace::InterleaveSize, 0) == 0) {
+        if (const auto* mapped = getMappedFileBuf(datafile)) {
+            auto raw = GetContiguousRawTraceData(mapped->mappedData(), TrRecord, nbytes);
+            std::copy(raw.begin(), raw.end(), target);
+            return;
+        }
+        datafile.seekg(static_cast<std::streamoff>(TraceDataOffset(TrRecord))).read(target, nbytes);
+        if (!datafile) {
+            throw std::runtime_error("error while reading datafile");
+        }
+        return;
+    }
+    // it's interleaved data
+    const auto [blocksize, blockskip] = getInterleave(TrRecord, nbytes);
+    RawTraceRequest req{ checkedOffset(TrRecord), nbytes, target };
+    GatherInterleaved(datafile, std::span(&req, 1), blocksize, blockskip);
+}
+
+void hkLib::ReadRawTraceData(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t nbytes, char* target)
+{
+    if (TrRecord.get(Trace::InterleaveSize, 0) == 0) {
+        reader.read(checkedOffset(TrRecord), target, nbytes);
+        return;
+    }
+    const auto [blocksize, blockskip] = getInterleave(TrRecord, nbytes);
+    RawTraceRequest req{ checkedOffset(TrRecord), nbytes, target };
+    GatherInterleaved(reader, std::span(&req, 1), blocksize, blockskip);
+}
+
+namespace {
+    /// <summary>
+    /// convert trace data directly from filedata if it is contiguous there,
+    /// otherwise read the raw data with read(nbytes, ptr) into the tail of target and expand it in place
+    /// </summary>
+    template<typename Read> void ReadScaleAndConvertImpl(std::span<const char> filedata, const hkLib::hkTreeNode& TrRecord,
+        double* target, Read&& read)
+    {
+        using namespace hkLib;
+        const auto [dataformat, points, datascaler] = TrRecord.getFields(Trace::DataFormat, Trace::DataPoints, Trace::DataScaler);
+        const std::size_t samplesize = TraceView::sampleSizeOf(dataformat);
+        const std::size_t count = points, nbytes = count * samplesize;
+        const bool need_swap = TraceNeedsSwap(TrRecord);
+        if (!filedata.empty()) {
+            auto raw = GetContiguousRawTraceData(filedata, TrRecord, nbytes);
+            if (raw.size() == nbytes) {
+                ConvertSamples(dataformat, raw.data(), count, need_swap, datascaler, target);
+                return;
+            }
+        }
+        char* source = reinterpret_cast<char*>(target) + count * (sizeof(double) - samplesize);
+        read(nbytes, source);
+        ConvertSamples(dataformat, source, count, need_swap, datascaler, target);
+    }
+}
+
+void hkLib::ReadScaleAndConvert(std::istream& datafile, const hkTreeNode& TrRecord, double* target)
+{
+    const auto* mapped = getMappedFileBuf(datafile);
+    ReadScaleAndConvertImpl(mapped ? mapped->mappedData() : std::span<const char>{}, TrRecord, target,
+        [&](std::size_t nbytes, char* source) { ReadRawTraceData(datafile, TrRecord, nbytes, source); });
+}
+
+void hkLib::ReadScaleAndConvert(const PositionalReader& reader, const hkTreeNode& TrRecord, double* target)
+{
+    ReadScaleAndConvertImpl(reader.mappedData(), TrRecord, target,
+        [&](std::size_t nbytes, char* source) { ReadRawTraceData(reader, TrRecord, nbytes, source); });
+}
+
+namespace {
+    /// <summary>
+    /// read bytes [first_byte, first_byte + nbytes) of raw trace data, contiguous data is read
+    /// directly into target by read(pos, target, len), interleaved data is gathered via fetch(pos, len)
+    /// </summary>
+    template<typename Read, typename Fetch> void ReadRawRange(const hkTreeNode& TrRecord, std::size_t first_byte,
+        std::size_t nbytes, char* target, Read&& read, Fetch&& fetch)
+    {
+        const std::size_t total = TrRecord.get(Trace::DataPoints) * TraceView::sampleSizeOf(TrRecord.get(Trace::DataFormat));
+        if (first_byte > total || nbytes > total - first_byte) {
+            throw std::out_of_range("requested range exceeds trace data");
+        }
+        if (nbytes == 0) {
+            return;
+        }
+        const auto start = checkedOffset(TrRecord);
+        const auto [blocksize, blockskip] = getInterleave(TrRecord, total);
+        if (blocksize == blockskip) {
+            read(start + first_byte, target, nbytes);
+            return;
+        }
+        GatherRange(start, blocksize, blockskip, first_byte, nbytes, target, fetch);
+    }
+
+    /// <summary>
+    /// pointer to len bytes of mapped file data starting at pos
+    /// </summary>
+    const char* mappedRange(std::span<const char> filedata, std::size_t pos, std::size_t len)
+    {
+        if (pos > filedata.size() || len > filedata.size() - pos) {
+            throw std::runtime_error("error while reading datafile");
+        }
+        return filedata.data() + pos;
+    }
+}
+
+void hkLib::ReadRawTraceDataRange(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t first_byte,
+    std::size_t nbytes, char* target)
+{
+    if (const auto* mapped = getMappedFileBuf(datafile)) {
+        auto filedata = mapped->mappedData();
+        ReadRawRange(TrRecord, first_byte, nbytes, target,
+            [&](std::size_t pos, char* dest, std::size_t len) { std::memcpy(dest, mappedRange(filedata, pos, len), len); },
+            [&](std::size_t pos, std::size_t len) { return mappedRange(filedata, pos, len); });
+        return;
+    }
+    auto read = [&](std::size_t pos, char* dest, std::size_t len) {
+        datafile.seekg(pos).read(dest, len);
+        if (!datafile) {
+            throw std::runtime_error("error while reading datafile");
+        }
+    };
+    std::vector<char> buffer;
+    ReadRawRange(TrRecord, first_byte, nbytes, target, read, [&](std::size_t pos, std::size_t len) {
+        buffer.resize(len);
+        read(pos, buffer.data(), len);
+        return buffer.data();
+    });
+}
+
+void hkLib::ReadRawTraceDataRange(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t first_byte,
+    std::size_t nbytes, char* target)
+{
+    std::vector<char> buffer;
+    ReadRawRange(TrRecord, first_byte, nbytes, target,
+        [&](std::size_t pos, char* dest, std::size_t len) { reader.read(pos, dest, len); },
+        [&](std::size_t pos, std::size_t len) -> const char* {
+            if (auto filedata = reader.mappedData(); !filedata.empty()) {
+                return mappedRange(filedata, pos, len);
+            }
+            buffer.resize(len);
+            reader.read(pos, buffer.data(), len);
+            return buffer.data();
+        });
+}
+
+std::pair<std::size_t, std::size_t> hkLib::GetRawTraceDataExtent(const hkTreeNode& TrRecord, std::size_t nbytes)
+{
+    const auto start = checkedOffset(TrRecord);
+    if (nbytes == 0) {
+        return { start, start };
+    }
+    const auto [blocksize, blockskip] = getInterleave(TrRecord, nbytes);
+    const auto lastblock = (nbytes - 1) / blocksize;
+    return { start, start + lastblock * blockskip + (nbytes - lastblock * blocksize) };
+}
+
+void hkLib::CopyRawTraceData(std::span<const char> region, std::size_t region_offset, const hkTreeNode& TrRecord,
+    std::size_t nbytes, char* target)
+{
+    if (nbytes == 0) {
+        return;
+    }
+    const auto [blocksize, blockskip] = getInterleave(TrRecord, nbytes);
+    RawTraceRequest req{ checkedOffset(TrRecord), nbytes, target };
+    GatherInterleaved(std::span(&req, 1), blocksize, blockskip, [&](std::size_t pos, std::size_t len) {
+        if (pos < region_offset || pos - region_offset > region.size() || len > region.size() - (pos - region_offset)) {
+            throw std::runtime_error("trace data not contained in buffer");
+        }
+        return region.data() + (pos - region_offset);
+    });
+}
+
+void hkLib::ReadRawTraceData(std::istream& datafile, std::span<const hkTreeNode* const> TrRecords,
+    std::span<char* const> targets)
+{
+    if (TrRecords.size() != targets.size()) {
+        throw std::invalid_argument("number of trace records and targets differ");
+    }
+    if (TrRecords.empty()) {
+        return;
+    }
+    const int32_t interleavesize = TrRecords.front()->get(Trace::InterleaveSize, 0),
+        interleaveskip = TrRecords.front()->get(Trace::InterleaveSkip, 0);
+    std::vector<RawTraceRequest> reqs;
+    reqs.reserve(TrRecords.size());
+    bool shared_pattern = interleavesize > 0 && interleaveskip >= interleavesize;
+    for (std::size_t i = 0; i < TrRecords.size(); ++i) {
+        const auto& tr = *TrRecords[i];
+        const auto nbytes = tr.get(Trace::DataPoints) * TraceView::sampleSizeOf(tr.get(Trace::DataFormat));
+        shared_pattern = shared_pattern && tr.get(Trace::InterleaveSize, 0) == interleavesize
+            && tr.get(Trace::InterleaveSkip, 0) == interleaveskip;
+        reqs.push_back({ shared_pattern ? checkedOffset(tr) : 0, nbytes, targets[i] });
+    }
+    if (shared_pattern) {
+        // the blocks of all channels must lie within one interleave period
+        auto [lo, hi] = std::minmax_element(reqs.begin(), reqs.end(),
+            [](const auto& a, const auto& b) { return a.start < b.start; });
+        shared_pattern = hi->start - lo->start < static_cast<std::size_t>(interleaveskip);
+    }
+    if (!shared_pattern) {
+        for (std::size_t i = 0; i < TrRecords.size(); ++i) {
+            ReadRawTraceData(datafile, *TrRecords[i], reqs[i].nbytes, targets[i]);
+        }
+        return;
+    }
+    GatherInterleaved(datafile, reqs, std::size_t(interleavesize), std::size_t(interleaveskip));
+}
@@ -33,8 +33,21 @@
 #include <algorithm>
 #include <type_traits>
 #include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <stop_token>
+#include <utility>
+#include <vector>
 #include "machineinfo.h"
+#include "ConvertKernels.h"
+#include "DatIndex.h"
+#include "MappedFile.h"
+#include "PositionalReader.h"
+#include "RecordFields.h"
+#include "TraceCache.h"
 #include "hkTree.h"
 #include "helpers.h"
 
@@ -50,8 +63,8 @@ namespace hkLib {
 	/// a tree stored in the bundled dat file
 	/// </summary>
 	struct BundleItem {
-		int32_t Start; // file offset of tree/data 
-		int32_t Length; // length of data in bytes 
+		uint32_t Start; // file offset of tree/data (unsigned, files may exceed 2 GB)
+		uint32_t Length; // length of data in bytes 
 		char Extension[8]; // file extension of tree, e.g. .pul
 	};
 
@@ -74,22 +87,61 @@ namespace hkLib {
 
 	class DatFile
 	{
-		int32_t offsetDat, lenDat; // file offset and blocklength of rawdata
+		std::uint64_t offsetDat, lenDat; // file offset and blocklength of rawdata
 		std::string Version;
 		double Time; // file time given in header
 		bool isSwapped;
+		bool convertTrees; // convert swapped trees to native byte order when loading
 		hkTree PulTree, PgfTree, AmpTree;
+		TraceCache traceCache; // converted trace data, shared by display and export
+		std::vector<TraceStats> traceStats; // from index, in order of trace records, empty if no index has been used
+		std::filesystem::path indexPath; // index to create (see CreateIndex)
+		std::optional<DatIndex::FileStamp> indexStamp; // stamp of file without valid index, set only with IndexMode::Use
 	public:
-		DatFile() : offsetDat{ 0 }, lenDat{ 0 }, Version{}, Time{ 0.0 }, isSwapped{ false }, PulTree{},
-			PgfTree{}, AmpTree{} {};
+		DatFile() : offsetDat{ 0 }, lenDat{ 0 }, Version{}, Time{ 0.0 }, isSwapped{ false }, convertTrees{ false }, PulTree{},
+			PgfTree{}, AmpTree{}, traceCache{} {};
 		DatFile(const DatFile&) = delete;
 		DatFile operator=(const DatFile&) = delete;
 		/// <summary>
-		/// initialize from bundle file stream, reads header and tree data, but not raw data
+		/// initialize from bundle file stream, reads header and tree data, but not raw data.
+		/// Trees stored in non-native byte order are converted if enabled (see setConvertTreesToNative).
 		/// </summary>
 		/// <param name="istream">input stream of the bundle file</param>
 		void InitFromStream(std::istream& infile);
 		/// <summary>
+		/// initialize from bundle file, reads header and tree data, but not raw data
+		/// </summary>
+		/// <param name="reader">positional reader of the bundle file</param>
+		void InitFromStream(const PositionalReader& reader);
+		/// <summary>
+		/// Initialize from bundle file like above, using the sidecar index of the file (see DatIndex)
+		/// if it is valid, which saves parsing the trees and provides trace statistics.
+		/// With IndexMode::UseOrCreate, a missing or outdated index is created, which reads all trace data;
+		/// failing to write it (e.g. in a read-only directory) is not an error. With IndexMode::Use,
+		/// it can be created later by CreateIndex.
+		/// </summary>
+		/// <param name="infile">input stream of the bundle file</param>
+		/// <param name="path">path of the bundle file, needed to locate and validate the index</param>
+		/// <param name="mode">how to use the index</param>
+		/// <returns>true if the trees have been set up from the index</returns>
+		bool InitFromStream(std::istream& infile, const std::filesystem::path& path, IndexMode mode);
+		bool InitFromStream(const PositionalReader& reader, const std::filesystem::path& path, IndexMode mode);
+		/// <summary>
+		/// true if the file has been initialized with IndexMode::Use, but has no valid index (see CreateIndex)
+		/// </summary>
+		bool canCreateIndex() const { return indexStamp.has_value(); };
+		/// <summary>
+		/// Create the missing index of a file initialized with IndexMode::Use, like IndexMode::UseOrCreate
+		/// does while initializing. All trace data is read, but the DatFile is not modified, so this can run
+		/// on a worker thread after the file has been shown, as long as the DatFile is neither re-initialized
+		/// nor destroyed meanwhile. The trace statistics become available when the file is opened again.
+		/// Failing to write the index is not an error.
+		/// </summary>
+		/// <param name="reader">positional reader of the file</param>
+		/// <param name="stop">stops reading trace data when requested, e.g. when the file is closed</param>
+		/// <returns>true if the index has been written</returns>
+		bool CreateIndex(const PositionalReader& reader, std::stop_token stop = {});
+		/// <summary>
 		/// initialized from unbundles dat file, requires separate streams for each tree, and their lengths
 		/// </summary>
 		/// <param name="infile">dat file stream</param>
@@ -106,10 +158,43 @@ namespace hkLib {
 		hkTree& GetPulTree() { return PulTree; };
 		hkTree& GetPgfTree() { return PgfTree; };
 		hkTree& GetAmpTree() { return AmpTree; };
+		/// <summary>
+		/// cache of converted trace data, cleared when the file is (re-)initialized
+		/// </summary>
+		TraceCache& GetTraceCache() { return traceCache; };
+		/// <summary>
+		/// get converted trace data, from trace cache if possible
+		/// </summary>
+		/// <param name="datafile">data stream, used on cache miss</param>
+		/// <param name="TrRecord">trace record</param>
+		/// <returns>shared pointer to scaled trace data</returns>
+		TraceCache::TraceData GetTraceData(std::istream& datafile, const hkTreeNode& TrRecord)
+		{
+			return traceCache.get(datafile, TrRecord);
+		};
+		TraceCache::TraceData GetTraceData(const PositionalReader& reader, const hkTreeNode& TrRecord)
+		{
+			return traceCache.get(reader, TrRecord);
+		};
+		/// <summary>
+		/// statistics of trace data, available if the file was initialized using an index
+		/// </summary>
+		/// <param name="TrRecord">trace record of this file</param>
+		/// <returns>pointer to statistics, nullptr if not available</returns>
+		const TraceStats* GetTraceStats(const hkTreeNode& TrRecord);
 		std::string getVersion() const { return Version; }; // returns name and version of file creator
 		double GetTime() const { return Time; }; // return creation time in PatchMaster format (see time_handling.h)
 		bool getIsSwapped() const { return isSwapped; };
 		/// <summary>
+		/// Convert trees stored in non-native byte order to native byte order once when loading
+		/// (see MakeNativeByteOrder), so that field accesses need not swap bytes. Off by default.
+		/// Only the known numeric fields (see NumericRecordFields) are converted, any other field of a
+		/// converted tree reads the unconverted bytes, so enable this only if no other fields are accessed.
+		/// Takes effect for the next InitFromStream.
+		/// </summary>
+		void setConvertTreesToNative(bool convert) { convertTrees = convert; };
+		bool getConvertTreesToNative() const { return convertTrees; };
+		/// <summary>
 		/// create the header (1st line) containing the metadatafields
 		/// </summary>
 		/// <param name="os">stream to receive result</param>
@@ -128,13 +213,158 @@ namespace hkLib {
 		/// <param name="unit">receives unit</param>
 		/// <returns>holding value</returns>
 		double getTraceHolding(const hkTreeNode& trace, std::string& unit);
+	private:
+		void MakeTreesNative();
+		template<typename Source> bool InitFromBundle(Source& infile, const std::filesystem::path* path = nullptr,
+			IndexMode mode = IndexMode::None);
 	};
 
 	// some routine to read trace data
 
+	/// <summary>
+	/// data format type (DFT_int16, DFT_int32, DFT_float or DFT_double) corresponding to T
+	/// </summary>
+	template<typename T> constexpr char DataFormatOf()
+	{
+		static_assert(std::is_same_v<T, int16_t> || std::is_same_v<T, int32_t> ||
+			std::is_same_v<T, float> || std::is_same_v<T, double>, "unsupported raw data type");
+		if constexpr (std::is_same_v<T, int16_t>) return DFT_int16;
+		else if constexpr (std::is_same_v<T, int32_t>) return DFT_int32;
+		else if constexpr (std::is_same_v<T, float>) return DFT_float;
+		else return DFT_double;
+	}
+
+	/// <summary>
+	/// scale raw trace data and convert it to double (or float), uses vectorized kernels if available
+	/// </summary>
+	/// <typeparam name="T">type of raw data (short, long, float or double)</typeparam>
+	/// <typeparam name="Out">target type, double or float</typeparam>
+	/// <param name="source">raw data in file byte order, needn't be aligned</param>
+	/// <param name="count">number of datapoints</param>
+	/// <param name="need_swap">true if byte order of raw data differs from machine byte order</param>
+	/// <param name="datascaler">scaling factor</param>
+	/// <param name="target">buffer receiving count values</param>
+	template<typename T, typename Out = double> void ScaleAndConvert(const char* source, std::size_t count, bool need_swap,
+		double datascaler, Out* target)
+	{
+		static_assert(std::is_arithmetic_v<T>, "must be arithmetic type");
+		ConvertSamples(DataFormatOf<T>(), source, count, need_swap, datascaler, target);
+	}
+
+	/// <summary>
+	/// check if byte order of trace data differs from machine byte order
+	/// </summary>
+	/// <param name="TrRecord">trace record</param>
+	/// <returns>true if bytes need to be swapped</returns>
+	inline bool TraceNeedsSwap(const hkTreeNode& TrRecord)
+	{
+		uint16_t tracekind = TrRecord.get(Trace::DataKind);
+		return bool(tracekind & LittleEndianBit) != MachineIsLittleEndian();
+	}
+
+	/// <summary>
+	/// file offset of the raw data of a trace, the field has only 32 bits
+	/// but is treated as unsigned, so data may be located beyond 2 GB
+	/// </summary>
+	/// <param name="TrRecord">trace record</param>
+	/// <returns>file offset in bytes</returns>
+	inline std::uint64_t TraceDataOffset(const hkTreeNode& TrRecord)
+	{
+		return TrRecord.get(Trace::Data);
+	}
+
+	/// <summary>
+	/// Get the raw data of a trace as it is stored in memory (e.g. in a memory mapped file),
+	/// if it is stored contiguously, i.e. not interleaved.
+	/// </summary>
+	/// <param name="filedata">complete content of the data file</param>
+	/// <param name="TrRecord">trace record</param>
+	/// <param name="nbytes">size of trace data in bytes</param>
+	/// <returns>span of the raw trace data, empty span if data is interleaved</returns>
+	std::span<const char> GetContiguousRawTraceData(std::span<const char> filedata, const hkTreeNode& TrRecord,
+		std::size_t nbytes);
+
+	/// <summary>
+	/// Read raw trace data, i.e. unscaled and in file byte order. Handles interleaved data,
+	/// which is fetched in a few large reads (of whole interleave blocks) and de-interleaved in memory.
+	/// If datafile is a MappedFileStream, the data will be copied directly from the memory mapping.
+	/// </summary>
+	/// <param name="datafile">stream from which to read data</param>
+	/// <param name="TrRecord">trace record specifying the trace to be loaded</param>
+	/// <param name="nbytes">size of trace data in bytes</param>
+	/// <param name="target">buffer receiving nbytes bytes</param>
+	void ReadRawTraceData(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t nbytes, char* target);
+
+	/// <summary>
+	/// Read raw trace data using a positional reader, can be called concurrently from several threads.
+	/// </summary>
+	/// <param name="reader">reader of the data file</param>
+	/// <param name="TrRecord">trace record specifying the trace to be loaded</param>
+	/// <param name="nbytes">size of trace data in bytes</param>
+	/// <param name="target">buffer receiving nbytes bytes</param>
+	void ReadRawTraceData(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t nbytes, char* target);
+
+	/// <summary>
+	/// Read part of the raw data of a trace, i.e. bytes [first_byte, first_byte + nbytes) of the
+	/// de-interleaved raw data (unscaled and in file byte order). The range needn't be aligned
+	/// to interleave blocks. Throws std::out_of_range if the range exceeds the trace data.
+	/// </summary>
+	/// <param name="datafile">stream from which to read data</param>
+	/// <param name="TrRecord">trace record</param>
+	/// <param name="first_byte">offset of first byte within the raw trace data</param>
+	/// <param name="nbytes">number of bytes to read</param>
+	/// <param name="target">buffer receiving nbytes bytes</param>
+	void ReadRawTraceDataRange(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t first_byte,
+		std::size_t nbytes, char* target);
+	void ReadRawTraceDataRange(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t first_byte,
+		std::size_t nbytes, char* target);
+
+	/// <summary>
+	/// range of file offsets occupied by the raw data of a trace (including interleaved data of other traces)
+	/// </summary>
+	/// <param name="TrRecord">trace record</param>
+	/// <param name="nbytes">size of trace data in bytes</param>
+	/// <returns>pair of begin and end offset</returns>
+	std::pair<std::size_t, std::size_t> GetRawTraceDataExtent(const hkTreeNode& TrRecord, std::size_t nbytes);
+
+	/// <summary>
+	/// Copy raw trace data (de-interleaving it if needed) from a buffer holding a part of the data file.
+	/// Throws if the trace data is not completely contained in the buffer.
+	/// </summary>
+	/// <param name="region">buffer with file data</param>
+	/// <param name="region_offset">file offset of first byte in region</param>
+	/// <param name="TrRecord">trace record</param>
+	/// <param name="nbytes">size of trace data in bytes</param>
+	/// <param name="target">buffer receiving nbytes bytes</param>
+	void CopyRawTraceData(std::span<const char> region, std::size_t region_offset, const hkTreeNode& TrRecord,
+		std::size_t nbytes, char* target);
+
+	/// <summary>
+	/// Read raw data of several traces, typically the channels of one sweep. If all traces
+	/// share the same interleave pattern, they are extracted together in a single pass
+	/// over the interleaved data (using few large reads), otherwise they are read one by one.
+	/// </summary>
+	/// <param name="datafile">stream from which to read data</param>
+	/// <param name="TrRecords">trace records specifying the traces to be loaded</param>
+	/// <param name="targets">one buffer per trace, receiving TrDataPoints samples of raw data</param>
+	void ReadRawTraceData(std::istream& datafile, std::span<const hkTreeNode* const> TrRecords,
+		std::span<char* const> targets);
+
+	/// <summary>
+	/// Location within a buffer of count doubles where count raw samples of type T can be
+	/// stored such that converting them to the start of the same buffer never overwrites
+	/// samples not yet converted (ConvertSamples loads each block before storing it).
+	/// </summary>
+	template<typename T> char* ExpansionTail(double* target, std::size_t count)
+	{
+		static_assert(sizeof(T) <= sizeof(double), "raw samples must not be larger than double");
+		return reinterpret_cast<char*>(target) + count * (sizeof(double) - sizeof(T));
+	}
+
 	/// <summary>
 	/// read trace data from dat file and convert to double using 
-	/// the appropiate data-scaler (and byte swapping if needed) as specified in the trace record
+	/// the appropiate data-scaler (and byte swapping if needed) as specified in the trace record.
+	/// If datafile is a MappedFileStream, contiguous data will be converted directly from the memory mapping.
 	/// </summary>
 	/// <typeparam name="T">type of raw data (short, long, float or double)</typeparam>
 	/// <param name="datafile">stream (usually file-stream) from which to read data</param>
@@ -145,47 +375,59 @@ namespace hkLib {
 		double* target)
 	{
 		static_assert(std::is_arithmetic_v<T>, "must be arithmetic type");
-		assert(trdatapoints == TrRecord.extractValue<uint32_t>(TrDataPoints));
-		int32_t trdata = TrRecord.extractInt32(TrData);
-		datafile.seekg(trdata);
-
-		int32_t     interleavesize = TrRecord.extractValue<int32_t>(TrInterleaveSize, 0),
-			interleaveskip = TrRecord.extractValue<int32_t>(TrInterleaveSkip, 0);
-		uint16_t tracekind = TrRecord.extractUInt16(TrDataKind);
-		bool need_swap = bool(tracekind & LittleEndianBit) != MachineIsLittleEndian();
-		double datascaler = TrRecord.extractLongReal(TrDataScaler);
-
-		auto source = std::make_unique<T[]>(trdatapoints);
-		if (interleavesize == 0) {
-			datafile.read(reinterpret_cast<char*>(source.get()), sizeof(T) * trdatapoints);
-		}
-		else { // it's interleaved data
-			assert(interleaveskip >= interleavesize);
-			std::size_t bytesremaining = sizeof(T) * trdatapoints;
-			int bytestoskip = interleaveskip - interleavesize; // interleaveskip is from block-start to block-start!
-			char* p = reinterpret_cast<char*>(source.get());
-			while (bytesremaining > 0) {
-				auto bytestoread = std::min(bytesremaining, std::size_t(interleavesize));
-				datafile.read(p, bytestoread);
-				if (!datafile) { break; }
-				p += bytestoread;
-				bytesremaining -= bytestoread;
-				if (bytesremaining > 0) {
-					datafile.seekg(bytestoskip, std::ios::cur); // skip to next block
-				}
+		assert(trdatapoints == TrRecord.get(Trace::DataPoints));
+		const bool need_swap = TraceNeedsSwap(TrRecord);
+		const double datascaler = TrRecord.get(Trace::DataScaler);
+		const std::size_t nbytes = sizeof(T) * trdatapoints;
+		if (const auto* mapped = getMappedFileBuf(datafile)) {
+			auto raw = GetContiguousRawTraceData(mapped->mappedData(), TrRecord, nbytes);
+			if (raw.size() == nbytes) {
+				// zero-copy
+				ScaleAndConvert<T>(raw.data(), trdatapoints, need_swap, datascaler, target);
+				return;
 			}
 		}
-		if (!datafile) {
-			throw std::runtime_error("error while reading datafile");
-		}
-		if (!need_swap) {
-			std::transform(source.get(), source.get() + trdatapoints, target, [=](T x) { return datascaler * x; });
-		}
-		else {
-			std::transform(source.get(), source.get() + trdatapoints, target, [=](T x) {
-				return datascaler * swap_bytes(x); });
+		// expand in place: raw samples go to the tail of target and are converted front to back
+		char* source = ExpansionTail<T>(target, trdatapoints);
+		ReadRawTraceData(datafile, TrRecord, nbytes, source);
+		ScaleAndConvert<T>(source, trdatapoints, need_swap, datascaler, target);
+	}
+
+	/// <summary>
+	/// Read trace data using a positional reader and convert to double, like ReadScaleAndConvert above.
+	/// Since no stream position is involved, this can be called concurrently from several threads.
+	/// </summary>
+	template<typename T> void ReadScaleAndConvert(const PositionalReader& reader, const hkTreeNode& TrRecord,
+		std::size_t trdatapoints, double* target)
+	{
+		static_assert(std::is_arithmetic_v<T>, "must be arithmetic type");
+		assert(trdatapoints == TrRecord.get(Trace::DataPoints));
+		const bool need_swap = TraceNeedsSwap(TrRecord);
+		const double datascaler = TrRecord.get(Trace::DataScaler);
+		const std::size_t nbytes = sizeof(T) * trdatapoints;
+		if (auto filedata = reader.mappedData(); !filedata.empty()) {
+			auto raw = GetContiguousRawTraceData(filedata, TrRecord, nbytes);
+			if (raw.size() == nbytes) {
+				// zero-copy
+				ScaleAndConvert<T>(raw.data(), trdatapoints, need_swap, datascaler, target);
+				return;
+			}
 		}
+		char* source = ExpansionTail<T>(target, trdatapoints);
+		ReadRawTraceData(reader, TrRecord, nbytes, source);
+		ScaleAndConvert<T>(source, trdatapoints, need_swap, datascaler, target);
 	}
 
+	/// <summary>
+	/// Read trace data and convert it to double, the type of the raw data is taken from the trace record.
+	/// Like ReadScaleAndConvert<T>, no buffer is allocated: contiguous data in a memory mapping
+	/// is converted directly, otherwise the raw data is expanded in place within target.
+	/// </summary>
+	/// <param name="datafile">stream from which to read data</param>
+	/// <param name="TrRecord">trace record specifying the trace to be loaded</param>
+	/// <param name="target">buffer allocated by caller, must have space for TrDataPoints doubles</param>
+	void ReadScaleAndConvert(std::istream& datafile, const hkTreeNode& TrRecord, double* target);
+	void ReadScaleAndConvert(const PositionalReader& reader, const hkTreeNode& TrRecord, double* target);
+
 }
 #endif // !DATFILE_H
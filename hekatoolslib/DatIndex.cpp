@@ -0,0 +1,349 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include "DatFile.h"
+#include "DatIndex.h"
+#include "TraceChunkReader.h"
+
+namespace hkLib {
+
+    namespace {
+        constexpr char Magic[8] = { 'P', 'M', 'I', 'D', 'X', '\0', '\0', '\0' };
+        constexpr std::uint32_t ByteOrderMark = 0x01020304;
+
+        template<typename T> void put(std::string& buf, const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "must be trivially copyable");
+            buf.append(reinterpret_cast<const char*>(&value), sizeof value);
+        }
+
+        /// <summary>
+        /// sequential reader of index data, throws std::runtime_error if data is exhausted
+        /// </summary>
+        class IndexReader {
+        public:
+            explicit IndexReader(std::span<const char> data) : data{ data } {};
+            template<typename T> T get()
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "must be trivially copyable");
+                T value;
+                std::memcpy(&value, take(sizeof value).data(), sizeof value);
+                return value;
+            }
+            std::span<const char> take(std::size_t n)
+            {
+                if (n > data.size() - pos) {
+                    throw std::runtime_error("index file truncated");
+                }
+                auto s = data.subspan(pos, n);
+                pos += n;
+                return s;
+            }
+            // number of elements of given size, checked against the remaining data
+            std::size_t count(std::size_t element_size)
+            {
+                const auto n = get<std::uint64_t>();
+                if (n > (data.size() - pos) / element_size) {
+                    throw std::runtime_error("index file truncated");
+                }
+                return static_cast<std::size_t>(n);
+            }
+            bool atEnd() const { return pos == data.size(); };
+        private:
+            std::span<const char> data;
+            std::size_t pos{ 0 };
+        };
+
+        // FNV-1a
+        std::uint64_t hashBytes(std::span<const char> bytes)
+        {
+            std::uint64_t h = 14695981039346656037ull;
+            for (auto c : bytes) {
+                h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+            return h;
+        }
+
+        template<typename Source> TraceStats computeStats(Source& source, const hkTreeNode& TrRecord)
+        {
+            constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+            double min_val = std::numeric_limits<double>::infinity(), max_val = -min_val, sum = 0.0;
+            std::size_t n = 0;
+            TraceChunkReader chunks(source, TrRecord);
+            for (auto chunk = chunks.next(); !chunk.empty(); chunk = chunks.next()) {
+                for (auto x : chunk) {
+                    // comparisons are false for NaN, so NaNs do not affect min and max
+                    if (x < min_val) min_val = x;
+                    if (x > max_val) max_val = x;
+                    sum += x;
+                }
+                n += chunk.size();
+            }
+            if (n == 0) {
+                return { nan, nan, nan };
+            }
+            if (min_val > max_val) {
+                min_val = max_val = nan; // all samples are NaN
+            }
+            return { min_val, max_val, sum / static_cast<double>(n) };
+        }
+
+        constexpr std::size_t LayoutEntrySize = 2 * sizeof(std::uint32_t);
+        constexpr std::size_t TraceEntrySize = sizeof(std::uint64_t) + sizeof(std::uint32_t) + 2 * sizeof(std::int32_t)
+            + sizeof(char) + 4 * sizeof(double);
+        constexpr std::size_t TreeIdSize = 8;
+    }
+
+    std::filesystem::path DatIndex::PathFor(const std::filesystem::path& datpath)
+    {
+        auto path = datpath;
+        path += FileExtension;
+        return path;
+    }
+
+    bool DatIndex::GetStamp(const std::filesystem::path& datpath, std::span<const char> header, FileStamp& stamp)
+    {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(datpath, ec);
+        if (ec) {
+            return false;
+        }
+        const auto mtime = std::filesystem::last_write_time(datpath, ec);
+        if (ec) {
+            return false;
+        }
+        stamp.size = size;
+        stamp.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+        stamp.header_hash = hashBytes(header);
+        return true;
+    }
+
+    DatIndex::TraceEntry DatIndex::MakeEntry(const hkTreeNode& TrRecord)
+    {
+        TraceEntry entry;
+        entry.data_offset = TraceDataOffset(TrRecord);
+        entry.points = TrRecord.get(Trace::DataPoints, 0);
+        entry.interleave_size = TrRecord.get(Trace::InterleaveSize, 0);
+        entry.interleave_skip = TrRecord.get(Trace::InterleaveSkip, 0);
+        entry.format = TrRecord.get(Trace::DataFormat, 0);
+        entry.scaler = TrRecord.get(Trace::DataScaler, 0.0);
+        return entry;
+    }
+
+    template<typename Source> std::optional<DatIndex> DatIndex::CreateFrom(DatFile& datf, Source& source,
+        const FileStamp& stamp, std::stop_token stop)
+    {
+        DatIndex index;
+        index.stamp = stamp;
+        for (auto* tree : { &datf.GetPulTree(), &datf.GetPgfTree(), &datf.GetAmpTree() }) {
+            if (tree->isValid()) {
+                index.trees.emplace_back(tree->getID(), tree->GetLayout());
+            }
+        }
+        const auto traces = datf.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace);
+        index.traces.reserve(traces.size());
+        for (const auto& trace : traces) {
+            if (stop.stop_requested()) {
+                return std::nullopt;
+            }
+            auto entry = MakeEntry(trace);
+            try {
+                entry.stats = computeStats(source, trace);
+            }
+            catch (const std::exception&) {
+                // unreadable trace, no statistics, but it shouldn't prevent indexing the file
+                constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+                entry.stats = { nan, nan, nan };
+            }
+            index.traces.push_back(entry);
+        }
+        return index;
+    }
+
+    DatIndex DatIndex::Create(DatFile& datf, std::istream& datafile, const FileStamp& stamp)
+    {
+        return *CreateFrom(datf, datafile, stamp);
+    }
+
+    DatIndex DatIndex::Create(DatFile& datf, const PositionalReader& reader, const FileStamp& stamp)
+    {
+        return *CreateFrom(datf, reader, stamp);
+    }
+
+    std::optional<DatIndex> DatIndex::Create(DatFile& datf, const PositionalReader& reader, const FileStamp& stamp,
+        std::stop_token stop)
+    {
+        return CreateFrom(datf, reader, stamp, stop);
+    }
+
+    std::optional<DatIndex> DatIndex::Load(const std::filesystem::path& path, const FileStamp& stamp)
+    {
+        std::ifstream infile(path, std::ios::binary);
+        if (!infile) {
+            return std::nullopt;
+        }
+        const std::string content{ std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>() };
+        // the file ends with a hash of all preceding bytes
+        constexpr auto ChecksumSize = sizeof(std::uint64_t);
+        if (content.size() < ChecksumSize) {
+            return std::nullopt;
+        }
+        const std::span<const char> payload(content.data(), content.size() - ChecksumSize);
+        std::uint64_t checksum;
+        std::memcpy(&checksum, content.data() + payload.size(), ChecksumSize);
+        if (checksum != hashBytes(payload)) {
+            return std::nullopt;
+        }
+        try {
+            IndexReader in(payload);
+            if (std::memcmp(in.take(sizeof Magic).data(), Magic, sizeof Magic) != 0
+                || in.get<std::uint32_t>() != ByteOrderMark || in.get<std::uint32_t>() != FormatVersion) {
+                return std::nullopt;
+            }
+            DatIndex index;
+            index.stamp.size = in.get<std::uint64_t>();
+            index.stamp.mtime = in.get<std::int64_t>();
+            index.stamp.header_hash = in.get<std::uint64_t>();
+            if (!(index.stamp == stamp)) {
+                return std::nullopt;
+            }
+            const auto ntrees = in.count(TreeIdSize);
+            for (std::size_t t = 0; t < ntrees; ++t) {
+                const auto id = in.take(TreeIdSize);
+                auto& [tree_id, layout] = index.trees.emplace_back(
+                    std::string(id.begin(), std::find(id.begin(), id.end(), '\0')), std::vector<hkTreeNodeLayout>{});
+                layout.resize(in.count(LayoutEntrySize));
+                for (auto& node : layout) {
+                    node.offset = in.get<std::uint32_t>();
+                    node.nchildren = in.get<std::uint32_t>();
+                }
+            }
+            index.traces.resize(in.count(TraceEntrySize));
+            for (auto& entry : index.traces) {
+                entry.data_offset = in.get<std::uint64_t>();
+                entry.points = in.get<std::uint32_t>();
+                entry.interleave_size = in.get<std::int32_t>();
+                entry.interleave_skip = in.get<std::int32_t>();
+                entry.format = in.get<char>();
+                entry.scaler = in.get<double>();
+                entry.stats.min = in.get<double>();
+                entry.stats.max = in.get<double>();
+                entry.stats.mean = in.get<double>();
+            }
+            if (!in.atEnd()) {
+                return std::nullopt;
+            }
+            return index;
+        }
+        catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+    }
+
+    void DatIndex::Save(const std::filesystem::path& path) const
+    {
+        std::string buf;
+        buf.append(Magic, sizeof Magic);
+        put(buf, ByteOrderMark);
+        put(buf, FormatVersion);
+        put(buf, stamp.size);
+        put(buf, stamp.mtime);
+        put(buf, stamp.header_hash);
+        put(buf, std::uint64_t(trees.size()));
+        for (const auto& [tree_id, layout] : trees) {
+            char id[TreeIdSize]{};
+            std::memcpy(id, tree_id.data(), std::min(tree_id.size(), TreeIdSize));
+            buf.append(id, TreeIdSize);
+            put(buf, std::uint64_t(layout.size()));
+            for (const auto& node : layout) {
+                put(buf, node.offset);
+                put(buf, node.nchildren);
+            }
+        }
+        put(buf, std::uint64_t(traces.size()));
+        for (const auto& entry : traces) {
+            put(buf, entry.data_offset);
+            put(buf, entry.points);
+            put(buf, entry.interleave_size);
+            put(buf, entry.interleave_skip);
+            put(buf, entry.format);
+            put(buf, entry.scaler);
+            put(buf, entry.stats.min);
+            put(buf, entry.stats.max);
+            put(buf, entry.stats.mean);
+        }
+        put(buf, hashBytes(buf));
+
+        auto tmppath = path;
+        tmppath += ".tmp";
+        {
+            std::ofstream outfile(tmppath, std::ios::binary | std::ios::trunc);
+            if (!outfile.write(buf.data(), buf.size()) || !outfile.flush()) {
+                outfile.close();
+                std::error_code ec;
+                std::filesystem::remove(tmppath, ec);
+                throw std::runtime_error("error writing index file");
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmppath, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmppath, ec);
+            throw std::runtime_error("error writing index file");
+        }
+    }
+
+    std::span<const hkTreeNodeLayout> DatIndex::getLayout(std::string_view tree_id) const
+    {
+        for (const auto& [id, layout] : trees) {
+            if (id == tree_id) {
+                return layout;
+            }
+        }
+        return {};
+    }
+
+    bool DatIndex::matches(hkTree& pultree) const
+    {
+        const auto records = pultree.GetLevelNodes(hkTreeNode::LevelTrace);
+        if (records.size() != traces.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < traces.size(); ++i) {
+            const auto entry = MakeEntry(records[i]);
+            const auto& indexed = traces[i];
+            if (entry.data_offset != indexed.data_offset || entry.points != indexed.points
+                || entry.interleave_size != indexed.interleave_size || entry.interleave_skip != indexed.interleave_skip
+                || entry.format != indexed.format || std::memcmp(&entry.scaler, &indexed.scaler, sizeof(double)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
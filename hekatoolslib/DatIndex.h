@@ -0,0 +1,169 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DAT_INDEX_H
+#define DAT_INDEX_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "hkTree.h"
+#include "PositionalReader.h"
+
+namespace hkLib {
+
+    class DatFile;
+
+    /// <summary>
+    /// how DatFile uses the sidecar index (see DatIndex) of a data file
+    /// </summary>
+    enum class IndexMode {
+        None,       //!< always parse the file
+        Use,        //!< use the index if it exists and matches the file
+        UseOrCreate //!< as Use, but create a missing or outdated index (reads all trace data once)
+    };
+
+    /// <summary>
+    /// scaled minimum, maximum and mean of a trace, NaN for empty traces
+    /// </summary>
+    struct TraceStats {
+        double min, max, mean;
+    };
+
+    /// <summary>
+    /// Sidecar index of a bundled dat file, stored next to it as <file>.pmidx.
+    /// It holds the node layout of the trees, so they can be set up without parsing,
+    /// and for each trace the fields needed to read its data together with precomputed statistics.
+    /// The index is valid only for the exact state of the data file it was created from,
+    /// identified by file size, modification time and a hash of the bundle header.
+    /// It is a cache on the local machine, stored in machine byte order; an index written
+    /// on a machine with different byte order is treated as invalid.
+    /// </summary>
+    class DatIndex {
+    public:
+        static constexpr char FileExtension[] = ".pmidx";
+        static constexpr std::uint32_t FormatVersion = 1;
+
+        /// <summary>
+        /// identifies the state of a data file
+        /// </summary>
+        struct FileStamp {
+            std::uint64_t size{};
+            std::int64_t mtime{};
+            std::uint64_t header_hash{};
+            bool operator==(const FileStamp&) const = default;
+        };
+
+        /// <summary>
+        /// fields of a trace record needed to locate and convert its data, and its statistics
+        /// </summary>
+        struct TraceEntry {
+            std::uint64_t data_offset{};
+            std::uint32_t points{};
+            std::int32_t interleave_size{}, interleave_skip{};
+            char format{};
+            double scaler{};
+            TraceStats stats{};
+        };
+
+        /// <summary>
+        /// path of the index belonging to a data file
+        /// </summary>
+        static std::filesystem::path PathFor(const std::filesystem::path& datpath);
+
+        /// <summary>
+        /// determine stamp of a data file
+        /// </summary>
+        /// <param name="datpath">path of data file</param>
+        /// <param name="header">bundle header as read from the file (not byte-swapped)</param>
+        /// <param name="stamp">receives the stamp</param>
+        /// <returns>false if size or modification time of the file cannot be determined</returns>
+        static bool GetStamp(const std::filesystem::path& datpath, std::span<const char> header, FileStamp& stamp);
+
+        /// <summary>
+        /// Create index of an initialized (bundled) DatFile. To compute the
+        /// statistics, all trace data is read (in chunks, so memory use is bounded).
+        /// </summary>
+        /// <param name="datf">data file, initialized from the file the stamp belongs to</param>
+        /// <param name="datafile">stream from which trace data is read</param>
+        /// <param name="stamp">stamp of the data file</param>
+        static DatIndex Create(DatFile& datf, std::istream& datafile, const FileStamp& stamp);
+        static DatIndex Create(DatFile& datf, const PositionalReader& reader, const FileStamp& stamp);
+        /// <summary>
+        /// as above, but stops reading trace data when requested, e.g. when run on a worker thread
+        /// </summary>
+        /// <returns>the index, or std::nullopt if stopped</returns>
+        static std::optional<DatIndex> Create(DatFile& datf, const PositionalReader& reader, const FileStamp& stamp,
+            std::stop_token stop);
+
+        /// <summary>
+        /// load index from file
+        /// </summary>
+        /// <param name="path">path of index file</param>
+        /// <param name="stamp">stamp of the data file the index must belong to</param>
+        /// <returns>the index, or std::nullopt if the file does not exist, cannot be read,
+        /// has an unknown format or belongs to another state of the data file</returns>
+        static std::optional<DatIndex> Load(const std::filesystem::path& path, const FileStamp& stamp);
+
+        /// <summary>
+        /// Write index to file. It is written to a temporary file first, which then replaces
+        /// the index, so other processes never see a partially written index.
+        /// Throws std::runtime_error on errors.
+        /// </summary>
+        void Save(const std::filesystem::path& path) const;
+
+        /// <summary>
+        /// node layout of tree (e.g. ".pul"), empty if the tree is not in the index
+        /// </summary>
+        std::span<const hkTreeNodeLayout> getLayout(std::string_view tree_id) const;
+
+        /// <summary>
+        /// trace entries, in the order of the traces in the pulse tree (hkTree::GetLevelNodes)
+        /// </summary>
+        std::span<const TraceEntry> getTraces() const { return traces; };
+
+        /// <summary>
+        /// check that the trace entries match the trace records of the pulse tree
+        /// </summary>
+        bool matches(hkTree& pultree) const;
+
+    private:
+        DatIndex() = default;
+        template<typename Source> static std::optional<DatIndex> CreateFrom(DatFile& datf, Source& source,
+            const FileStamp& stamp, std::stop_token stop = {});
+        static TraceEntry MakeEntry(const hkTreeNode& TrRecord);
+
+        FileStamp stamp;
+        std::vector<std::pair<std::string, std::vector<hkTreeNodeLayout>>> trees;
+        std::vector<TraceEntry> traces;
+    };
+}
+
+#endif // !DAT_INDEX_H
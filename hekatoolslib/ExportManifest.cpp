@@ -0,0 +1,126 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <cassert>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include "DatFile.h"
+#include "ExportManifest.h"
+#include "PMparameters.h"
+
+namespace hkLib {
+
+    namespace {
+        constexpr const char* recordType(int level)
+        {
+            switch (level) {
+            case hkTreeNode::LevelRoot:
+                return "root";
+            case hkTreeNode::LevelGroup:
+                return "group";
+            case hkTreeNode::LevelSeries:
+                return "series";
+            case hkTreeNode::LevelSweep:
+                return "sweep";
+            default:
+                return "trace";
+            }
+        }
+
+        void formatParams(const hkTreeNode& node, std::ostream& os)
+        {
+            switch (node.getLevel()) {
+            case hkTreeNode::LevelRoot:
+                formatParamListExportJSON(node, parametersRoot, os);
+                break;
+            case hkTreeNode::LevelGroup:
+                formatParamListExportJSON(node, parametersGroup, os);
+                break;
+            case hkTreeNode::LevelSeries:
+                formatParamListExportJSON(node, parametersSeries, os);
+                break;
+            case hkTreeNode::LevelSweep:
+                formatParamListExportJSON(node, parametersSweep, os);
+                break;
+            default:
+                formatParamListExportJSON(node, parametersTrace, os);
+                break;
+            }
+        }
+    }
+
+    std::string ManifestWriter::nodeID(const hkTreeNode& node)
+    {
+        const auto* parent = node.getParent();
+        if (!parent) {
+            return "root";
+        }
+        // children are stored contiguously, so the index follows from the address
+        const auto index = std::to_string(&node - &parent->Children.front() + 1);
+        if (parent->getLevel() == hkTreeNode::LevelRoot) {
+            return index;
+        }
+        return nodeID(*parent) + "_" + index;
+    }
+
+    void ManifestWriter::addNode(const hkTreeNode& node)
+    {
+        if (!written.insert(&node).second) {
+            return;
+        }
+        if (const auto* parent = node.getParent()) {
+            addNode(*parent);
+        }
+        std::ostringstream line;
+        line.imbue(std::locale::classic());
+        line << "{\"type\": \"" << recordType(node.getLevel()) << "\", \"id\": \"" << nodeID(node) << "\"";
+        if (const auto* parent = node.getParent()) {
+            line << ", \"parent\": \"" << nodeID(*parent) << "\"";
+        }
+        line << ", \"params\": ";
+        formatParams(node, line);
+        line << "}\n";
+        os << line.str();
+    }
+
+    void ManifestWriter::addTrace(const hkTreeNode& TrRecord, std::string_view filename)
+    {
+        assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
+        addNode(*TrRecord.getParent());
+        const SampleEncoder encoder(dtype, TrRecord.get(Trace::DataFormat), false, TrRecord.get(Trace::DataScaler));
+        std::ostringstream line;
+        line.imbue(std::locale::classic());
+        line << "{\"type\": \"trace\", \"id\": \"" << nodeID(TrRecord) << "\", \"parent\": \""
+            << nodeID(*TrRecord.getParent()) << "\", \"file\": \"" << filename << "\""
+            << std::scientific << ", \"x_0\": " << TrRecord.get(Trace::XStart)
+            << ", \"delta_x\": " << TrRecord.get(Trace::XInterval) << std::defaultfloat
+            << ", \"numpnts\": " << TrRecord.get(Trace::DataPoints)
+            << ", \"unit_x\": \"" << TrRecord.get(Trace::XUnit) << "\", \"unit_y\": \"" << TrRecord.get(Trace::YUnit) << "\"";
+        if (dtype != ExportDataType::Float64) {
+            line << ", \"dtype\": \"" << ExportDataTypeName(dtype) << "\", \"scale_factor\": "
+                << std::setprecision(17) << encoder.outputScaler() << std::setprecision(6);
+        }
+        line << ", \"params\": ";
+        formatParams(TrRecord, line);
+        line << "}\n";
+        os << line.str();
+    }
+}
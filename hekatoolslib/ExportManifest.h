@@ -0,0 +1,73 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef EXPORT_MANIFEST_H
+#define EXPORT_MANIFEST_H
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "hkTree.h"
+#include "SampleEncoder.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Writes the metadata of exported traces as one manifest in JSON Lines format
+    /// (one JSON object per line), as an alternative to one JSON file per trace.
+    /// The root, each group, series and sweep are written once, when first referenced by a trace,
+    /// trace records reference their parent by ID. IDs are formed from the (1-based) indices
+    /// in the tree, e.g. group "1", series "1_2", sweep "1_2_3", trace "1_2_3_1"; the root has ID "root".
+    /// Example:
+    /// {"type": "series", "id": "1_2", "parent": "1", "params": { ... }}
+    /// {"type": "trace", "id": "1_2_3_1", "parent": "1_2_3", "file": "PM_1_2_3_Imon.npy", "x_0": ..., "params": { ... }}
+    /// </summary>
+    class ManifestWriter {
+    public:
+        /// <param name="os">stream the manifest is written to</param>
+        /// <param name="dtype">data type of the exported traces</param>
+        explicit ManifestWriter(std::ostream& os, ExportDataType dtype = ExportDataType::Float64)
+            : os{ os }, dtype{ dtype } {};
+
+        /// <summary>
+        /// write record of trace, preceded by records of its parents not yet written
+        /// </summary>
+        /// <param name="TrRecord">trace record</param>
+        /// <param name="filename">name of the file the trace data has been exported to</param>
+        void addTrace(const hkTreeNode& TrRecord, std::string_view filename);
+
+        /// <summary>
+        /// ID of node as used in the manifest
+        /// </summary>
+        static std::string nodeID(const hkTreeNode& node);
+
+    private:
+        void addNode(const hkTreeNode& node);
+
+        std::ostream& os;
+        ExportDataType dtype;
+        std::unordered_set<const hkTreeNode*> written;
+    };
+}
+
+#endif // !EXPORT_MANIFEST_H
@@ -30,8 +30,10 @@ namespace hkLib {
 	using std::int32_t;
 	using std::uint32_t;
 
+	constexpr auto NT_FP32 = 2;			// 32 bit fp numbers.
+	constexpr auto NT_FP64 = 4;			// 64 bit fp numbers.
+	constexpr auto NT_I16 = 0x10;		// 16 bit integer numbers.
 	constexpr auto NT_I32 = 0x20;		// 32 bit integer numbers.
-	constexpr auto NT_FP64 = 4;
 	constexpr auto NT_UNSIGNED = 0x40;	// Makes above signed integers unsigned.
 
 	constexpr auto MAXDIMS = 4;
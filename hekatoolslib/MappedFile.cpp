@@ -0,0 +1,190 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hkLib {
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        h_file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (h_file == INVALID_HANDLE_VALUE) {
+            h_file = nullptr;
+            throw std::runtime_error("cannot open file for mapping");
+        }
+        LARGE_INTEGER filesize{};
+        if (!::GetFileSizeEx(h_file, &filesize) || filesize.QuadPart == 0) {
+            ::CloseHandle(h_file);
+            throw std::runtime_error("cannot map empty file");
+        }
+        if (!std::in_range<std::size_t>(filesize.QuadPart)) {
+            ::CloseHandle(h_file);
+            throw std::runtime_error("file too large for mapping");
+        }
+        length = static_cast<std::size_t>(filesize.QuadPart);
+        h_mapping = ::CreateFileMappingW(h_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!h_mapping) {
+            ::CloseHandle(h_file);
+            throw std::runtime_error("cannot create file mapping");
+        }
+        p_data = static_cast<char*>(::MapViewOfFile(h_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!p_data) {
+            ::CloseHandle(h_mapping);
+            ::CloseHandle(h_file);
+            throw std::runtime_error("cannot map view of file");
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        ::UnmapViewOfFile(p_data);
+        ::CloseHandle(h_mapping);
+        ::CloseHandle(h_file);
+    }
+#else
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("cannot open file for mapping, ") + std::strerror(errno));
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot map empty file");
+        }
+        if (!std::in_range<std::size_t>(st.st_size)) {
+            ::close(fd);
+            throw std::runtime_error("file too large for mapping");
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference to the file
+        if (p == MAP_FAILED) {
+            throw std::runtime_error(std::string("cannot map file, ") + std::strerror(errno));
+        }
+        p_data = static_cast<char*>(p);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        ::munmap(p_data, length);
+    }
+#endif // _WIN32
+
+    void MappedFileBuf::setMapping(std::shared_ptr<MappedFile> mapping)
+    {
+        p_mapping = std::move(mapping);
+        if (p_mapping) {
+            // the get area is never written to, std::streambuf just lacks a const interface
+            auto p = const_cast<char*>(p_mapping->data());
+            setg(p, p, p + p_mapping->size());
+        }
+        else {
+            setg(nullptr, nullptr, nullptr);
+        }
+    }
+
+    std::span<const char> MappedFileBuf::mappedData() const
+    {
+        if (!p_mapping) {
+            return {};
+        }
+        return p_mapping->span();
+    }
+
+    MappedFileBuf::pos_type MappedFileBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which)
+    {
+        if (!p_mapping || !(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        off_type base{};
+        if (dir == std::ios_base::cur) {
+            base = gptr() - eback();
+        }
+        else if (dir == std::ios_base::end) {
+            base = egptr() - eback();
+        }
+        off_type newpos = base + off;
+        if (newpos < 0 || newpos > egptr() - eback()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + newpos, egptr());
+        return pos_type(newpos);
+    }
+
+    MappedFileBuf::pos_type MappedFileBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+    std::streamsize MappedFileBuf::showmanyc()
+    {
+        auto n = egptr() - gptr();
+        return n > 0 ? n : -1;
+    }
+
+    std::streamsize MappedFileBuf::xsgetn(char_type* s, std::streamsize count)
+    {
+        auto n = std::min<std::streamsize>(count, egptr() - gptr());
+        if (n > 0) {
+            std::memcpy(s, gptr(), static_cast<std::size_t>(n));
+            setg(eback(), gptr() + n, egptr()); // gbump() only takes an int
+        }
+        return n;
+    }
+
+    void MappedFileStream::open(const std::filesystem::path& path)
+    {
+        try {
+            buf.setMapping(std::make_shared<MappedFile>(path));
+            clear();
+        }
+        catch (const std::runtime_error&) {
+            buf.setMapping(nullptr);
+            setstate(std::ios_base::failbit);
+        }
+    }
+
+    void MappedFileStream::close()
+    {
+        buf.setMapping(nullptr);
+    }
+}
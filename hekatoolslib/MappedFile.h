@@ -0,0 +1,120 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <span>
+#include <streambuf>
+
+namespace hkLib {
+
+    /// <summary>
+    /// Read-only memory mapping of a complete file.
+    /// Data that has to be modified (e.g. trees converted to native byte order)
+    /// must be copied first, so the mapping never consumes memory of its own.
+    /// </summary>
+    class MappedFile {
+    public:
+        /// <summary>
+        /// map the file, throws std::runtime_error if mapping fails
+        /// </summary>
+        /// <param name="path">file to be mapped</param>
+        explicit MappedFile(const std::filesystem::path& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return p_data; };
+        std::size_t size() const { return length; };
+        std::span<const char> span() const { return { p_data, length }; };
+
+    private:
+        char* p_data{};
+        std::size_t length{};
+#ifdef _WIN32
+        void* h_file{};
+        void* h_mapping{};
+#endif
+    };
+
+    /// <summary>
+    /// read-only streambuf operating directly on a MappedFile.
+    /// Readers that know about it (hkTree::InitFromStream, ReadScaleAndConvert)
+    /// access the mapped memory directly instead of copying data via read().
+    /// </summary>
+    class MappedFileBuf : public std::streambuf {
+    public:
+        MappedFileBuf() = default;
+        explicit MappedFileBuf(std::shared_ptr<MappedFile> mapping) { setMapping(std::move(mapping)); };
+        void setMapping(std::shared_ptr<MappedFile> mapping);
+        const std::shared_ptr<MappedFile>& getMapping() const { return p_mapping; };
+        std::span<const char> mappedData() const;
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+            std::ios_base::openmode which = std::ios_base::in) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+        std::streamsize showmanyc() override;
+        std::streamsize xsgetn(char_type* s, std::streamsize count) override;
+
+    private:
+        std::shared_ptr<MappedFile> p_mapping{};
+    };
+
+    /// <summary>
+    /// input stream reading from a memory mapped file,
+    /// can be used as a drop-in replacement for std::ifstream
+    /// </summary>
+    class MappedFileStream : public std::istream {
+    public:
+        MappedFileStream() : std::istream(nullptr) { init(&buf); };
+        explicit MappedFileStream(const std::filesystem::path& path) : MappedFileStream() { open(path); };
+
+        /// <summary>
+        /// map file, sets failbit if this fails
+        /// </summary>
+        /// <param name="path">path of file</param>
+        void open(const std::filesystem::path& path);
+        void close();
+        bool is_open() const { return !!buf.getMapping(); };
+        MappedFileBuf* rdbuf() const { return const_cast<MappedFileBuf*>(&buf); };
+
+    private:
+        MappedFileBuf buf;
+    };
+
+    /// <summary>
+    /// get the memory mapping used by a stream, if any
+    /// </summary>
+    /// <param name="is">stream</param>
+    /// <returns>pointer to the MappedFileBuf of the stream or nullptr if stream is not memory mapped</returns>
+    inline const MappedFileBuf* getMappedFileBuf(const std::istream& is)
+    {
+        return dynamic_cast<const MappedFileBuf*>(is.rdbuf());
+    }
+}
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,62 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <locale>
+#include <stdexcept>
+#include "MetadataBlockCache.h"
+
+namespace hkLib {
+
+    MetadataBlockCache::MetadataBlockCache(Format format) : format{ format },
+        plans{ ParamFormatPlan(parametersRoot), ParamFormatPlan(parametersGroup), ParamFormatPlan(parametersSeries),
+            ParamFormatPlan(parametersSweep), ParamFormatPlan(parametersTrace) }
+    {
+    }
+
+    const std::string& MetadataBlockCache::get(const hkTreeNode& node)
+    {
+        {
+            std::lock_guard lk(mtx);
+            if (auto it = blocks.find(&node); it != blocks.end()) {
+                return it->second;
+            }
+        }
+        // format without holding the lock, at worst a block is formatted twice by concurrent callers
+        std::string block;
+        append(node, block);
+        std::lock_guard lk(mtx);
+        // existing entries are kept, references to them might have been handed out already
+        return blocks.try_emplace(&node, std::move(block)).first->second;
+    }
+
+    void MetadataBlockCache::append(const hkTreeNode& node, std::string& buf) const
+    {
+        const auto level = node.getLevel();
+        if (level < hkTreeNode::LevelRoot || level > hkTreeNode::LevelTrace) {
+            throw std::out_of_range("node is not part of the pulse tree");
+        }
+        const auto& plan = plans[static_cast<std::size_t>(level)];
+        if (format == Format::WaveNote) {
+            plan.appendLines(node, buf, std::locale::classic());
+        }
+        else {
+            plan.appendJSON(node, buf, std::locale::classic());
+        }
+    }
+}
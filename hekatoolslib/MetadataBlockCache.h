@@ -0,0 +1,75 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef METADATA_BLOCK_CACHE_H
+#define METADATA_BLOCK_CACHE_H
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "hkTree.h"
+#include "PMparameters.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Formatted export parameters of the nodes of the pulse tree, used during export
+    /// so that the parameters of root, group, series and sweep are formatted only once,
+    /// not once for every trace below them.
+    /// The parameter selection (export flags) is fixed when the cache is created,
+    /// thus a cache should live for one export run only. Formatting is locale independent.
+    /// All methods are thread-safe, returned blocks stay valid for the lifetime of the cache.
+    /// </summary>
+    class MetadataBlockCache {
+    public:
+        enum class Format {
+            WaveNote, // lines "name=value unit" (cf. formatParamListExportIBW)
+            JSON // JSON object (cf. formatParamListExportJSON)
+        };
+
+        explicit MetadataBlockCache(Format format);
+        MetadataBlockCache(const MetadataBlockCache&) = delete;
+        MetadataBlockCache& operator=(const MetadataBlockCache&) = delete;
+
+        Format getFormat() const { return format; };
+
+        /// <summary>
+        /// get formatted parameters of node, formatted on first request
+        /// </summary>
+        /// <param name="node">node of pulse tree, usually an ancestor of a trace</param>
+        const std::string& get(const hkTreeNode& node);
+
+        /// <summary>
+        /// append formatted parameters of node to buf without storing them,
+        /// meant for traces, which are exported only once
+        /// </summary>
+        void append(const hkTreeNode& node, std::string& buf) const;
+
+    private:
+        Format format;
+        std::array<ParamFormatPlan, 5> plans; // one per level, root to trace
+        std::mutex mtx;
+        std::unordered_map<const hkTreeNode*, std::string> blocks;
+    };
+}
+
+#endif // !METADATA_BLOCK_CACHE_H
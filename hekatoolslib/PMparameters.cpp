@@ -17,7 +17,11 @@
 	along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <charconv>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <locale>
 #include <sstream>
 #include <iomanip>
 #include <array>
@@ -667,7 +671,7 @@ namespace hkLib {
 		// hack to choose correcly for holding voltage or current
 		if (node.getLevel() == hkTreeNode::LevelTrace && std::strcmp("V|A", unit) == 0)
 		{
-			int recording_mode = node.getChar(TrRecordingMode);
+			int recording_mode = node.get(Trace::RecordingMode);
 			if (recording_mode == CClamp) {
 				ss << 'A';
 			}
@@ -730,7 +734,7 @@ namespace hkLib {
             // hack to choose correctly for holding voltage or current
             if (node.getLevel() == hkTreeNode::LevelTrace && std::strcmp("V|A", unit) == 0)
             {
-                int recording_mode = node.getChar(TrRecordingMode);
+                int recording_mode = node.get(Trace::RecordingMode);
                 if (recording_mode == CClamp) {
                     ss << " A";
                 }
@@ -752,6 +756,241 @@ namespace hkLib {
 		s = ss.str();
 	}
 
+	namespace {
+		bool hasClassicNumbers(const std::locale& loc)
+		{
+			const auto& np = std::use_facet<std::numpunct<char>>(loc);
+			return np.decimal_point() == '.' && np.grouping().empty() &&
+				np.truename() == "true" && np.falsename() == "false";
+		}
+
+		template<typename T> void appendNumber(std::string& buf, T v)
+		{
+			char tmp[32];
+			const auto res = std::to_chars(std::begin(tmp), std::end(tmp), v);
+			buf.append(tmp, res.ptr);
+		}
+
+		// same as ostream with default flags and precision, i.e. %g
+		void appendNumber(std::string& buf, double v)
+		{
+			char tmp[32];
+			const auto res = std::to_chars(std::begin(tmp), std::end(tmp), v, std::chars_format::general, 6);
+			buf.append(tmp, res.ptr);
+		}
+
+		void appendBool(std::string& buf, bool b)
+		{
+			buf.append(b ? "true"sv : "false"sv);
+		}
+
+		void escapeQuotes(std::string& buf, std::size_t first)
+		{
+			if (buf.find('"', first) == std::string::npos) {
+				return;
+			}
+			const auto tmp = JSONescapeQuotes(std::string_view(buf).substr(first));
+			buf.replace(first, std::string::npos, tmp);
+		}
+	}
+
+	ParamFormatPlan::ParamFormatPlan(std::span<const PMparameter> params, Selection selection)
+	{
+		fields.reserve(params.size());
+		for (const auto& p : params) {
+			if (!(selection == Selection::All || (selection == Selection::Export && p.exportIBW) ||
+				(selection == Selection::Print && p.print))) {
+				continue;
+			}
+			Accessor accessor{ Accessor::Generic };
+			std::size_t size{ 0 };
+			switch (p.data_type) {
+			case PMparameter::Byte:
+			case PMparameter::Char:
+				accessor = Accessor::Int8; size = 1; break;
+			case PMparameter::Int16:
+				accessor = Accessor::Int16; size = 2; break;
+			case PMparameter::UInt16:
+				accessor = Accessor::UInt16; size = 2; break;
+			case PMparameter::Int32:
+				accessor = Accessor::Int32; size = 4; break;
+			case PMparameter::UInt32:
+				accessor = Accessor::UInt32; size = 4; break;
+			case PMparameter::LongReal:
+				accessor = Accessor::Double; size = 8; break;
+			case PMparameter::InvLongReal:
+				accessor = Accessor::InvDouble; size = 8; break;
+			case PMparameter::RelativeTime:
+				accessor = Accessor::RelativeTime; size = 8; break;
+			case PMparameter::DateTime:
+				accessor = Accessor::DateTime; size = 8; break;
+			case PMparameter::Boolean:
+				accessor = Accessor::Bool; size = 1; break;
+			case PMparameter::Set16_Bit5:
+				accessor = Accessor::Bit5; size = 2; break;
+			case PMparameter::String8:
+				accessor = Accessor::String8; size = 8; break;
+			case PMparameter::String16:
+				accessor = Accessor::String16; size = 16; break;
+			case PMparameter::String32:
+				accessor = Accessor::String32; size = 32; break;
+			case PMparameter::String80:
+				accessor = Accessor::String80; size = 80; break;
+			case PMparameter::String128:
+				accessor = Accessor::String128; size = 128; break;
+			case PMparameter::String400:
+				accessor = Accessor::String400; size = 400; break;
+			default:
+				break;
+			}
+			const bool json_quotes = std::find(format_json_needs_quotes.begin(),
+				format_json_needs_quotes.end(), p.data_type) != format_json_needs_quotes.end();
+			fields.push_back({ &p, accessor, p.offset, p.offset + size, json_quotes });
+			if (accessor != Accessor::Generic) {
+				required_size = std::max(required_size, p.offset + size);
+			}
+		}
+	}
+
+	void ParamFormatPlan::appendValue(const Field& f, const hkTreeNode& n, bool in_range, bool classic,
+		const std::locale& loc, std::string& buf) const
+	{
+		if (f.accessor == Accessor::Generic || (!classic && f.accessor < Accessor::String8)) {
+			std::ostringstream ss;
+			ss.imbue(loc);
+			f.param->formatValueOnly(n, ss);
+			buf.append(ss.view());
+			return;
+		}
+		if (!in_range && n.Data.size() < f.end) {
+			buf.append("n/a"sv);
+			return;
+		}
+		switch (f.accessor) {
+		case Accessor::Int8:
+			appendNumber(buf, int(n.extractValueNoCheck<char>(f.offset)));
+			break;
+		case Accessor::Int16:
+			appendNumber(buf, n.extractValueNoCheck<std::int16_t>(f.offset));
+			break;
+		case Accessor::UInt16:
+			appendNumber(buf, n.extractValueNoCheck<std::uint16_t>(f.offset));
+			break;
+		case Accessor::Int32:
+			appendNumber(buf, n.extractValueNoCheck<std::int32_t>(f.offset));
+			break;
+		case Accessor::UInt32:
+			appendNumber(buf, n.extractValueNoCheck<std::uint32_t>(f.offset));
+			break;
+		case Accessor::Double:
+			appendNumber(buf, n.extractValueNoCheck<double>(f.offset));
+			break;
+		case Accessor::InvDouble:
+			appendNumber(buf, 1.0 / n.extractValueNoCheck<double>(f.offset));
+			break;
+		case Accessor::RelativeTime: {
+			const double t = n.extractValueNoCheck<double>(f.offset) - n.getTime0();
+			char tmp[64];
+			const auto res = std::to_chars(std::begin(tmp), std::end(tmp), t, std::chars_format::fixed, 3);
+			if (res.ec == std::errc{}) {
+				buf.append(tmp, res.ptr);
+			}
+			else {
+				// too large for the buffer, never seen in real files
+				std::ostringstream ss;
+				ss.imbue(loc);
+				f.param->formatValueOnly(n, ss);
+				buf.append(ss.view());
+			}
+		}
+			break;
+		case Accessor::Bool:
+			appendBool(buf, n.extractValueNoCheck<char>(f.offset) != 0);
+			break;
+		case Accessor::Bit5:
+			appendBool(buf, n.extractValueNoCheck<std::uint16_t>(f.offset) & (1u << 5));
+			break;
+		case Accessor::String8:
+			buf.append(iso_8859_1_to_utf8(n.getString<8>(f.offset)));
+			break;
+		case Accessor::String16:
+			buf.append(iso_8859_1_to_utf8(n.getString<16>(f.offset)));
+			break;
+		case Accessor::String32:
+			buf.append(iso_8859_1_to_utf8(n.getString<32>(f.offset)));
+			break;
+		case Accessor::String80:
+			buf.append(iso_8859_1_to_utf8(n.getString<80>(f.offset)));
+			break;
+		case Accessor::String128:
+			buf.append(iso_8859_1_to_utf8(n.getString<128>(f.offset)));
+			break;
+		case Accessor::String400:
+			buf.append(iso_8859_1_to_utf8(n.getString<400>(f.offset)));
+			break;
+		case Accessor::DateTime:
+			buf.append(formatPMtimeUTC(n.extractValueNoCheck<double>(f.offset)));
+			break;
+		default:
+			break;
+		}
+	}
+
+	void ParamFormatPlan::appendTable(const hkTreeNode& n, std::string& buf, const std::locale& loc) const
+	{
+		const bool in_range = n.Data.size() >= required_size;
+		const bool classic = hasClassicNumbers(loc);
+		for (const auto& f : fields) {
+			buf.push_back('\t');
+			appendValue(f, n, in_range, classic, loc, buf);
+		}
+	}
+
+	void ParamFormatPlan::appendJSON(const hkTreeNode& n, std::string& buf, const std::locale& loc) const
+	{
+		const bool in_range = n.Data.size() >= required_size;
+		const bool classic = hasClassicNumbers(loc);
+		buf.append("{ "sv);
+		bool is_first{ true };
+		for (const auto& f : fields) {
+			if (is_first) {
+				is_first = false;
+			}
+			else {
+				buf.append(", "sv);
+			}
+			buf.push_back('"');
+			buf.append(f.param->name);
+			buf.append("\": "sv);
+			if (f.json_quotes) buf.push_back('"');
+			const auto first = buf.size();
+			appendValue(f, n, in_range, classic, loc, buf);
+			escapeQuotes(buf, first);
+			if (f.json_quotes) buf.push_back('"');
+		}
+		buf.append(" }"sv);
+	}
+
+	void ParamFormatPlan::appendLines(const hkTreeNode& n, std::string& buf, const std::locale& loc) const
+	{
+		const bool in_range = n.Data.size() >= required_size;
+		const bool classic = hasClassicNumbers(loc);
+		for (const auto& f : fields) {
+			buf.append(f.param->name);
+			buf.push_back('=');
+			appendValue(f, n, in_range, classic, loc, buf);
+			buf.push_back(' ');
+			// hack to choose correcly for holding voltage or current
+			if (n.getLevel() == hkTreeNode::LevelTrace && std::strcmp("V|A", f.param->unit) == 0) {
+				buf.push_back(n.get(Trace::RecordingMode) == CClamp ? 'A' : 'V');
+			}
+			else {
+				buf.append(f.param->unit);
+			}
+			buf.push_back('\n');
+		}
+	}
+
 	void formatParamTabbedListPrint(const hkTreeNode& n, const std::span<PMparameter>& ar, std::ostream& ss)
 	{
 		for (const PMparameter& p : ar) {
@@ -801,8 +1040,8 @@ namespace hkLib {
 		std::ostringstream s;
 		hkTreeNode amprecord;
 		amprecord.isSwapped = series.getIsSwapped();
-		auto ampstateflag = series.extractInt32(SeAmplStateFlag);
-		auto ampstateref = series.extractInt32(SeAmplStateRef);
+		auto ampstateflag = series.get(Series::AmplStateFlag);
+		auto ampstateref = series.get(Series::AmplStateRef);
 		if (ampstateflag > 0 || ampstateref == 0)
 		{
 			// use local amp state record
@@ -816,7 +1055,7 @@ namespace hkLib {
 			const auto &ampse = amproot.Children.at(static_cast<std::size_t>(ampstateref) - 1); // Is this correct? Or seCount?
 			for (const auto &ampre : ampse.Children)
 			{ // there might be multiple amplifiers
-				auto ampstatecount = ampre.extractInt32(AmStateCount);
+				auto ampstatecount = ampre.get(AmpState::StateCount);
 				amprecord.Data = ampre.Data.subspan(AmAmplifierState, AmplifierStateSize);
 				s << "Amplifier State (Amp #"sv << ampstatecount << "):\n"sv;
 				formatParamTabbedListPrint(amprecord, parametersAmpplifierState, s);
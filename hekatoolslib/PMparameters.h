@@ -22,11 +22,13 @@
 
 #pragma once
 #include <array>
+#include <locale>
 #include <string>
 #include <sstream>
 #include <ostream>
 #include <string_view>
 #include <span>
+#include <vector>
 #include "hkTree.h"
 #include "DatFile.h"
 
@@ -133,6 +135,58 @@ namespace hkLib {
     extern std::array<PMparameter, 31> parametersStimulation;
     extern std::array<PMparameter, 6> parametersStimRoot;
 
+	/// <summary>
+	/// Compiled formatter for the selected parameters of a parameter array.
+	/// Selection and data type of each parameter are resolved once, when the plan is built.
+	/// Values are written with std::to_chars into a caller supplied buffer,
+	/// the output is identical to that of PMparameter::formatValueOnly (precision 6).
+	/// Plans refer to the parameter array, so they must be rebuilt if the flags change.
+	/// </summary>
+	class ParamFormatPlan {
+	public:
+		enum class Selection { Export, Print, All };
+		explicit ParamFormatPlan(std::span<const PMparameter> params, Selection selection = Selection::Export);
+
+		/// <summary>
+		/// append values, each preceded by a tab (cf. formatParamListExportTable)
+		/// </summary>
+		/// <param name="n">node containing data</param>
+		/// <param name="buf">buffer to append to</param>
+		/// <param name="loc">locale used for numbers, for the classic locale no streams are involved</param>
+		void appendTable(const hkTreeNode& n, std::string& buf, const std::locale& loc) const;
+
+		/// <summary>
+		/// append values as JSON object (cf. formatParamListExportJSON)
+		/// </summary>
+		void appendJSON(const hkTreeNode& n, std::string& buf, const std::locale& loc) const;
+
+		/// <summary>
+		/// append one line "name=value unit" per parameter (cf. formatParamListExportIBW)
+		/// </summary>
+		void appendLines(const hkTreeNode& n, std::string& buf, const std::locale& loc) const;
+
+		std::size_t size() const { return fields.size(); };
+
+	private:
+		// accessors before String8 depend on the numeric facets of the locale
+		enum class Accessor : unsigned char {
+			Int8, Int16, UInt16, Int32, UInt32, Double, InvDouble, RelativeTime, Bool, Bit5,
+			String8, String16, String32, String80, String128, String400, DateTime,
+			Generic // anything else, formatted by PMparameter::formatValueOnly
+		};
+		struct Field {
+			const PMparameter* param;
+			Accessor accessor;
+			std::size_t offset, end; // end: record size needed to read the value
+			bool json_quotes;
+		};
+		void appendValue(const Field& f, const hkTreeNode& n, bool in_range, bool classic,
+			const std::locale& loc, std::string& buf) const;
+
+		std::vector<Field> fields;
+		std::size_t required_size{ 0 }; // record size needed to read all values without checks
+	};
+
 	/// <summary>
 	/// Format parameters stored in node n using
 	/// all parameters defined in array ar
@@ -176,39 +230,23 @@ namespace hkLib {
 	template<std::size_t Nrows> void formatParamListExportIBW(const hkTreeNode& n,
 		const std::array<PMparameter, Nrows>& ar, std::ostream& ss)
 	{
-		for (const PMparameter& p : ar) {
-			if (p.exportIBW) {
-				p.format(n, ss);
-				ss << "\n";
-			}
-		}
+		std::string buf;
+		ParamFormatPlan(ar).appendLines(n, buf, ss.getloc());
+		ss << buf;
 	}
 
 	template<std::size_t Nrows> void formatParamListExportJSON(const hkTreeNode& n,
 		const std::array<PMparameter, Nrows>& ar, std::ostream& ss)
 	{
-		ss << "{ ";
-		bool is_first{ true };
-		for (const PMparameter& p : ar) {
-			if (p.exportIBW) {
-				if (is_first) {
-					is_first = false;
-				}
-				else {
-					ss << ", ";
-				}
-				p.formatJSON(n, ss);
-			}
-		}
-		ss << " }";
+		std::string buf;
+		ParamFormatPlan(ar).appendJSON(n, buf, ss.getloc());
+		ss << buf;
 	}
 
 	template<std::size_t Nrows> void formatParamListExportIBW(const hkTreeNode& n,
 		const std::array<PMparameter, Nrows>& ar, std::string& str)
 	{
-		std::stringstream ss;
-		formatParamListExportIBW(n, ar, ss);
-		str.append(ss.str());
+		ParamFormatPlan(ar).appendLines(n, str, std::locale());
 	}
 
 	/// <summary>
@@ -244,13 +282,9 @@ namespace hkLib {
 	template<std::size_t Nrows> std::ostream& formatParamListExportTable(const hkTreeNode& n,
 		const std::array<PMparameter, Nrows>& ar, std::ostream& ss)
 	{
-		for (const auto& p : ar) {
-			if (p.exportIBW) {
-				ss << '\t';
-				p.formatValueOnly(n, ss);
-			}
-		}
-		return ss;
+		std::string buf;
+		ParamFormatPlan(ar).appendTable(n, buf, ss.getloc());
+		return ss << buf;
 	}
 
 	/// <summary>
@@ -262,9 +296,9 @@ namespace hkLib {
 	template<std::size_t Nrows> std::string formatParamListExportTable(const hkTreeNode& n,
 		const std::array<PMparameter, Nrows>& ar)
 	{
-		std::stringstream ss;
-		formatParamListExportTable(n, ar, ss);
-		return ss.str();
+		std::string buf;
+		ParamFormatPlan(ar).appendTable(n, buf, std::locale());
+		return buf;
 	}
 
 	/// @brief Format Amplifier Paramter associated with series record as tab delimited list for export as table
@@ -0,0 +1,151 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARALLEL_PIPELINE_H
+#define PARALLEL_PIPELINE_H
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hkLib {
+
+    /// <summary>
+    /// number of worker threads to use if 0 (i.e. automatic) is requested
+    /// </summary>
+    inline unsigned DefaultThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// <summary>
+    /// Process items 0..n-1 in two overlapping stages: produce(i) runs concurrently on a pool
+    /// of worker threads (items are handed out in increasing order), consume(i, result) runs
+    /// on the calling thread strictly in index order, so output that must be sequential
+    /// (e.g. writing into a single file or a log) stays deterministic.
+    /// At most a few results per thread are buffered. If produce or consume throws,
+    /// the remaining items are skipped and the first exception is rethrown after all workers finished.
+    /// With one thread (or a single item), everything runs on the calling thread.
+    /// </summary>
+    /// <param name="n">number of items</param>
+    /// <param name="num_threads">number of worker threads, 0 for DefaultThreadCount()</param>
+    /// <param name="produce">callable R(std::size_t index), must be safe to call concurrently, R must not be void</param>
+    /// <param name="consume">callable void(std::size_t index, R&amp;&amp; result)</param>
+    template<typename Produce, typename Consume> void RunOrderedPipeline(std::size_t n, unsigned num_threads,
+        Produce&& produce, Consume&& consume)
+    {
+        using Result = std::invoke_result_t<Produce&, std::size_t>;
+        static_assert(!std::is_void_v<Result>, "produce must return a result");
+        if (num_threads == 0) {
+            num_threads = DefaultThreadCount();
+        }
+        num_threads = static_cast<unsigned>(std::min<std::size_t>(num_threads, n));
+        if (num_threads <= 1) {
+            for (std::size_t i = 0; i < n; ++i) {
+                consume(i, produce(i));
+            }
+            return;
+        }
+        // result of item i goes to slot i % window, it is free once item i - window has been consumed
+        const std::size_t window = 4 * std::size_t(num_threads);
+        std::vector<std::optional<Result>> slots(window);
+        std::mutex mtx;
+        std::condition_variable cv_workers, cv_consumer;
+        std::size_t next = 0, consumed = 0;
+        bool stop = false;
+        std::exception_ptr error;
+        auto fail = [&](std::exception_ptr e) { // mtx must be locked
+            if (!error) {
+                error = std::move(e);
+            }
+            stop = true;
+            cv_workers.notify_all();
+            cv_consumer.notify_all();
+        };
+        auto work = [&] {
+            std::unique_lock lk(mtx);
+            while (true) {
+                cv_workers.wait(lk, [&] { return stop || next >= n || next < consumed + window; });
+                if (stop || next >= n) {
+                    return;
+                }
+                const auto i = next++;
+                lk.unlock();
+                try {
+                    auto result = produce(i);
+                    lk.lock();
+                    slots[i % window].emplace(std::move(result));
+                    cv_consumer.notify_one();
+                }
+                catch (...) {
+                    if (!lk.owns_lock()) {
+                        lk.lock();
+                    }
+                    fail(std::current_exception());
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(num_threads);
+        for (unsigned k = 0; k < num_threads; ++k) {
+            workers.emplace_back(work);
+        }
+        {
+            std::unique_lock lk(mtx);
+            while (consumed < n) {
+                auto& slot = slots[consumed % window];
+                cv_consumer.wait(lk, [&] { return stop || slot.has_value(); });
+                if (stop) {
+                    break;
+                }
+                auto result = std::move(*slot);
+                slot.reset();
+                lk.unlock();
+                try {
+                    consume(consumed, std::move(result));
+                }
+                catch (...) {
+                    lk.lock();
+                    fail(std::current_exception());
+                    break;
+                }
+                lk.lock();
+                ++consumed;
+                cv_workers.notify_all();
+            }
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+#endif // !PARALLEL_PIPELINE_H
@@ -0,0 +1,405 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include "helpers.h"
+#include "ParallelPipeline.h"
+#include "ParameterTable.h"
+
+namespace hkLib {
+
+    namespace {
+        using ColumnType = ParameterTable::ColumnType;
+
+        /// <summary>
+        /// decode rows [first, last) of a column, value(node) returns an optional value, the column type is dispatched
+        /// once per column rather than per cell
+        /// </summary>
+        template<typename Target, typename Value> void decodeRows(std::vector<Target>& target, std::vector<unsigned char>& available,
+            std::span<const hkTreeNode> nodes, std::size_t first, std::size_t last, Value&& value)
+        {
+            for (std::size_t row = first; row < last; ++row) {
+                if (auto v = value(nodes[row])) {
+                    target[row] = static_cast<Target>(*v);
+                    available[row] = 1;
+                }
+            }
+        }
+
+        template<typename T> auto integerDecoder(std::size_t offset)
+        {
+            return [offset](const hkTreeNode& n) { return n.extractValueOpt<T>(offset); };
+        }
+
+        template<std::size_t N> auto textDecoder(std::size_t offset)
+        {
+            return [offset](const hkTreeNode& n) {
+                return n.Data.size() >= offset + N ? std::optional(n.getString<N>(offset)) : std::nullopt; };
+        }
+
+        /// <summary>
+        /// call f with a function object returning the optional value of param for a node:
+        /// double for ColumnType::Real, std::string_view for ColumnType::Text, an integral type otherwise.
+        /// The type of the parameter is dispatched once, not per node.
+        /// </summary>
+        template<typename F> void withDecoder(const PMparameter& param, F&& f)
+        {
+            const auto offset = param.offset;
+            switch (param.data_type) {
+            case PMparameter::LongReal:
+            case PMparameter::DateTime:
+                f([offset](const hkTreeNode& n) { return n.extractValueOpt<double>(offset); });
+                break;
+            case PMparameter::InvLongReal:
+                f([offset](const hkTreeNode& n) {
+                    auto v = n.extractValueOpt<double>(offset);
+                    return v ? std::optional(1.0 / *v) : std::nullopt; });
+                break;
+            case PMparameter::RelativeTime:
+                f([offset](const hkTreeNode& n) {
+                    auto v = n.extractValueOpt<double>(offset);
+                    return v ? std::optional(*v - n.getTime0()) : std::nullopt; });
+                break;
+            case PMparameter::Int16:
+                f(integerDecoder<std::int16_t>(offset));
+                break;
+            case PMparameter::UInt16:
+            case PMparameter::Set16:
+                f(integerDecoder<std::uint16_t>(offset));
+                break;
+            case PMparameter::Int32:
+            case PMparameter::seSourceName:
+                f(integerDecoder<std::int32_t>(offset));
+                break;
+            case PMparameter::UInt32:
+                f(integerDecoder<std::uint32_t>(offset));
+                break;
+            case PMparameter::Boolean:
+                f([offset](const hkTreeNode& n) {
+                    auto v = n.extractValueOpt<char>(offset);
+                    return v ? std::optional(*v != 0) : std::nullopt; });
+                break;
+            case PMparameter::Set16_Bit5:
+                f([offset](const hkTreeNode& n) {
+                    auto v = n.extractValueOpt<std::uint16_t>(offset);
+                    return v ? std::optional((*v >> 5) & 1) : std::nullopt; });
+                break;
+            case PMparameter::String8:
+                f(textDecoder<8>(offset));
+                break;
+            case PMparameter::String16:
+                f(textDecoder<16>(offset));
+                break;
+            case PMparameter::String32:
+                f(textDecoder<32>(offset));
+                break;
+            case PMparameter::String80:
+                f(textDecoder<80>(offset));
+                break;
+            case PMparameter::String128:
+                f(textDecoder<128>(offset));
+                break;
+            case PMparameter::String400:
+                f(textDecoder<400>(offset));
+                break;
+            default:
+                // single byte values and codes of named enumerations
+                f(integerDecoder<char>(offset));
+                break;
+            }
+        }
+
+        template<typename Decoder> using DecodedType = typename std::invoke_result_t<Decoder, const hkTreeNode&>::value_type;
+
+        void decodeColumn(ParameterTable::Column& c, std::span<const hkTreeNode> nodes, std::size_t first, std::size_t last)
+        {
+            withDecoder(*c.param, [&](auto value) {
+                using T = DecodedType<decltype(value)>;
+                if constexpr (std::is_same_v<T, double>) {
+                    decodeRows(c.reals, c.available, nodes, first, last, value);
+                }
+                else if constexpr (std::is_same_v<T, std::string_view>) {
+                    decodeRows(c.texts, c.available, nodes, first, last, value);
+                }
+                else {
+                    decodeRows(c.integers, c.available, nodes, first, last, value);
+                }
+            });
+        }
+
+        std::vector<const PMparameter*> selectParameters(std::span<const PMparameter> params,
+            ParamFormatPlan::Selection selection)
+        {
+            std::vector<const PMparameter*> selected;
+            for (const auto& p : params) {
+                if (selection == ParamFormatPlan::Selection::All || (selection == ParamFormatPlan::Selection::Export && p.exportIBW)
+                    || (selection == ParamFormatPlan::Selection::Print && p.print)) {
+                    selected.push_back(&p);
+                }
+            }
+            return selected;
+        }
+    }
+
+    std::optional<ParameterTable::ColumnType> ParameterTable::columnTypeOf(const PMparameter& param)
+    {
+        // only parameters with a single value, no arrays and composite values
+        switch (param.data_type) {
+        case PMparameter::LongReal:
+        case PMparameter::InvLongReal:
+        case PMparameter::DateTime:
+        case PMparameter::RelativeTime:
+            return ColumnType::Real;
+        case PMparameter::Byte:
+        case PMparameter::Char:
+        case PMparameter::Int16:
+        case PMparameter::UInt16:
+        case PMparameter::Set16:
+        case PMparameter::Int32:
+        case PMparameter::UInt32:
+        case PMparameter::Boolean:
+        case PMparameter::Set16_Bit5:
+        case PMparameter::RecordingMode:
+        case PMparameter::StimIncrementMode:
+        case PMparameter::StimSegmentClass:
+        case PMparameter::AmpModeName:
+        case PMparameter::ExtTriggerTypeName:
+        case PMparameter::AmplModeType:
+        case PMparameter::AdcTypeName:
+        case PMparameter::seSourceName:
+        case PMparameter::SegStoreType:
+            return ColumnType::Integer;
+        case PMparameter::String8:
+        case PMparameter::String16:
+        case PMparameter::String32:
+        case PMparameter::String80:
+        case PMparameter::String128:
+        case PMparameter::String400:
+            return ColumnType::Text;
+        default:
+            return std::nullopt;
+        }
+    }
+
+    ParameterTable::ParameterTable(hkTree& tree, int level, std::span<const PMparameter> params,
+        ParamFormatPlan::Selection selection, unsigned num_threads)
+        : ParameterTable(tree, level, selectParameters(params, selection), num_threads)
+    {
+    }
+
+    ParameterTable::ParameterTable(hkTree& tree, int level, std::span<const PMparameter* const> params, unsigned num_threads)
+        : nodes{ tree.GetLevelNodes(level) }
+    {
+        cols.reserve(params.size());
+        for (const auto* p : params) {
+            const auto type = columnTypeOf(*p);
+            if (!type) {
+                continue;
+            }
+            auto& c = cols.emplace_back();
+            c.param = p;
+            c.type = *type;
+            switch (c.type) {
+            case ColumnType::Real:
+                c.reals.resize(nodes.size(), std::numeric_limits<double>::quiet_NaN());
+                break;
+            case ColumnType::Integer:
+                c.integers.resize(nodes.size());
+                break;
+            case ColumnType::Text:
+                c.texts.resize(nodes.size());
+                break;
+            }
+            c.available.resize(nodes.size());
+        }
+        decode(num_threads);
+    }
+
+    void ParameterTable::decode(unsigned num_threads)
+    {
+        // each thread decodes a contiguous block of rows for all columns, so no two threads write to the same element
+        auto decodeRows = [this](std::size_t first, std::size_t last) {
+            for (auto& c : cols) {
+                decodeColumn(c, nodes, first, last);
+            }
+        };
+        if (num_threads == 0) {
+            num_threads = DefaultThreadCount();
+        }
+        // not worth starting threads for small tables
+        constexpr std::size_t MinRowsPerThread = 1024;
+        num_threads = static_cast<unsigned>(std::clamp<std::size_t>(nodes.size() / MinRowsPerThread, 1, num_threads));
+        if (num_threads == 1) {
+            decodeRows(0, nodes.size());
+            return;
+        }
+        const std::size_t block = (nodes.size() + num_threads - 1) / num_threads;
+        std::vector<std::jthread> workers;
+        workers.reserve(num_threads - 1);
+        for (unsigned k = 1; k < num_threads; ++k) {
+            workers.emplace_back(decodeRows, std::min(k * block, nodes.size()), std::min((k + 1) * block, nodes.size()));
+        }
+        decodeRows(0, block);
+    }
+
+    double ParameterTable::numericValueOf(const PMparameter& param, const hkTreeNode& node)
+    {
+        double result = std::numeric_limits<double>::quiet_NaN();
+        withDecoder(param, [&](auto value) {
+            if constexpr (std::is_same_v<DecodedType<decltype(value)>, std::string_view>) {
+                throw std::invalid_argument("parameter is not numeric");
+            }
+            else if (auto v = value(node)) {
+                result = static_cast<double>(*v);
+            }
+        });
+        return result;
+    }
+
+    std::optional<std::string_view> ParameterTable::textValueOf(const PMparameter& param, const hkTreeNode& node)
+    {
+        std::optional<std::string_view> result;
+        withDecoder(param, [&](auto value) {
+            if constexpr (std::is_same_v<DecodedType<decltype(value)>, std::string_view>) {
+                result = value(node);
+            }
+            else {
+                throw std::invalid_argument("parameter is not a text");
+            }
+        });
+        return result;
+    }
+
+    std::optional<std::size_t> ParameterTable::findColumn(std::string_view name) const
+    {
+        for (std::size_t col = 0; col < cols.size(); ++col) {
+            if (name == cols[col].param->name) {
+                return col;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::size_t> ParameterTable::rowOf(const hkTreeNode& n) const
+    {
+        // nodes of a level are stored contiguously
+        if (nodes.empty() || &n < nodes.data() || &n >= nodes.data() + nodes.size()) {
+            return std::nullopt;
+        }
+        return static_cast<std::size_t>(&n - nodes.data());
+    }
+
+    double ParameterTable::numericValue(std::size_t col, std::size_t row) const
+    {
+        const auto& c = cols.at(col);
+        switch (c.type) {
+        case ColumnType::Real:
+            return c.reals.at(row);
+        case ColumnType::Integer:
+            return c.available.at(row) ? static_cast<double>(c.integers[row]) : std::numeric_limits<double>::quiet_NaN();
+        default:
+            throw std::invalid_argument("parameter is not numeric");
+        }
+    }
+
+    std::vector<std::size_t> ParameterTable::selectRange(std::size_t col, double min, double max) const
+    {
+        const auto& c = cols.at(col);
+        std::vector<std::size_t> result;
+        switch (c.type) {
+        case ColumnType::Real:
+            // NaN (i.e. unavailable) fails both comparisons
+            for (std::size_t row = 0; row < c.reals.size(); ++row) {
+                if (c.reals[row] >= min && c.reals[row] <= max) {
+                    result.push_back(row);
+                }
+            }
+            break;
+        case ColumnType::Integer:
+            for (std::size_t row = 0; row < c.integers.size(); ++row) {
+                const auto v = static_cast<double>(c.integers[row]);
+                if (c.available[row] && v >= min && v <= max) {
+                    result.push_back(row);
+                }
+            }
+            break;
+        default:
+            throw std::invalid_argument("parameter is not numeric");
+        }
+        return result;
+    }
+
+    void ParameterTable::writeTable(std::ostream& os, char separator) const
+    {
+        std::string buf;
+        for (std::size_t col = 0; col < cols.size(); ++col) {
+            if (col > 0) {
+                buf.push_back(separator);
+            }
+            buf.append(cols[col].param->name);
+            if (*cols[col].param->unit) {
+                buf.push_back('[');
+                buf.append(cols[col].param->unit);
+                buf.push_back(']');
+            }
+        }
+        buf.push_back('\n');
+        for (std::size_t row = 0; row < nodes.size(); ++row) {
+            for (std::size_t col = 0; col < cols.size(); ++col) {
+                const auto& c = cols[col];
+                if (col > 0) {
+                    buf.push_back(separator);
+                }
+                if (!c.available[row]) {
+                    buf.append("n/a");
+                    continue;
+                }
+                char tmp[32];
+                switch (c.type) {
+                case ColumnType::Real: {
+                    const auto res = std::to_chars(std::begin(tmp), std::end(tmp), c.reals[row], std::chars_format::general, 6);
+                    buf.append(tmp, res.ptr);
+                }
+                    break;
+                case ColumnType::Integer: {
+                    const auto res = std::to_chars(std::begin(tmp), std::end(tmp), c.integers[row]);
+                    buf.append(tmp, res.ptr);
+                }
+                    break;
+                case ColumnType::Text:
+                    buf.append(iso_8859_1_to_utf8(c.texts[row]));
+                    break;
+                }
+            }
+            buf.push_back('\n');
+            if (buf.size() > 0x10000) {
+                os << buf;
+                buf.clear();
+            }
+        }
+        os << buf;
+    }
+}
@@ -0,0 +1,138 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARAMETER_TABLE_H
+#define PARAMETER_TABLE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "hkTree.h"
+#include "PMparameters.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Parameters of all nodes of one tree level (e.g. all series or all traces), decoded once
+    /// into typed contiguous columns, one row per node in the order of hkTree::GetLevelNodes.
+    /// Filtering or exporting many nodes can then run over the columns instead of
+    /// formatting each parameter of each node (cf. PMparameter::format).
+    /// Only parameters with a single value are tabulated, arrays and user parameter descriptions are skipped.
+    /// The table refers to the tree data (text columns, nodes), so it must not outlive the tree.
+    /// </summary>
+    class ParameterTable {
+    public:
+        enum class ColumnType {
+            Real, //!< doubles, incl. inverted values and relative times as shown by PMparameter::format
+            Integer, //!< integers, booleans and codes of named enumerations (e.g. recording mode)
+            Text //!< string views into the tree data, ISO-8859-1 encoded
+        };
+
+        struct Column {
+            const PMparameter* param;
+            ColumnType type;
+            std::vector<double> reals; //!< ColumnType::Real, NaN if not available
+            std::vector<std::int64_t> integers; //!< ColumnType::Integer, 0 if not available
+            std::vector<std::string_view> texts; //!< ColumnType::Text, empty if not available
+            std::vector<unsigned char> available; //!< per row, false if the record is too short
+        };
+
+        /// <summary>
+        /// decode the selected parameters for all nodes of a level
+        /// </summary>
+        /// <param name="tree">tree containing the nodes</param>
+        /// <param name="level">tree level</param>
+        /// <param name="params">parameter array for this level, e.g. parametersSeries</param>
+        /// <param name="selection">parameters to include</param>
+        /// <param name="num_threads">number of threads used for decoding, 0 for DefaultThreadCount()</param>
+        ParameterTable(hkTree& tree, int level, std::span<const PMparameter> params,
+            ParamFormatPlan::Selection selection = ParamFormatPlan::Selection::All, unsigned num_threads = 1);
+
+        /// <summary>
+        /// decode the given parameters (which need not belong to the same array) for all nodes of a level
+        /// </summary>
+        ParameterTable(hkTree& tree, int level, std::span<const PMparameter* const> params, unsigned num_threads = 1);
+
+        /// <summary>
+        /// type of the column for a parameter, nullopt if the parameter is not tabulated (arrays etc.)
+        /// </summary>
+        static std::optional<ColumnType> columnTypeOf(const PMparameter& param);
+
+        /// <summary>
+        /// Value of a numeric parameter of a single node as it would appear in a table
+        /// (see numericValue), for evaluating a few nodes without decoding a whole level.
+        /// Throws std::invalid_argument for text parameters.
+        /// </summary>
+        static double numericValueOf(const PMparameter& param, const hkTreeNode& node);
+
+        /// <summary>
+        /// value of a text parameter of a single node, nullopt if not available,
+        /// throws std::invalid_argument for numeric parameters
+        /// </summary>
+        static std::optional<std::string_view> textValueOf(const PMparameter& param, const hkTreeNode& node);
+
+        std::size_t rows() const { return nodes.size(); };
+        std::span<const Column> columns() const { return cols; };
+        const Column& column(std::size_t col) const { return cols.at(col); };
+        hkTreeNode& node(std::size_t row) const { return nodes[row]; };
+
+        /// <summary>
+        /// find column by parameter name
+        /// </summary>
+        /// <returns>index of column or nullopt if there is no such column</returns>
+        std::optional<std::size_t> findColumn(std::string_view name) const;
+
+        /// <summary>
+        /// row of a node, if it belongs to the level of this table
+        /// </summary>
+        std::optional<std::size_t> rowOf(const hkTreeNode& n) const;
+
+        /// <summary>
+        /// value of a numeric column as double, NaN if not available
+        /// </summary>
+        double numericValue(std::size_t col, std::size_t row) const;
+
+        /// <summary>
+        /// rows with min &lt;= value &lt;= max in a numeric column, rows with unavailable values are excluded
+        /// </summary>
+        /// <returns>row indices in increasing order</returns>
+        std::vector<std::size_t> selectRange(std::size_t col, double min, double max) const;
+
+        /// <summary>
+        /// write a header line "name[unit]" and one line per row, values separated by separator,
+        /// numbers are written with precision 6 (as PMparameter::formatValueOnly with the classic locale),
+        /// codes of named enumerations as numbers, unavailable values as "n/a"
+        /// </summary>
+        void writeTable(std::ostream& os, char separator = '\t') const;
+
+    private:
+        void decode(unsigned num_threads);
+
+        std::span<hkTreeNode> nodes;
+        std::vector<Column> cols;
+    };
+}
+
+#endif // !PARAMETER_TABLE_H
@@ -0,0 +1,145 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "PositionalReader.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hkLib {
+
+    PositionalReader::PositionalReader(std::shared_ptr<MappedFile> mapping) : p_mapping{ std::move(mapping) }
+    {
+        if (!p_mapping) {
+            throw std::invalid_argument("no file mapping");
+        }
+        length = p_mapping->size();
+    }
+
+    std::span<const char> PositionalReader::mappedData() const
+    {
+        if (!p_mapping) {
+            return {};
+        }
+        return p_mapping->span();
+    }
+
+#ifdef _WIN32
+    PositionalReader::PositionalReader(const std::filesystem::path& path)
+    {
+        h_file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (h_file == INVALID_HANDLE_VALUE) {
+            h_file = nullptr;
+            throw std::runtime_error("cannot open file");
+        }
+        LARGE_INTEGER filesize{};
+        if (!::GetFileSizeEx(h_file, &filesize)) {
+            ::CloseHandle(h_file);
+            throw std::runtime_error("cannot get file size");
+        }
+        if (!std::in_range<std::size_t>(filesize.QuadPart)) {
+            ::CloseHandle(h_file);
+            throw std::runtime_error("file too large");
+        }
+        length = static_cast<std::size_t>(filesize.QuadPart);
+    }
+
+    PositionalReader::~PositionalReader()
+    {
+        if (h_file) {
+            ::CloseHandle(h_file);
+        }
+    }
+#else
+    PositionalReader::PositionalReader(const std::filesystem::path& path)
+    {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("cannot open file, ") + std::strerror(errno));
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("cannot get file size, ") + std::strerror(errno));
+        }
+        if (!std::in_range<std::size_t>(st.st_size)) {
+            ::close(fd);
+            throw std::runtime_error("file too large");
+        }
+        length = static_cast<std::size_t>(st.st_size);
+    }
+
+    PositionalReader::~PositionalReader()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#endif // _WIN32
+
+    void PositionalReader::read(std::size_t pos, char* target, std::size_t count) const
+    {
+        if (pos > length || count > length - pos) {
+            throw std::runtime_error("error while reading datafile");
+        }
+        if (p_mapping) {
+            std::memcpy(target, p_mapping->data() + pos, count);
+            return;
+        }
+        while (count > 0) {
+#ifdef _WIN32
+            // on a synchronous handle, the offset in OVERLAPPED is used instead of the file pointer
+            OVERLAPPED ov{};
+            ov.Offset = static_cast<DWORD>(std::uint64_t(pos) & 0xffffffffu);
+            ov.OffsetHigh = static_cast<DWORD>(std::uint64_t(pos) >> 32);
+            DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(count, 1u << 30)), nread = 0;
+            if (!::ReadFile(h_file, target, chunk, &nread, &ov) || nread == 0) {
+                throw std::runtime_error("error while reading datafile");
+            }
+#else
+            auto nread = ::pread(fd, target, count, static_cast<off_t>(pos));
+            if (nread < 0 && errno == EINTR) {
+                continue;
+            }
+            if (nread <= 0) {
+                throw std::runtime_error("error while reading datafile");
+            }
+#endif
+            pos += static_cast<std::size_t>(nread);
+            target += nread;
+            count -= static_cast<std::size_t>(nread);
+        }
+    }
+}
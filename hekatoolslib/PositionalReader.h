@@ -0,0 +1,82 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef POSITIONAL_READER_H
+#define POSITIONAL_READER_H
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include "MappedFile.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Read-only access to a file by absolute offset (pread() on POSIX, ReadFile() with
+    /// an explicit offset on Windows). Unlike a std::istream there is no shared file position,
+    /// so one reader can be used by any number of threads concurrently.
+    /// Alternatively, the reader can operate on a memory mapping, in which case
+    /// readers that know about it access the mapped memory directly.
+    /// </summary>
+    class PositionalReader {
+    public:
+        /// <summary>
+        /// open file for reading, throws std::runtime_error if this fails
+        /// </summary>
+        /// <param name="path">file to be read</param>
+        explicit PositionalReader(const std::filesystem::path& path);
+
+        /// <summary>
+        /// read from an existing memory mapping
+        /// </summary>
+        /// <param name="mapping">mapping of the file, must not be null</param>
+        explicit PositionalReader(std::shared_ptr<MappedFile> mapping);
+        ~PositionalReader();
+        PositionalReader(const PositionalReader&) = delete;
+        PositionalReader& operator=(const PositionalReader&) = delete;
+
+        /// <summary>
+        /// Read count bytes starting at file offset pos into target.
+        /// Throws std::runtime_error if not all bytes could be read.
+        /// </summary>
+        void read(std::size_t pos, char* target, std::size_t count) const;
+
+        std::size_t size() const { return length; }; //!< file size in bytes
+
+        /// <summary>
+        /// complete file content if reader operates on a memory mapping, empty span otherwise
+        /// </summary>
+        std::span<const char> mappedData() const;
+        const std::shared_ptr<MappedFile>& getMapping() const { return p_mapping; };
+
+    private:
+        std::shared_ptr<MappedFile> p_mapping{};
+        std::size_t length{};
+#ifdef _WIN32
+        void* h_file{};
+#else
+        int fd{ -1 };
+#endif
+    };
+}
+
+#endif // !POSITIONAL_READER_H
@@ -0,0 +1,147 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** \file
+ * typed descriptors (hkField, hkStringField) of the record fields used in code,
+ * one namespace per record type, e.g. node.get(Trace::DataScaler)
+ */
+
+#ifndef RECORD_FIELDS_H
+#define RECORD_FIELDS_H
+
+#pragma once
+
+#include <cstdint>
+#include "hkTree.h"
+
+namespace hkLib {
+
+    // pul tree
+
+    namespace Root {
+        constexpr auto L = hkTreeNode::LevelRoot;
+        constexpr hkStringField<32, RoVersionName, L> VersionName{};
+        constexpr hkField<double, RoStartTime, L> StartTime{};
+    }
+
+    namespace Group {
+        constexpr auto L = hkTreeNode::LevelGroup;
+        constexpr hkStringField<32, GrLabel, L> Label{};
+        constexpr hkField<std::int32_t, GrGroupCount, L> GroupCount{};
+    }
+
+    namespace Series {
+        constexpr auto L = hkTreeNode::LevelSeries;
+        constexpr hkStringField<32, SeLabel, L> Label{};
+        constexpr hkField<std::int32_t, SeSeriesCount, L> SeriesCount{};
+        constexpr hkField<std::int32_t, SeAmplStateFlag, L> AmplStateFlag{};
+        constexpr hkField<std::int32_t, SeAmplStateRef, L> AmplStateRef{};
+        constexpr hkField<double, SeTime, L> Time{};
+    }
+
+    namespace Sweep {
+        constexpr auto L = hkTreeNode::LevelSweep;
+        constexpr hkStringField<32, SwLabel, L> Label{};
+        constexpr hkField<std::int32_t, SwStimCount, L> StimCount{};
+        constexpr hkField<std::int32_t, SwSweepCount, L> SweepCount{};
+        constexpr hkField<double, SwTime, L> Time{};
+        constexpr hkField<double, SwTimer, L> Timer{};
+    }
+
+    namespace Trace {
+        constexpr auto L = hkTreeNode::LevelTrace;
+        constexpr hkStringField<32, TrLabel, L> Label{};
+        constexpr hkField<std::int32_t, TrTraceID, L> TraceID{}; // TraceCount in older versions
+        constexpr hkField<std::uint32_t, TrData, L> Data{}; // file offset of the data
+        constexpr hkField<std::uint32_t, TrDataPoints, L> DataPoints{};
+        constexpr hkField<std::uint16_t, TrDataKind, L> DataKind{};
+        constexpr hkField<char, TrRecordingMode, L> RecordingMode{};
+        constexpr hkField<char, TrDataFormat, L> DataFormat{};
+        constexpr hkField<double, TrDataScaler, L> DataScaler{};
+        constexpr hkStringField<8, TrYUnit, L> YUnit{};
+        constexpr hkField<double, TrXInterval, L> XInterval{};
+        constexpr hkField<double, TrXStart, L> XStart{};
+        constexpr hkStringField<8, TrXUnit, L> XUnit{};
+        constexpr hkField<double, TrSealResistance, L> SealResistance{};
+        constexpr hkField<double, TrCSlow, L> CSlow{};
+        constexpr hkField<double, TrGSeries, L> GSeries{};
+        constexpr hkField<double, TrRsValue, L> RsValue{};
+        constexpr hkField<std::int32_t, TrLinkDAChannel, L> LinkDAChannel{};
+        constexpr hkField<std::int32_t, TrInterleaveSize, L> InterleaveSize{};
+        constexpr hkField<std::int32_t, TrInterleaveSkip, L> InterleaveSkip{};
+        constexpr hkField<double, TrTrHolding, L> Holding{};
+    }
+
+    // pgf (stimulation) tree
+
+    namespace Stimulation {
+        constexpr auto L = hkTreeNode::StimulationLevel;
+        constexpr hkStringField<32, stEntryName, L> EntryName{};
+        constexpr hkStringField<32, stFileName, L> FileName{};
+        constexpr hkField<std::int32_t, stDataStartSegment, L> DataStartSegment{};
+        constexpr hkField<double, stDataStartTime, L> DataStartTime{};
+        constexpr hkField<std::int32_t, stNumberSweeps, L> NumberSweeps{};
+        constexpr hkField<std::int32_t, stActualDacChannels, L> ActualDacChannels{};
+        constexpr hkField<char, stExtTrigger, L> ExtTrigger{};
+        constexpr hkField<char, stHasLockIn, L> HasLockIn{};
+    }
+
+    namespace Channel {
+        constexpr auto L = hkTreeNode::ChannelLevel;
+        constexpr hkField<std::int32_t, chLinkedChannel, L> LinkedChannel{};
+        constexpr hkField<std::int16_t, chAdcChannel, L> AdcChannel{};
+        constexpr hkField<char, chAdcMode, L> AdcMode{};
+        constexpr hkField<char, chSetLastSegVmemb, L> SetLastSegVmemb{};
+        constexpr hkField<std::int16_t, chDacChannel, L> DacChannel{};
+        constexpr hkField<char, chDacMode, L> DacMode{};
+        constexpr hkStringField<8, chDacUnit, L> DacUnit{};
+        constexpr hkField<double, chHolding, L> Holding{}; // for CC in micro-ampere!
+    }
+
+    namespace Segment {
+        constexpr auto L = hkTreeNode::StimSegmentLevel;
+        constexpr hkField<char, seClass, L> Class{};
+        constexpr hkField<char, seVoltageIncMode, L> VoltageIncMode{};
+        constexpr hkField<char, seDurationIncMode, L> DurationIncMode{};
+        constexpr hkField<double, seVoltage, L> Voltage{};
+        constexpr hkField<std::int32_t, seVoltageSource, L> VoltageSource{};
+        constexpr hkField<double, seDeltaVFactor, L> DeltaVFactor{};
+        constexpr hkField<double, seDeltaVIncrement, L> DeltaVIncrement{};
+        constexpr hkField<double, seDuration, L> Duration{};
+        constexpr hkField<std::int32_t, seDurationSource, L> DurationSource{};
+        constexpr hkField<double, seDeltaTFactor, L> DeltaTFactor{};
+        constexpr hkField<double, seDeltaTIncrement, L> DeltaTIncrement{};
+    }
+
+    // amp tree
+
+    namespace AmpRoot {
+        constexpr auto L = hkTreeNode::LevelRoot;
+        constexpr hkStringField<32, RoAmplifierName, L> AmplifierName{};
+        constexpr hkField<char, RoAmplifier, L> Amplifier{};
+        constexpr hkField<char, RoADBoard, L> ADBoard{};
+    }
+
+    namespace AmpState {
+        constexpr int L = 2; // record of amp tree containing an amplifier state
+        constexpr hkField<std::int32_t, AmStateCount, L> StateCount{};
+    }
+}
+
+#endif // !RECORD_FIELDS_H
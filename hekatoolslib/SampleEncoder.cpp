@@ -0,0 +1,157 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "BufferPool.h"
+#include "ConvertKernels.h"
+#include "helpers.h"
+#include "hkTree.h"
+#include "SampleEncoder.h"
+#include "TraceView.h"
+
+namespace hkLib {
+
+    const char* ExportDataTypeName(ExportDataType type)
+    {
+        switch (type) {
+        case ExportDataType::Float32:
+            return "float32";
+        case ExportDataType::Native:
+            return "native";
+        default:
+            return "float64";
+        }
+    }
+
+    ExportDataType ParseExportDataType(std::string_view name)
+    {
+        for (auto type : { ExportDataType::Float64, ExportDataType::Float32, ExportDataType::Native }) {
+            if (name == ExportDataTypeName(type)) {
+                return type;
+            }
+        }
+        throw std::invalid_argument("unknown export data type");
+    }
+
+    namespace {
+        template<typename T> void swapSamples(const char* source, std::size_t count, char* target)
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                T x;
+                std::memcpy(&x, source + i * sizeof(T), sizeof(T));
+                x = swap_bytes(x);
+                std::memcpy(target + i * sizeof(T), &x, sizeof(T));
+            }
+        }
+    }
+
+    SampleEncoder::SampleEncoder(ExportDataType type, char dataformat, bool need_swap, double datascaler)
+        : out_type{ type }, dataformat{ dataformat }, need_swap{ need_swap }, datascaler{ datascaler }
+    {
+        TraceView::sampleSizeOf(dataformat); // throws for unknown formats
+    }
+
+    SampleEncoder::~SampleEncoder()
+    {
+        BufferPool::global().release(std::move(buffer));
+    }
+
+    char* SampleEncoder::scratch(std::size_t nbytes)
+    {
+        const auto n = (nbytes + sizeof(double) - 1) / sizeof(double);
+        if (buffer.size() < n) {
+            BufferPool::global().release(std::move(buffer));
+            buffer = BufferPool::global().acquire(n);
+        }
+        return reinterpret_cast<char*>(buffer.data());
+    }
+
+    char SampleEncoder::outputFormat() const
+    {
+        switch (out_type) {
+        case ExportDataType::Float32:
+            return DFT_float;
+        case ExportDataType::Native:
+            return dataformat;
+        default:
+            return DFT_double;
+        }
+    }
+
+    std::size_t SampleEncoder::outputSampleSize() const
+    {
+        return TraceView::sampleSizeOf(outputFormat());
+    }
+
+    std::span<const char> SampleEncoder::encode(const char* raw, std::size_t count)
+    {
+        switch (out_type) {
+        case ExportDataType::Float32: {
+            auto* target = reinterpret_cast<float*>(scratch(count * sizeof(float)));
+            ConvertSamples(dataformat, raw, count, need_swap, datascaler, target);
+            return { reinterpret_cast<const char*>(target), count * sizeof(float) };
+        }
+        case ExportDataType::Native: {
+            const auto nbytes = count * TraceView::sampleSizeOf(dataformat);
+            if (!need_swap) {
+                return { raw, nbytes };
+            }
+            char* target = scratch(nbytes);
+            switch (dataformat) {
+            case DFT_int16:
+                swapSamples<int16_t>(raw, count, target);
+                break;
+            case DFT_int32:
+                swapSamples<int32_t>(raw, count, target);
+                break;
+            case DFT_float:
+                swapSamples<float>(raw, count, target);
+                break;
+            default:
+                swapSamples<double>(raw, count, target);
+                break;
+            }
+            return { target, nbytes };
+        }
+        default: {
+            auto* target = reinterpret_cast<double*>(scratch(count * sizeof(double)));
+            ConvertSamples(dataformat, raw, count, need_swap, datascaler, target);
+            return { reinterpret_cast<const char*>(target), count * sizeof(double) };
+        }
+        }
+    }
+
+    std::span<const char> SampleEncoder::encode(std::span<const double> data)
+    {
+        switch (out_type) {
+        case ExportDataType::Float32: {
+            auto* target = reinterpret_cast<float*>(scratch(data.size() * sizeof(float)));
+            std::transform(data.begin(), data.end(), target, [](double x) { return static_cast<float>(x); });
+            return { reinterpret_cast<const char*>(target), data.size() * sizeof(float) };
+        }
+        case ExportDataType::Native:
+            throw std::invalid_argument("export of native data type requires raw trace data");
+        default:
+            return { reinterpret_cast<const char*>(data.data()), data.size() * sizeof(double) };
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SAMPLE_ENCODER_H
+#define SAMPLE_ENCODER_H
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace hkLib {
+
+    /// <summary>
+    /// data type of exported trace samples
+    /// </summary>
+    enum class ExportDataType {
+        Float64 = 0, //!< scaled values as double (default)
+        Float32 = 1, //!< scaled values as float, half the size of Float64
+        Native = 2   //!< unscaled raw samples in the type stored in the data file (e.g. int16),
+                     //!< physical value = scale factor * sample
+    };
+
+    /// <summary>
+    /// name of export data type as used on the command line ("float64", "float32" or "native")
+    /// </summary>
+    const char* ExportDataTypeName(ExportDataType type);
+
+    /// <summary>
+    /// parse name of export data type (see ExportDataTypeName()), throws std::invalid_argument for unknown names
+    /// </summary>
+    ExportDataType ParseExportDataType(std::string_view name);
+
+    /// <summary>
+    /// Encodes raw trace samples (as stored in the data file) for export
+    /// as double, float or the native type of the trace in machine byte order.
+    /// Encoded samples are stored in a scratch buffer taken from the global BufferPool,
+    /// so an encoder per exported trace doesn't cost an allocation.
+    /// </summary>
+    class SampleEncoder {
+    public:
+        /// <param name="type">requested output type</param>
+        /// <param name="dataformat">format of raw data (DFT_int16, DFT_int32, DFT_float or DFT_double)</param>
+        /// <param name="need_swap">true if byte order of raw data differs from machine byte order</param>
+        /// <param name="datascaler">factor to convert raw samples to physical units</param>
+        SampleEncoder(ExportDataType type, char dataformat, bool need_swap, double datascaler);
+        SampleEncoder(const SampleEncoder&) = delete;
+        SampleEncoder& operator=(const SampleEncoder&) = delete;
+        ~SampleEncoder();
+
+        ExportDataType type() const { return out_type; };
+        char outputFormat() const; //!< data format (DFT_...) of encoded samples
+        std::size_t outputSampleSize() const;
+        /// <summary>
+        /// factor to convert encoded samples to physical units, 1.0 unless type is Native
+        /// </summary>
+        double outputScaler() const { return out_type == ExportDataType::Native ? datascaler : 1.0; };
+
+        /// <summary>
+        /// encode count raw samples
+        /// </summary>
+        /// <returns>encoded samples, may reference the raw data or an internal buffer
+        /// that is valid until the next call</returns>
+        std::span<const char> encode(const char* raw, std::size_t count);
+
+        /// <summary>
+        /// encode samples already converted to double (e.g. from the trace cache),
+        /// throws std::invalid_argument if type is Native, since the raw samples are needed for that
+        /// </summary>
+        std::span<const char> encode(std::span<const double> data);
+
+    private:
+        ExportDataType out_type;
+        char dataformat;
+        bool need_swap;
+        double datascaler;
+        char* scratch(std::size_t nbytes);
+
+        std::vector<double> buffer; // storage for encoded samples of any output type
+    };
+}
+
+#endif // !SAMPLE_ENCODER_H
@@ -19,6 +19,7 @@
 
 #include "StimTree.h"
 #include "PMparameters.h"
+#include "RecordFields.h"
 #include <cassert>
 #include <cmath> // for std::pow
 
@@ -34,12 +35,12 @@ namespace hkLib {
 	StimulationRecord::StimulationRecord(const hkTreeNode& node)
 	{
 		assert(node.getLevel() == 1);
-		EntryName = node.getString(stEntryName);
-		DataStartSegment = node.extractValue<int32_t>(stDataStartSegment);
-		DataStartTime = node.extractValue<double>(stDataStartTime);
-		NumberSweeps = node.extractValue<int32_t>(stNumberSweeps);
-		ActualDacChannels = node.extractValue<int32_t>(stActualDacChannels);
-		HasLockIn = static_cast<bool>(node.getChar(stHasLockIn));
+		EntryName = node.get(Stimulation::EntryName);
+		DataStartSegment = node.get(Stimulation::DataStartSegment);
+		DataStartTime = node.get(Stimulation::DataStartTime);
+		NumberSweeps = node.get(Stimulation::NumberSweeps);
+		ActualDacChannels = node.get(Stimulation::ActualDacChannels);
+		HasLockIn = static_cast<bool>(node.get(Stimulation::HasLockIn));
 		for (const auto& c : node.Children) {
 			Channels.emplace_back(c);
 		}
@@ -149,10 +150,10 @@ namespace hkLib {
 	}
 
 	ChannelRecord::ChannelRecord(const hkTreeNode& node) :
-		LinkedChannel{ node.extractInt32(chLinkedChannel) - 1 },
-		DacMode{ node.getChar(chDacMode) }, DacUnit{ node.getString(chDacUnit) },
-		Holding{ node.extractLongReal(chHolding) },
-		SetLastSegVmemb{ static_cast<bool>(node.getChar(chSetLastSegVmemb)) }
+		LinkedChannel{ node.get(Channel::LinkedChannel) - 1 },
+		DacMode{ node.get(Channel::DacMode) }, DacUnit{ node.get(Channel::DacUnit) },
+		Holding{ node.get(Channel::Holding) },
+		SetLastSegVmemb{ static_cast<bool>(node.get(Channel::SetLastSegVmemb)) }
 	{
 		assert(node.getLevel() == 2);
 
@@ -162,16 +163,16 @@ namespace hkLib {
 	}
 
 	StimSegmentRecord::StimSegmentRecord(const hkTreeNode& node) :
-		Class{ node.getChar(seClass) },
-		Voltage{ node.extractLongReal(seVoltage) },
-		DeltaVFactor{ node.extractLongReal(seDeltaVFactor) },
-		DeltaVIncrement{ node.extractLongReal(seDeltaVIncrement) },
-		VoltageSource{ node.extractInt32(seVoltageSource) },
-		DurationIncMode{ node.getChar(seDurationIncMode) },
-		VoltageIncMode{ node.getChar(seVoltageIncMode) },
-		Duration{ node.extractLongReal(seDuration) },
-		DeltaTFactor{ node.extractLongReal(seDeltaTFactor) },
-		DeltaTIncrement{ node.extractLongReal(seDeltaTIncrement) },
+		Class{ node.get(Segment::Class) },
+		Voltage{ node.get(Segment::Voltage) },
+		DeltaVFactor{ node.get(Segment::DeltaVFactor) },
+		DeltaVIncrement{ node.get(Segment::DeltaVIncrement) },
+		VoltageSource{ node.get(Segment::VoltageSource) },
+		DurationIncMode{ node.get(Segment::DurationIncMode) },
+		VoltageIncMode{ node.get(Segment::VoltageIncMode) },
+		Duration{ node.get(Segment::Duration) },
+		DeltaTFactor{ node.get(Segment::DeltaTFactor) },
+		DeltaTIncrement{ node.get(Segment::DeltaTIncrement) },
 		Node{ &node }
 	{
 		assert(node.getLevel() == 3);
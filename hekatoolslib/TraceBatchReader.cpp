@@ -0,0 +1,153 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "DatFile.h"
+#include "MappedFile.h"
+#include "TraceBatchReader.h"
+
+namespace hkLib {
+
+    namespace {
+        std::size_t rawDataSize(const hkTreeNode& TrRecord)
+        {
+            return TrRecord.get(Trace::DataPoints) * TraceView::sampleSizeOf(TrRecord.get(Trace::DataFormat));
+        }
+    }
+
+    void TraceBatchReader::read(std::span<const hkTreeNode* const> traces, const Callback& callback)
+    {
+        if (getMappedFileBuf(datafile)) {
+            for (std::size_t i = 0; i < traces.size(); ++i) {
+                callback(i, TraceView(datafile, *traces[i]));
+            }
+            return;
+        }
+        std::size_t first = 0;
+        while (first < traces.size()) {
+            // at least one trace per batch
+            std::size_t last = first + 1, batch_bytes = rawDataSize(*traces[first]);
+            while (last < traces.size()) {
+                const auto nbytes = rawDataSize(*traces[last]);
+                if (batch_bytes + nbytes > max_batch_bytes) break;
+                batch_bytes += nbytes;
+                ++last;
+            }
+            readBatch(traces.subspan(first, last - first), first, callback);
+            first = last;
+        }
+    }
+
+    void TraceBatchReader::readBatch(std::span<const hkTreeNode* const> traces, std::size_t first_index,
+        const Callback& callback)
+    {
+        struct Extent {
+            std::size_t begin, end, nbytes;
+            std::size_t region;
+            bool gathered;
+        };
+        struct Region {
+            std::size_t begin, end;
+            std::vector<char> data;
+        };
+        std::vector<Extent> extents;
+        extents.reserve(traces.size());
+        for (const auto* tr : traces) {
+            const auto nbytes = rawDataSize(*tr);
+            const auto [begin, end] = GetRawTraceDataExtent(*tr, nbytes);
+            extents.push_back({ begin, end, nbytes, 0, false });
+        }
+        // interleaved channels of a sweep are extracted together in a single pass over
+        // their data instead of reading the whole interleaved region and copying each trace from it
+        std::vector<std::vector<char>> gathered(traces.size());
+        for (std::size_t i = 0; i < traces.size();) {
+            std::size_t j = i;
+            while (j < traces.size() && extents[j].end - extents[j].begin != extents[j].nbytes
+                && traces[j]->getParent() == traces[i]->getParent()) {
+                ++j;
+            }
+            if (j - i < 2) {
+                i = std::max(j, i + 1);
+                continue;
+            }
+            std::vector<char*> targets;
+            for (std::size_t k = i; k < j; ++k) {
+                gathered[k].resize(extents[k].nbytes);
+                targets.push_back(gathered[k].data());
+                extents[k].gathered = true;
+            }
+            ReadRawTraceData(datafile, traces.subspan(i, j - i), targets);
+            i = j;
+        }
+        // sort by file offset and merge into regions
+        std::vector<std::size_t> order(traces.size());
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        std::sort(order.begin(), order.end(),
+            [&](std::size_t a, std::size_t b) { return extents[a].begin < extents[b].begin; });
+        std::vector<Region> regions;
+        for (auto i : order) {
+            auto& e = extents[i];
+            if (e.nbytes == 0 || e.gathered) {
+                continue;
+            }
+            if (regions.empty() || e.begin > regions.back().end + max_gap) {
+                regions.push_back({ e.begin, e.end, {} });
+            }
+            else {
+                regions.back().end = std::max(regions.back().end, e.end);
+            }
+            e.region = regions.size() - 1;
+        }
+        for (auto& r : regions) {
+            r.data.resize(r.end - r.begin);
+            datafile.seekg(r.begin).read(r.data.data(), r.data.size());
+            if (!datafile) {
+                throw std::runtime_error("error while reading datafile");
+            }
+        }
+        // hand out traces in original order
+        std::vector<char> buffer;
+        for (std::size_t i = 0; i < traces.size(); ++i) {
+            const auto& tr = *traces[i];
+            const auto& e = extents[i];
+            if (e.nbytes == 0) {
+                callback(first_index + i, TraceView(tr, std::span<const char>{}));
+                continue;
+            }
+            if (e.gathered) {
+                callback(first_index + i, TraceView(tr, gathered[i]));
+                continue;
+            }
+            const auto& r = regions[e.region];
+            if (e.end - e.begin == e.nbytes) {
+                // contiguous data can be referenced in place
+                callback(first_index + i, TraceView(tr, std::span(r.data).subspan(e.begin - r.begin, e.nbytes)));
+            }
+            else {
+                // single interleaved channel, copied from the region
+                buffer.resize(e.nbytes);
+                CopyRawTraceData(r.data, r.begin, tr, e.nbytes, buffer.data());
+                callback(first_index + i, TraceView(tr, buffer));
+            }
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_BATCH_READER_H
+#define TRACE_BATCH_READER_H
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <span>
+#include "hkTree.h"
+#include "TraceView.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Reads the data of many traces with few, mostly sequential reads.
+    /// The traces are processed in batches of limited size (in their original order);
+    /// within a batch, the reads are sorted by file offset and adjacent or overlapping
+    /// regions (including small gaps) are merged into single large reads.
+    /// Interleaved channels of one sweep that follow each other in the list are
+    /// de-interleaved together in a single pass (see ReadRawTraceData for several traces).
+    /// The traces are passed to the callback in their original order nevertheless.
+    /// For memory mapped streams no reading is needed at all, the traces are simply
+    /// handed out as views of the mapping.
+    /// </summary>
+    class TraceBatchReader {
+    public:
+        static constexpr std::size_t DefaultBatchBytes = std::size_t(64) << 20;
+        static constexpr std::size_t DefaultMaxGap = std::size_t(64) << 10;
+
+        /// <summary>
+        /// callback receiving the index of the trace (in the list passed to read()) and the trace data,
+        /// the view is valid only during the call
+        /// </summary>
+        using Callback = std::function<void(std::size_t index, const TraceView& trace)>;
+
+        /// <param name="datafile">stream from which trace data is read</param>
+        /// <param name="max_batch_bytes">approx. max. amount of file data read per batch</param>
+        /// <param name="max_gap">gaps up to this size between trace data are read (and discarded) rather than skipped</param>
+        explicit TraceBatchReader(std::istream& datafile, std::size_t max_batch_bytes = DefaultBatchBytes,
+            std::size_t max_gap = DefaultMaxGap)
+            : datafile{ datafile }, max_batch_bytes{ max_batch_bytes }, max_gap{ max_gap } {}
+
+        /// <summary>
+        /// read traces and pass them to callback in the order given
+        /// </summary>
+        /// <param name="traces">trace records</param>
+        /// <param name="callback">called once for each trace</param>
+        void read(std::span<const hkTreeNode* const> traces, const Callback& callback);
+
+    private:
+        void readBatch(std::span<const hkTreeNode* const> traces, std::size_t first_index, const Callback& callback);
+
+        std::istream& datafile;
+        std::size_t max_batch_bytes;
+        std::size_t max_gap;
+    };
+}
+
+#endif // !TRACE_BATCH_READER_H
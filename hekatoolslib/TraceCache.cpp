@@ -0,0 +1,156 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "BufferPool.h"
+#include "DatFile.h"
+#include "TraceCache.h"
+
+namespace hkLib {
+
+    std::size_t TraceCache::entrySize(const TraceData& data)
+    {
+        constexpr std::size_t overhead = 64; // rough estimate of bookkeeping costs per entry
+        // buffers from the BufferPool may be larger than the trace, the whole allocation counts
+        return data->capacity() * sizeof(double) + overhead;
+    }
+
+    TraceCache::TraceData TraceCache::find(const hkTreeNode* trace)
+    {
+        std::lock_guard lk(mtx);
+        auto it = entries.find(trace);
+        if (it == entries.end()) {
+            ++misses;
+            return nullptr;
+        }
+        ++hits;
+        lru.splice(lru.begin(), lru, it->second.pos);
+        return it->second.data;
+    }
+
+    bool TraceCache::contains(const hkTreeNode* trace) const
+    {
+        std::lock_guard lk(mtx);
+        return entries.contains(trace);
+    }
+
+    void TraceCache::insert(const hkTreeNode* trace, TraceData data)
+    {
+        if (!data) {
+            return;
+        }
+        const auto size = entrySize(data);
+        std::lock_guard lk(mtx);
+        if (auto it = entries.find(trace); it != entries.end()) {
+            bytes -= entrySize(it->second.data);
+            lru.erase(it->second.pos);
+            entries.erase(it);
+        }
+        if (size > budget) {
+            return;
+        }
+        lru.push_front(trace);
+        entries.emplace(trace, Entry{ std::move(data), lru.begin() });
+        bytes += size;
+        evict();
+    }
+
+    template<typename Source> TraceCache::TraceData TraceCache::getOrLoad(Source& source, const hkTreeNode& trace)
+    {
+        if (auto data = find(&trace)) {
+            return data;
+        }
+        // load without holding the lock, at worst a trace is loaded twice by concurrent callers
+        auto data = load(source, trace);
+        insert(&trace, data);
+        return data;
+    }
+
+    TraceCache::TraceData TraceCache::get(std::istream& datafile, const hkTreeNode& trace)
+    {
+        return getOrLoad(datafile, trace);
+    }
+
+    TraceCache::TraceData TraceCache::get(const PositionalReader& reader, const hkTreeNode& trace)
+    {
+        return getOrLoad(reader, trace);
+    }
+
+    template<typename Source> static TraceCache::TraceData loadFrom(Source& source, const hkTreeNode& trace)
+    {
+        auto& pool = BufferPool::global();
+        auto buffer = pool.acquire(trace.get(Trace::DataPoints));
+        // converts in place, so apart from the pooled buffer nothing is allocated
+        ReadScaleAndConvert(source, trace, buffer.data());
+        return pool.share(std::move(buffer));
+    }
+
+    TraceCache::TraceData TraceCache::load(std::istream& datafile, const hkTreeNode& trace)
+    {
+        return loadFrom(datafile, trace);
+    }
+
+    TraceCache::TraceData TraceCache::load(const PositionalReader& reader, const hkTreeNode& trace)
+    {
+        return loadFrom(reader, trace);
+    }
+
+    void TraceCache::evict()
+    {
+        while (bytes > budget && !lru.empty()) {
+            auto it = entries.find(lru.back());
+            bytes -= entrySize(it->second.data);
+            entries.erase(it);
+            lru.pop_back();
+            ++evictions;
+        }
+    }
+
+    void TraceCache::clear()
+    {
+        std::lock_guard lk(mtx);
+        entries.clear();
+        lru.clear();
+        bytes = 0;
+    }
+
+    void TraceCache::setBudget(std::size_t budget_bytes)
+    {
+        std::lock_guard lk(mtx);
+        budget = budget_bytes;
+        evict();
+    }
+
+    std::size_t TraceCache::getBudget() const
+    {
+        std::lock_guard lk(mtx);
+        return budget;
+    }
+
+    TraceCache::Stats TraceCache::getStats() const
+    {
+        std::lock_guard lk(mtx);
+        return { hits, misses, evictions, entries.size(), bytes, budget };
+    }
+
+    void TraceCache::resetStats()
+    {
+        std::lock_guard lk(mtx);
+        hits = misses = evictions = 0;
+    }
+}
@@ -0,0 +1,117 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_CACHE_H
+#define TRACE_CACHE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "hkTree.h"
+#include "PositionalReader.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Cache of converted (scaled) trace data, keyed by trace node,
+    /// with a memory budget and least-recently-used eviction.
+    /// The data is handed out as shared pointers to const vectors, so evicting
+    /// an entry never invalidates data still in use. All methods are thread-safe.
+    /// </summary>
+    class TraceCache {
+    public:
+        using TraceData = std::shared_ptr<const std::vector<double>>;
+        static constexpr std::size_t DefaultBudget = std::size_t(256) << 20;
+
+        struct Stats {
+            std::uint64_t hits{}, misses{}, evictions{};
+            std::size_t entries{}, bytes{}, budget{};
+        };
+
+        explicit TraceCache(std::size_t budget_bytes = DefaultBudget) : budget{ budget_bytes } {};
+        TraceCache(const TraceCache&) = delete;
+        TraceCache& operator=(const TraceCache&) = delete;
+
+        /// <summary>
+        /// look up trace, counts as hit or miss
+        /// </summary>
+        /// <returns>cached data or nullptr</returns>
+        TraceData find(const hkTreeNode* trace);
+
+        /// <summary>
+        /// check if trace is cached, does neither count as hit or miss nor change LRU order
+        /// </summary>
+        bool contains(const hkTreeNode* trace) const;
+
+        /// <summary>
+        /// insert (or replace) data of trace, entries larger than the budget are not stored
+        /// </summary>
+        void insert(const hkTreeNode* trace, TraceData data);
+
+        /// <summary>
+        /// get cached data of trace, or load and convert it from datafile and cache it
+        /// </summary>
+        /// <param name="datafile">stream from which trace data is read on a cache miss</param>
+        /// <param name="trace">trace record</param>
+        /// <returns>converted trace data</returns>
+        TraceData get(std::istream& datafile, const hkTreeNode& trace);
+        /// <summary>
+        /// as above, but reads with a positional reader, so it can be used from several threads
+        /// </summary>
+        TraceData get(const PositionalReader& reader, const hkTreeNode& trace);
+
+        /// <summary>
+        /// load and convert trace data without looking it up in or adding it to a cache,
+        /// the data is stored in a buffer from the global BufferPool and returned there when released
+        /// </summary>
+        static TraceData load(std::istream& datafile, const hkTreeNode& trace);
+        static TraceData load(const PositionalReader& reader, const hkTreeNode& trace);
+
+        void clear();
+        void setBudget(std::size_t budget_bytes);
+        std::size_t getBudget() const;
+        Stats getStats() const;
+        void resetStats();
+
+    private:
+        static std::size_t entrySize(const TraceData& data);
+        template<typename Source> TraceData getOrLoad(Source& source, const hkTreeNode& trace);
+        void evict(); // mtx must be locked
+
+        mutable std::mutex mtx;
+        std::list<const hkTreeNode*> lru; // most recently used at front
+        struct Entry {
+            TraceData data;
+            std::list<const hkTreeNode*>::iterator pos;
+        };
+        std::unordered_map<const hkTreeNode*, Entry> entries;
+        std::size_t budget;
+        std::size_t bytes{ 0 };
+        std::uint64_t hits{ 0 }, misses{ 0 }, evictions{ 0 };
+    };
+}
+
+#endif // !TRACE_CACHE_H
@@ -0,0 +1,136 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include "BufferPool.h"
+#include "ConvertKernels.h"
+#include "DatFile.h"
+#include "MappedFile.h"
+#include "TraceChunkReader.h"
+#include "TraceView.h"
+
+namespace hkLib {
+
+    TraceChunkReader::TraceChunkReader(const hkTreeNode& TrRecord, std::size_t chunk_samples)
+        : record{ TrRecord }
+    {
+        assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
+        std::tie(dataformat, datascaler, numpoints) =
+            TrRecord.getFields(Trace::DataFormat, Trace::DataScaler, Trace::DataPoints);
+        samplesize = TraceView::sampleSizeOf(dataformat);
+        need_swap = TraceNeedsSwap(TrRecord);
+        last = numpoints;
+        chunksize = std::max<std::size_t>(1, std::min(chunk_samples, numpoints));
+    }
+
+    TraceChunkReader::TraceChunkReader(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t chunk_samples)
+        : TraceChunkReader(TrRecord, chunk_samples)
+    {
+        this->datafile = &datafile;
+        if (const auto* mapped = getMappedFileBuf(datafile)) {
+            contiguous = GetContiguousRawTraceData(mapped->mappedData(), TrRecord, numpoints * samplesize);
+        }
+    }
+
+    TraceChunkReader::TraceChunkReader(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t chunk_samples)
+        : TraceChunkReader(TrRecord, chunk_samples)
+    {
+        this->reader = &reader;
+        if (auto filedata = reader.mappedData(); !filedata.empty()) {
+            contiguous = GetContiguousRawTraceData(filedata, TrRecord, numpoints * samplesize);
+        }
+    }
+
+    TraceChunkReader::~TraceChunkReader()
+    {
+        BufferPool::global().release(std::move(buffer));
+    }
+
+    double* TraceChunkReader::chunkBuffer()
+    {
+        if (buffer.empty()) {
+            buffer = BufferPool::global().acquire(chunksize);
+        }
+        return buffer.data();
+    }
+
+    void TraceChunkReader::setRange(std::size_t first, std::size_t last)
+    {
+        if (first > last || last > numpoints) {
+            throw std::out_of_range("sample range exceeds trace");
+        }
+        this->first = first;
+        this->last = last;
+        pos = first;
+    }
+
+    void TraceChunkReader::readRaw(std::size_t first_byte, std::size_t nbytes, char* target)
+    {
+        if (reader) {
+            ReadRawTraceDataRange(*reader, record, first_byte, nbytes, target);
+        }
+        else {
+            ReadRawTraceDataRange(*datafile, record, first_byte, nbytes, target);
+        }
+    }
+
+    std::span<const char> TraceChunkReader::nextRaw()
+    {
+        const auto n = std::min(chunksize, last - std::min(pos, last));
+        if (n == 0) {
+            return {};
+        }
+        std::span<const char> raw;
+        if (!contiguous.empty()) {
+            // zero-copy, reference memory mapping directly
+            raw = contiguous.subspan(pos * samplesize, n * samplesize);
+        }
+        else {
+            auto* target = reinterpret_cast<char*>(chunkBuffer());
+            readRaw(pos * samplesize, n * samplesize, target);
+            raw = { target, n * samplesize };
+        }
+        pos += n;
+        return raw;
+    }
+
+    std::span<const double> TraceChunkReader::next()
+    {
+        const auto n = std::min(chunksize, last - std::min(pos, last));
+        if (n == 0) {
+            return {};
+        }
+        double* target = chunkBuffer();
+        const char* raw;
+        if (!contiguous.empty()) {
+            raw = contiguous.data() + pos * samplesize;
+        }
+        else {
+            // read to the tail of the chunk buffer and expand in place
+            auto* tail = reinterpret_cast<char*>(target) + n * (sizeof(double) - samplesize);
+            readRaw(pos * samplesize, n * samplesize, tail);
+            raw = tail;
+        }
+        ConvertSamples(dataformat, raw, n, need_swap, datascaler, target);
+        pos += n;
+        return { target, n };
+    }
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_CHUNK_READER_H
+#define TRACE_CHUNK_READER_H
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <span>
+#include <vector>
+#include "hkTree.h"
+#include "PositionalReader.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Reads a trace sequentially in chunks of a fixed number of samples, each chunk
+    /// scaled and converted to double. Memory use is bounded by the chunk size, independent
+    /// of the length of the trace, so this is the way to process very long (e.g. gap-free) traces.
+    /// Interleaved data is handled transparently, chunks need not be aligned to interleave blocks.
+    /// A single chunk buffer is used for reading and converting (the conversion is done in place),
+    /// it is taken from the global BufferPool, so readers created per trace don't allocate.
+    /// The reader must not outlive the stream (or positional reader) it reads from.
+    /// </summary>
+    class TraceChunkReader {
+    public:
+        static constexpr std::size_t DefaultChunkSamples = std::size_t(1) << 20;
+
+        /// <param name="datafile">stream from which trace data is read</param>
+        /// <param name="TrRecord">trace record</param>
+        /// <param name="chunk_samples">(max.) number of samples per chunk</param>
+        TraceChunkReader(std::istream& datafile, const hkTreeNode& TrRecord,
+            std::size_t chunk_samples = DefaultChunkSamples);
+
+        /// <param name="reader">positional reader of the data file</param>
+        /// <param name="TrRecord">trace record</param>
+        /// <param name="chunk_samples">(max.) number of samples per chunk</param>
+        TraceChunkReader(const PositionalReader& reader, const hkTreeNode& TrRecord,
+            std::size_t chunk_samples = DefaultChunkSamples);
+        TraceChunkReader(const TraceChunkReader&) = delete;
+        TraceChunkReader& operator=(const TraceChunkReader&) = delete;
+        ~TraceChunkReader();
+
+        std::size_t size() const { return last - first; }; //!< number of samples to read (whole trace unless a range is set)
+        std::size_t position() const { return pos; }; //!< index (within trace) of first sample of next chunk
+        bool done() const { return pos >= last; };
+
+        /// <summary>
+        /// Restrict reading to samples [first, last) of the trace and rewind to first.
+        /// Only the data of the range is read from the file, also for interleaved traces.
+        /// Throws std::out_of_range if the range exceeds the trace.
+        /// </summary>
+        void setRange(std::size_t first, std::size_t last);
+
+        /// <summary>
+        /// read and convert the next chunk
+        /// </summary>
+        /// <returns>scaled samples, valid until the next call, empty if all samples have been read</returns>
+        std::span<const double> next();
+
+        /// <summary>
+        /// read the next chunk without converting it
+        /// </summary>
+        /// <returns>raw samples in file byte order, valid until the next call, empty if all samples have been read</returns>
+        std::span<const char> nextRaw();
+
+        char dataFormat() const { return dataformat; }; //!< one of DFT_int16, DFT_int32, DFT_float, DFT_double
+        std::size_t sampleSize() const { return samplesize; };
+        bool needsSwap() const { return need_swap; }; //!< true if byte order of raw samples differs from machine byte order
+        double scaler() const { return datascaler; }; //!< factor to convert raw samples to physical units
+
+    private:
+        TraceChunkReader(const hkTreeNode& TrRecord, std::size_t chunk_samples);
+        void readRaw(std::size_t first_byte, std::size_t nbytes, char* target);
+        double* chunkBuffer();
+
+        std::istream* datafile{};
+        const PositionalReader* reader{};
+        const hkTreeNode& record;
+        std::span<const char> contiguous{}; // raw data of non-interleaved trace in memory mapping, if available
+        char dataformat{};
+        bool need_swap{};
+        double datascaler{};
+        std::size_t numpoints{}, samplesize{}, chunksize{}, first{ 0 }, last{}, pos{ 0 };
+        std::vector<double> buffer; // from BufferPool, holds raw (nextRaw) or converted (next) samples
+    };
+}
+
+#endif // !TRACE_CHUNK_READER_H
@@ -0,0 +1,181 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include "BufferPool.h"
+#include "ConvertKernels.h"
+#include "DatFile.h"
+#include "MappedFile.h"
+#include "TraceView.h"
+
+namespace hkLib {
+
+    namespace {
+        std::span<const char> mappedDataOf(std::istream& datafile)
+        {
+            const auto* mapped = getMappedFileBuf(datafile);
+            return mapped ? mapped->mappedData() : std::span<const char>{};
+        }
+
+        std::span<const char> mappedDataOf(const PositionalReader& reader)
+        {
+            return reader.mappedData();
+        }
+    }
+
+    template<typename Source> void TraceView::load(Source& source, const hkTreeNode& TrRecord, std::size_t first, std::size_t last)
+    {
+        init(TrRecord);
+        const auto total_bytes = numpoints * sampleSize();
+        initRange(first, last);
+        const auto first_byte = first * sampleSize(), nbytes = numpoints * sampleSize();
+        if (auto filedata = mappedDataOf(source); !filedata.empty()) {
+            auto contiguous = GetContiguousRawTraceData(filedata, TrRecord, total_bytes);
+            if (contiguous.size() == total_bytes && isAligned(contiguous)) {
+                raw = contiguous.subspan(first_byte, nbytes);
+                return;
+            }
+        }
+        buffer.resize(nbytes);
+        ReadRawTraceDataRange(source, TrRecord, first_byte, nbytes, buffer.data());
+        raw = buffer;
+    }
+
+    TraceView::TraceView(std::istream& datafile, const hkTreeNode& TrRecord)
+        : TraceView(datafile, TrRecord, 0, TrRecord.get(Trace::DataPoints))
+    {
+    }
+
+    TraceView::TraceView(const PositionalReader& reader, const hkTreeNode& TrRecord)
+        : TraceView(reader, TrRecord, 0, TrRecord.get(Trace::DataPoints))
+    {
+    }
+
+    TraceView::TraceView(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t first, std::size_t last)
+    {
+        load(datafile, TrRecord, first, last);
+    }
+
+    TraceView::TraceView(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t first, std::size_t last)
+    {
+        load(reader, TrRecord, first, last);
+    }
+
+    TraceView::TraceView(const hkTreeNode& TrRecord, std::span<const char> rawdata)
+    {
+        init(TrRecord);
+        if (rawdata.size() != numpoints * sampleSize()) {
+            throw std::runtime_error("size of raw data does not match trace record");
+        }
+        if (isAligned(rawdata)) {
+            raw = rawdata;
+        }
+        else {
+            buffer.assign(rawdata.begin(), rawdata.end());
+            raw = buffer;
+        }
+    }
+
+    void TraceView::init(const hkTreeNode& TrRecord)
+    {
+        assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
+        uint16_t datakind;
+        std::tie(dataformat, datakind, datascaler, numpoints) =
+            TrRecord.getFields(Trace::DataFormat, Trace::DataKind, Trace::DataScaler, Trace::DataPoints);
+        little_endian = datakind & LittleEndianBit;
+        sampleSizeOf(dataformat); // throws for unknown formats
+    }
+
+    void TraceView::initRange(std::size_t first, std::size_t last)
+    {
+        if (first > last || last > numpoints) {
+            throw std::out_of_range("sample range exceeds trace");
+        }
+        numpoints = last - first;
+    }
+
+    bool TraceView::isAligned(std::span<const char> data) const
+    {
+        return reinterpret_cast<std::uintptr_t>(data.data()) % sampleSize() == 0;
+    }
+
+    std::size_t TraceView::sampleSizeOf(char dataformat)
+    {
+        switch (dataformat) {
+        case DFT_int16:
+            return sizeof(int16_t);
+        case DFT_int32:
+            return sizeof(int32_t);
+        case DFT_float:
+            return sizeof(float);
+        case DFT_double:
+            return sizeof(double);
+        default:
+            throw std::runtime_error("unknown data format type");
+        }
+    }
+
+    bool TraceView::needsSwap() const
+    {
+        return little_endian != MachineIsLittleEndian();
+    }
+
+    double TraceView::value(std::size_t i) const
+    {
+        return visit([=, this](auto get, std::size_t) { return datascaler * get(i); });
+    }
+
+    void TraceView::convert(double* target) const
+    {
+        ConvertSamples(dataformat, raw.data(), numpoints, needsSwap(), datascaler, target);
+    }
+
+    void TraceView::convert(float* target) const
+    {
+        ConvertSamples(dataformat, raw.data(), numpoints, needsSwap(), datascaler, target);
+    }
+
+    std::vector<double> TraceView::toVector() const
+    {
+        auto v = BufferPool::global().acquire(numpoints);
+        convert(v.data());
+        return v;
+    }
+
+    std::pair<double, double> TraceView::minMax() const
+    {
+        if (numpoints == 0) {
+            constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+            return { nan, nan };
+        }
+        return visit([this](auto get, std::size_t n) {
+            auto min_val = get(0), max_val = min_val;
+            for (std::size_t i = 1; i < n; ++i) {
+                auto v = get(i);
+                min_val = std::min(min_val, v);
+                max_val = std::max(max_val, v);
+            }
+            double a = datascaler * min_val, b = datascaler * max_val;
+            // negative scaler swaps order
+            return std::pair<double, double>{ std::min(a, b), std::max(a, b) };
+        });
+    }
+}
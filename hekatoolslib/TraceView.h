@@ -0,0 +1,213 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_VIEW_H
+#define TRACE_VIEW_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "hkTree.h"
+#include "helpers.h"
+#include "PositionalReader.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Raw, unscaled samples of a trace together with everything needed
+    /// to interpret them (data format, byte order and data scaler).
+    /// If the trace is read from a MappedFileStream and is not interleaved,
+    /// the samples are not copied at all, the view points into the memory mapping.
+    /// Otherwise, the raw samples are read into a buffer owned by the view,
+    /// which is still much smaller than the trace converted to double.
+    /// The view must not outlive the stream (or rather its memory mapping).
+    /// </summary>
+    class TraceView {
+    public:
+        /// <summary>
+        /// create view of trace data
+        /// </summary>
+        /// <param name="datafile">stream from which trace data is read</param>
+        /// <param name="TrRecord">trace record</param>
+        TraceView(std::istream& datafile, const hkTreeNode& TrRecord);
+
+        /// <summary>
+        /// create view of trace data using a positional reader, safe to be used from several threads
+        /// </summary>
+        /// <param name="reader">reader of the data file</param>
+        /// <param name="TrRecord">trace record</param>
+        TraceView(const PositionalReader& reader, const hkTreeNode& TrRecord);
+
+        /// <summary>
+        /// Create view of samples [first, last) of a trace. Only the blocks of (interleaved) data
+        /// containing the range are read, so a short window of a very long trace is cheap.
+        /// Sample indices in the view are relative to first.
+        /// Throws std::out_of_range if the range exceeds the trace.
+        /// </summary>
+        /// <param name="datafile">stream from which trace data is read</param>
+        /// <param name="TrRecord">trace record</param>
+        /// <param name="first">index of first sample</param>
+        /// <param name="last">index one past the last sample</param>
+        TraceView(std::istream& datafile, const hkTreeNode& TrRecord, std::size_t first, std::size_t last);
+        TraceView(const PositionalReader& reader, const hkTreeNode& TrRecord, std::size_t first, std::size_t last);
+
+        /// <summary>
+        /// create view of raw trace data already in memory (e.g. read by TraceBatchReader),
+        /// the data is referenced, not copied (unless it is misaligned), so it must outlive the view
+        /// </summary>
+        /// <param name="TrRecord">trace record</param>
+        /// <param name="rawdata">raw samples in file byte order, size must match trace record</param>
+        TraceView(const hkTreeNode& TrRecord, std::span<const char> rawdata);
+        TraceView(TraceView&&) = default;
+        TraceView& operator=(TraceView&&) = default;
+
+        /// <summary>
+        /// size of one sample in bytes
+        /// </summary>
+        /// <param name="dataformat">one of DFT_int16, DFT_int32, DFT_float, DFT_double</param>
+        /// <returns>size in bytes, throws std::runtime_error for unknown format</returns>
+        static std::size_t sampleSizeOf(char dataformat);
+
+        char dataFormat() const { return dataformat; }; //!< one of DFT_int16, DFT_int32, DFT_float, DFT_double
+        std::size_t sampleSize() const { return sampleSizeOf(dataformat); };
+        std::size_t size() const { return numpoints; }; //!< number of samples
+        bool empty() const { return numpoints == 0; };
+        bool isLittleEndian() const { return little_endian; }; //!< byte order of the raw samples
+        bool needsSwap() const; //!< true if byte order of raw samples differs from machine byte order
+        double scaler() const { return datascaler; }; //!< factor to convert raw samples to physical units
+        bool isZeroCopy() const { return buffer.empty(); }; //!< true if view references data it does not own (e.g. memory mapping)
+
+        /// <summary>
+        /// raw samples as stored in file
+        /// </summary>
+        std::span<const char> rawBytes() const { return raw; };
+
+        /// <summary>
+        /// raw samples as typed span, values are unscaled and in file byte order,
+        /// i.e. if needsSwap() is true, the values have to be byte-swapped by the caller.
+        /// T must match the data format of the trace.
+        /// </summary>
+        template<typename T> std::span<const T> samples() const
+        {
+            checkType<T>();
+            return { reinterpret_cast<const T*>(raw.data()), numpoints };
+        }
+
+        /// <summary>
+        /// raw sample converted to machine byte order, but unscaled
+        /// </summary>
+        template<typename T> T rawValue(std::size_t i) const
+        {
+            checkType<T>();
+            T x;
+            std::memcpy(&x, raw.data() + i * sizeof(T), sizeof(T));
+            if (needsSwap()) {
+                x = swap_bytes(x);
+            }
+            return x;
+        }
+
+        /// <summary>
+        /// sample scaled to physical units
+        /// </summary>
+        double value(std::size_t i) const;
+
+        /// <summary>
+        /// Call f with a typed accessor to the unscaled raw samples in machine byte order,
+        /// this allows e.g. analysis code to work directly on int16 data.
+        /// f is called as f(get, n) with get being a callable such that get(i) returns
+        /// raw sample i as int16_t, int32_t, float or double according to the data format
+        /// </summary>
+        template<typename F> decltype(auto) visit(F&& f) const
+        {
+            switch (dataformat) {
+            case DFT_int16:
+                return f([this](std::size_t i) { return rawValue<int16_t>(i); }, numpoints);
+            case DFT_int32:
+                return f([this](std::size_t i) { return rawValue<int32_t>(i); }, numpoints);
+            case DFT_float:
+                return f([this](std::size_t i) { return rawValue<float>(i); }, numpoints);
+            case DFT_double:
+                return f([this](std::size_t i) { return rawValue<double>(i); }, numpoints);
+            default:
+                throw std::runtime_error("unknown data format type");
+            }
+        }
+
+        /// <summary>
+        /// scale all samples and convert them to double
+        /// </summary>
+        /// <param name="target">buffer that receives size() doubles</param>
+        void convert(double* target) const;
+
+        /// <summary>
+        /// scale all samples and convert them to float,
+        /// scaling is done in double precision before rounding to float
+        /// </summary>
+        /// <param name="target">buffer that receives size() floats</param>
+        void convert(float* target) const;
+
+        /// <summary>
+        /// scale all samples and convert them to double,
+        /// the vector is taken from the global BufferPool, it may be handed back there when no longer needed
+        /// </summary>
+        /// <returns>vector of size() doubles</returns>
+        std::vector<double> toVector() const;
+
+        /// <summary>
+        /// find minimum and maximum, the search is done on the raw samples,
+        /// only the results are scaled
+        /// </summary>
+        /// <returns>pair of scaled min. and max. values, NaN if trace is empty</returns>
+        std::pair<double, double> minMax() const;
+
+    private:
+        void init(const hkTreeNode& TrRecord);
+        void initRange(std::size_t first, std::size_t last);
+        // read samples [first, last) from a stream or positional reader, in place if memory mapped and aligned
+        template<typename Source> void load(Source& source, const hkTreeNode& TrRecord, std::size_t first, std::size_t last);
+        bool isAligned(std::span<const char> data) const;
+
+        template<typename T> void checkType() const
+        {
+            static_assert(std::is_arithmetic_v<T>, "must be arithmetic type");
+            if (sizeof(T) != sampleSize() || std::is_integral_v<T> != (dataformat == DFT_int16 || dataformat == DFT_int32)) {
+                throw std::runtime_error("type does not match data format of trace");
+            }
+        }
+
+        char dataformat{};
+        bool little_endian{};
+        double datascaler{};
+        std::size_t numpoints{};
+        std::span<const char> raw{};
+        std::vector<char> buffer{}; //!< used if raw data cannot be referenced in place
+    };
+}
+
+#endif // !TRACE_VIEW_H
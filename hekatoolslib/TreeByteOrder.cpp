@@ -0,0 +1,189 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include "DatFile.h"
+#include "PMparameters.h"
+#include "RecordFields.h"
+#include "TreeByteOrder.h"
+
+namespace hkLib {
+
+    namespace {
+        using LevelFields = std::vector<std::vector<hkRecordField>>;
+
+        /// <summary>
+        /// append the numeric fields described by a parameter table,
+        /// only fields within [base, base + limit) are added (for embedded records)
+        /// </summary>
+        void addParameterFields(std::vector<hkRecordField>& fields, std::span<const PMparameter> params,
+            std::size_t base = 0, std::size_t limit = SIZE_MAX)
+        {
+            for (const auto& p : params) {
+                std::uint32_t size = 0, count = 1;
+                switch (p.data_type) {
+                case PMparameter::Int16:
+                case PMparameter::UInt16:
+                case PMparameter::Set16:
+                case PMparameter::Set16_Bit5:
+                    size = 2;
+                    break;
+                case PMparameter::Int32:
+                case PMparameter::UInt32:
+                case PMparameter::seSourceName:
+                    size = 4;
+                    break;
+                case PMparameter::LongReal:
+                case PMparameter::InvLongReal:
+                case PMparameter::DateTime:
+                case PMparameter::RelativeTime:
+                    size = 8;
+                    break;
+                case PMparameter::LongReal2:
+                    size = 8; count = 2;
+                    break;
+                case PMparameter::LongReal4:
+                    size = 8; count = 4;
+                    break;
+                case PMparameter::LongReal8:
+                    size = 8; count = 8;
+                    break;
+                case PMparameter::LongReal10:
+                    size = 8; count = 10;
+                    break;
+                case PMparameter::LongReal16:
+                    size = 8; count = 16;
+                    break;
+                default:
+                    // single bytes, strings and names, nothing to swap
+                    break;
+                }
+                for (std::uint32_t i = 0; i < count && size > 0; ++i) {
+                    const auto offset = p.offset + i * size;
+                    if (offset + size <= limit) {
+                        fields.push_back({ static_cast<std::uint32_t>(base + offset), size });
+                    }
+                }
+            }
+        }
+
+        /// <summary>
+        /// append the numeric fields accessed by code (see RecordFields.h), single bytes need no swapping
+        /// </summary>
+        template<typename... Fields> void addFields(std::vector<hkRecordField>& fields, Fields...)
+        {
+            (..., [&fields] {
+                if constexpr (sizeof(typename Fields::value_type) > 1) {
+                    fields.push_back({ static_cast<std::uint32_t>(Fields::offset),
+                        static_cast<std::uint32_t>(sizeof(typename Fields::value_type)) });
+                }
+            }());
+        }
+
+        // sort and remove duplicates, e.g. fields both read by code and listed in a parameter table
+        LevelFields normalized(LevelFields levels)
+        {
+            for (auto& fields : levels) {
+                std::sort(fields.begin(), fields.end());
+                fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+                assert(std::adjacent_find(fields.begin(), fields.end(), [](const auto& a, const auto& b) {
+                    return a.offset + a.size > b.offset; }) == fields.end() && "overlapping record fields");
+            }
+            return levels;
+        }
+
+        // parameter tables plus the fields accessed in code (RecordFields.h)
+
+        LevelFields pulFields()
+        {
+            LevelFields levels(5);
+            auto& root = levels[hkTreeNode::LevelRoot];
+            auto& group = levels[hkTreeNode::LevelGroup];
+            auto& series = levels[hkTreeNode::LevelSeries];
+            auto& sweep = levels[hkTreeNode::LevelSweep];
+            auto& trace = levels[hkTreeNode::LevelTrace];
+            addParameterFields(root, parametersRoot);
+            addFields(root, Root::StartTime);
+            addParameterFields(group, parametersGroup);
+            addFields(group, Group::GroupCount);
+            addParameterFields(series, parametersSeries);
+            addParameterFields(series, parametersAmpplifierState, SeOldAmpState, AmplifierStateSize);
+            addFields(series, Series::SeriesCount, Series::AmplStateFlag, Series::AmplStateRef, Series::Time);
+            addParameterFields(sweep, parametersSweep);
+            addFields(sweep, Sweep::StimCount, Sweep::SweepCount, Sweep::Time, Sweep::Timer);
+            addParameterFields(trace, parametersTrace);
+            addFields(trace, Trace::TraceID, Trace::Data, Trace::DataPoints, Trace::DataKind, Trace::DataScaler,
+                Trace::XInterval, Trace::XStart, Trace::SealResistance, Trace::CSlow, Trace::GSeries, Trace::RsValue,
+                Trace::LinkDAChannel, Trace::InterleaveSize, Trace::InterleaveSkip, Trace::Holding);
+            return normalized(std::move(levels));
+        }
+
+        LevelFields pgfFields()
+        {
+            LevelFields levels(4);
+            addParameterFields(levels[0], parametersStimRoot);
+            addParameterFields(levels[hkTreeNode::StimulationLevel], parametersStimulation);
+            addFields(levels[hkTreeNode::StimulationLevel], Stimulation::DataStartSegment, Stimulation::DataStartTime,
+                Stimulation::NumberSweeps, Stimulation::ActualDacChannels);
+            addParameterFields(levels[hkTreeNode::ChannelLevel], parametersChannel);
+            addFields(levels[hkTreeNode::ChannelLevel], Channel::LinkedChannel, Channel::AdcChannel,
+                Channel::DacChannel, Channel::Holding);
+            addParameterFields(levels[hkTreeNode::StimSegmentLevel], parametersStimSegment);
+            addFields(levels[hkTreeNode::StimSegmentLevel], Segment::Voltage, Segment::VoltageSource,
+                Segment::DeltaVFactor, Segment::DeltaVIncrement, Segment::Duration, Segment::DurationSource,
+                Segment::DeltaTFactor, Segment::DeltaTIncrement);
+            return normalized(std::move(levels));
+        }
+
+        LevelFields ampFields()
+        {
+            // root, series, amplifier state records
+            LevelFields levels(3);
+            addParameterFields(levels[2], parametersAmpplifierState, AmAmplifierState, AmplifierStateSize);
+            addFields(levels[AmpState::L], AmpState::StateCount);
+            return normalized(std::move(levels));
+        }
+    }
+
+    std::span<const std::vector<hkRecordField>> NumericRecordFields(std::string_view tree_id)
+    {
+        static const LevelFields pul = pulFields(), pgf = pgfFields(), amp = ampFields();
+        if (tree_id == ExtPul) {
+            return pul;
+        }
+        if (tree_id == ExtPgf) {
+            return pgf;
+        }
+        if (tree_id == ExtAmp) {
+            return amp;
+        }
+        return {};
+    }
+
+    bool MakeNativeByteOrder(hkTree& tree)
+    {
+        const auto fields = NumericRecordFields(tree.getID());
+        if (fields.empty()) {
+            return false;
+        }
+        return tree.ConvertToNativeByteOrder(fields);
+    }
+}
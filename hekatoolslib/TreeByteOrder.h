@@ -0,0 +1,50 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE_BYTE_ORDER_H
+#define TREE_BYTE_ORDER_H
+
+#pragma once
+
+#include <span>
+#include <string_view>
+#include <vector>
+#include "hkTree.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Numeric fields of the records of a tree, level by level, as known from the
+    /// parameter tables (PMparameters.h) and the record offsets defined in hkTree.h.
+    /// Fields of each level are sorted and do not overlap.
+    /// </summary>
+    /// <param name="tree_id">id of tree (ExtPul, ExtPgf or ExtAmp)</param>
+    /// <returns>fields per level, empty for unknown trees</returns>
+    std::span<const std::vector<hkRecordField>> NumericRecordFields(std::string_view tree_id);
+
+    /// <summary>
+    /// Convert a pul, pgf or amp tree to native byte order once (see hkTree::ConvertToNativeByteOrder),
+    /// so that subsequent field accesses need not swap bytes. Only the known numeric fields
+    /// (see NumericRecordFields) are converted.
+    /// </summary>
+    /// <returns>true if the tree has been converted</returns>
+    bool MakeNativeByteOrder(hkTree& tree);
+}
+
+#endif // !TREE_BYTE_ORDER_H
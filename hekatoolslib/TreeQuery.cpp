@@ -0,0 +1,208 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <array>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include "helpers.h"
+#include "ParameterTable.h"
+#include "RecordFields.h"
+#include "TreeQuery.h"
+
+namespace hkLib {
+
+    namespace {
+        constexpr int NumLevels = hkTreeNode::LevelTrace + 1;
+
+        std::span<const PMparameter> parametersOfLevel(int level)
+        {
+            switch (level) {
+            case hkTreeNode::LevelRoot:
+                return parametersRoot;
+            case hkTreeNode::LevelGroup:
+                return parametersGroup;
+            case hkTreeNode::LevelSeries:
+                return parametersSeries;
+            case hkTreeNode::LevelSweep:
+                return parametersSweep;
+            case hkTreeNode::LevelTrace:
+                return parametersTrace;
+            default:
+                throw std::invalid_argument("invalid tree level");
+            }
+        }
+
+        std::string labelOf(const hkTreeNode& node)
+        {
+            switch (node.getLevel()) {
+            case hkTreeNode::LevelGroup:
+                return iso_8859_1_to_utf8(node.get(Group::Label));
+            case hkTreeNode::LevelSeries:
+                return iso_8859_1_to_utf8(node.get(Series::Label));
+            case hkTreeNode::LevelSweep:
+                return iso_8859_1_to_utf8(node.get(Sweep::Label));
+            default:
+                return formTraceName(node, node.get(Trace::TraceID));
+            }
+        }
+
+        std::shared_ptr<const std::regex> compile(std::string_view regex)
+        {
+            return std::make_shared<const std::regex>(regex.begin(), regex.end(), std::regex::ECMAScript | std::regex::optimize);
+        }
+    }
+
+    TreeQuery::Predicate& TreeQuery::add(Predicate::Kind kind, int level, std::string_view param)
+    {
+        auto& p = predicates.emplace_back(Predicate{ kind, level });
+        if (kind == Predicate::Kind::Label || kind == Predicate::Kind::Time) {
+            return p;
+        }
+        const bool numeric = kind == Predicate::Kind::Range;
+        for (const auto& candidate : parametersOfLevel(level)) {
+            const auto type = ParameterTable::columnTypeOf(candidate);
+            if (type && param == candidate.name && (*type != ParameterTable::ColumnType::Text) == numeric) {
+                p.param = &candidate;
+                return p;
+            }
+        }
+        predicates.pop_back();
+        throw std::invalid_argument("no " + std::string(numeric ? "numeric" : "text") + " parameter '"
+            + std::string(param) + "' at level " + std::to_string(level));
+    }
+
+    TreeQuery& TreeQuery::label(int level, std::string_view regex)
+    {
+        if (level < hkTreeNode::LevelGroup || level > hkTreeNode::LevelTrace) {
+            throw std::invalid_argument("labels can be queried for groups, series, sweeps and traces only");
+        }
+        auto re = compile(regex);
+        add(Predicate::Kind::Label, level).re = std::move(re);
+        return *this;
+    }
+
+    TreeQuery& TreeQuery::range(int level, std::string_view param, double min, double max)
+    {
+        auto& p = add(Predicate::Kind::Range, level, param);
+        p.min = min;
+        p.max = max;
+        return *this;
+    }
+
+    TreeQuery& TreeQuery::equals(int level, std::string_view param, std::string_view text)
+    {
+        add(Predicate::Kind::TextEquals, level, param).text = text;
+        return *this;
+    }
+
+    TreeQuery& TreeQuery::matches(int level, std::string_view param, std::string_view regex)
+    {
+        auto re = compile(regex);
+        add(Predicate::Kind::TextRegex, level, param).re = std::move(re);
+        return *this;
+    }
+
+    TreeQuery& TreeQuery::timeWindow(int level, double t_start, double t_end)
+    {
+        if (level != hkTreeNode::LevelSeries && level != hkTreeNode::LevelSweep) {
+            throw std::invalid_argument("time windows can be queried for series and sweeps only");
+        }
+        auto& p = add(Predicate::Kind::Time, level);
+        p.min = t_start;
+        p.max = t_end;
+        return *this;
+    }
+
+    hkTreeView TreeQuery::run(hkTree& pultree) const
+    {
+        std::array<std::vector<const Predicate*>, NumLevels> by_level;
+        for (const auto& p : predicates) {
+            by_level.at(p.level).push_back(&p);
+        }
+
+        // parameters are decoded only for the nodes visited, i.e. not for subtrees of nodes that failed
+        auto passes = [&](const hkTreeNode& node) {
+            const auto level = node.getLevel();
+            for (const auto* p : by_level[level]) {
+                switch (p->kind) {
+                case Predicate::Kind::Label:
+                    if (!std::regex_search(labelOf(node), *p->re)) {
+                        return false;
+                    }
+                    break;
+                case Predicate::Kind::Time: {
+                    constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+                    const double t = (level == hkTreeNode::LevelSeries ? node.get(Series::Time, nan)
+                        : node.get(Sweep::Time, nan)) - node.getTime0();
+                    if (!(t >= p->min && t < p->max)) {
+                        return false;
+                    }
+                }
+                    break;
+                case Predicate::Kind::Range: {
+                    const double v = ParameterTable::numericValueOf(*p->param, node);
+                    if (!(v >= p->min && v <= p->max)) {
+                        return false;
+                    }
+                }
+                    break;
+                case Predicate::Kind::TextEquals:
+                case Predicate::Kind::TextRegex: {
+                    const auto value = ParameterTable::textValueOf(*p->param, node);
+                    if (!value) {
+                        return false;
+                    }
+                    const auto text = iso_8859_1_to_utf8(*value);
+                    if (p->kind == Predicate::Kind::TextEquals ? text != p->text : !std::regex_search(text, *p->re)) {
+                        return false;
+                    }
+                }
+                    break;
+                }
+            }
+            return true;
+        };
+
+        // depth first, subtrees of nodes that fail are not visited
+        auto select = [&](auto& self, const hkTreeNode& node, hkNodeView& view) -> bool {
+            view.p_node = &node;
+            if (node.getLevel() == hkTreeNode::LevelTrace) {
+                return true;
+            }
+            for (const auto& child : node.Children) {
+                if (passes(child)) {
+                    hkNodeView child_view;
+                    if (self(self, child, child_view)) {
+                        view.children.emplace_back(std::move(child_view));
+                    }
+                }
+            }
+            return !view.children.empty();
+        };
+
+        hkTreeView tree;
+        auto& root = pultree.GetRootNode();
+        tree.root.p_node = &root;
+        if (passes(root)) {
+            select(select, root, tree.root);
+        }
+        return tree;
+    }
+}
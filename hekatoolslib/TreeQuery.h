@@ -0,0 +1,106 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE_QUERY_H
+#define TREE_QUERY_H
+
+#pragma once
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "hkTree.h"
+#include "hkTreeView.h"
+#include "PMparameters.h"
+
+namespace hkLib {
+
+    /// <summary>
+    /// Selection of groups, series, sweeps and traces of a pul tree by predicates over
+    /// labels and parameter values. All predicates of a level must hold for a node to be selected,
+    /// a node that fails is skipped with its whole subtree, so evaluation stops at the highest level that fails.
+    /// Regular expressions (ECMAScript syntax, matching any part of the text) are compiled when added,
+    /// parameter values are decoded only for the nodes visited when the query is run (see ParameterTable::numericValueOf).
+    /// Example: all traces with Rs between 5 and 20 MOhm in series whose label starts with "IV":
+    /// TreeQuery().label(hkTreeNode::LevelSeries, "^IV").range(hkTreeNode::LevelTrace, "Rs", 5e6, 20e6).run(pultree)
+    /// </summary>
+    class TreeQuery {
+    public:
+        /// <summary>
+        /// label matches regular expression, for traces the name as formed by formTraceName is used
+        /// (the label of the node otherwise), throws std::regex_error for invalid expressions
+        /// </summary>
+        TreeQuery& label(int level, std::string_view regex);
+
+        /// <summary>
+        /// min &lt;= value &lt;= max for a numeric parameter (cf. PMparameters.h, e.g. "Rs" of traces),
+        /// throws std::invalid_argument if the level has no such numeric parameter
+        /// </summary>
+        TreeQuery& range(int level, std::string_view param, double min, double max);
+
+        /// <summary>
+        /// numeric parameter equals value (codes of enumerations, e.g. "Recording Mode", are compared as numbers)
+        /// </summary>
+        TreeQuery& equals(int level, std::string_view param, double value) { return range(level, param, value, value); };
+
+        /// <summary>
+        /// text parameter equals text exactly
+        /// </summary>
+        TreeQuery& equals(int level, std::string_view param, std::string_view text);
+
+        /// <summary>
+        /// text parameter matches regular expression
+        /// </summary>
+        TreeQuery& matches(int level, std::string_view param, std::string_view regex);
+
+        /// <summary>
+        /// t_start &lt;= time &lt; t_end for series (SeTime) or sweeps (SwTime), in s relative to the
+        /// time reference of the tree (cf. hkTreeNode::getTime0), i.e. as "Rel. SeTime" and "Rel. Sweep Time"
+        /// </summary>
+        TreeQuery& timeWindow(int level, double t_start, double t_end);
+
+        bool empty() const { return predicates.empty(); };
+
+        /// <summary>
+        /// evaluate the query on a pul tree
+        /// </summary>
+        /// <param name="pultree">pulse tree</param>
+        /// <returns>view of the selected nodes, branches without selected traces are omitted,
+        /// the view refers to the tree nodes, so it must not outlive the tree</returns>
+        hkTreeView run(hkTree& pultree) const;
+
+    private:
+        struct Predicate {
+            enum class Kind { Label, Range, TextEquals, TextRegex, Time };
+            Kind kind;
+            int level;
+            const PMparameter* param{ nullptr };
+            double min{}, max{};
+            std::string text{};
+            std::shared_ptr<const std::regex> re{};
+        };
+        Predicate& add(Predicate::Kind kind, int level, std::string_view param = {});
+
+        std::vector<Predicate> predicates;
+    };
+}
+
+#endif // !TREE_QUERY_H
@@ -27,11 +27,23 @@
 #include <sstream>
 #include <stdexcept>
 #include <memory>
+#include <optional>
 #include <cstring>
 #include <cassert>
+#include <locale>
+#include <iomanip>
+#include <span>
+#include <vector>
+#include <algorithm>
 #include "helpers.h"
 #include "hkTree.h"
 #include "DatFile.h"
+#include "TraceView.h"
+#include "TraceBatchReader.h"
+#include "TraceChunkReader.h"
+#include "SampleEncoder.h"
+#include "ParallelPipeline.h"
+#include "PositionalReader.h"
 #include "PMparameters.h"
 #include "exportIBW.h"
 #include "igor_ipf.h"
@@ -62,54 +74,67 @@ namespace hkLib {
 		return static_cast<int16_t>(cksum & 0xffff);
 	}
 
-	std::string MakeWaveNote(hkTreeNode& TrRecord)
+	/// <summary>
+	/// create wave note from the parameters of the trace and its ancestors,
+	/// the ancestor parts are taken from blocks if given
+	/// </summary>
+	static std::string MakeWaveNote(hkTreeNode& TrRecord, MetadataBlockCache* blocks)
 	{
-		locale_manager lm;
-		lm.setLocale("C"); // always use C locale for Igor wavenotes
-		std::stringstream note;
-		formatParamListExportIBW(*TrRecord.getParent()->getParent()->getParent()->getParent(), parametersRoot, note);
-		formatParamListExportIBW(*TrRecord.getParent()->getParent()->getParent(), parametersGroup, note);
-		formatParamListExportIBW(*TrRecord.getParent()->getParent(), parametersSeries, note);
-		formatParamListExportIBW(*TrRecord.getParent(), parametersSweep, note);
-		formatParamListExportIBW(TrRecord, parametersTrace, note);
-		return note.str();
+		std::optional<MetadataBlockCache> local;
+		if (!blocks) {
+			blocks = &local.emplace(MetadataBlockCache::Format::WaveNote);
+		}
+		assert(blocks->getFormat() == MetadataBlockCache::Format::WaveNote);
+		const auto& sweep = *TrRecord.getParent();
+		const auto& series = *sweep.getParent();
+		const auto& group = *series.getParent();
+		std::string note;
+		note.append(blocks->get(*group.getParent())).append(blocks->get(group))
+			.append(blocks->get(series)).append(blocks->get(sweep));
+		blocks->append(TrRecord, note);
+		return note;
 	}
 
 
-    unsigned ExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename)
+	/// <summary>
+	/// Igor wave type corresponding to data format
+	/// </summary>
+	static int16_t IgorWaveType(char dataformat)
 	{
-        unsigned err{0};
-        assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
-		char dataformat = TrRecord.getChar(TrDataFormat);
-
-		std::string xunit, yunit;
-		yunit = TrRecord.getString(TrYUnit); // assuming the string is zero terminated...
-		xunit = TrRecord.getString(TrXUnit);
-		double x0 = TrRecord.extractLongReal(TrXStart), deltax = TrRecord.extractLongReal(TrXInterval);
-		auto trdatapoints = TrRecord.extractValue<uint32_t>(TrDataPoints);
-
-		auto target = std::make_unique<double[]>(trdatapoints);
-
-		switch (dataformat)
-		{
+		switch (dataformat) {
 		case DFT_int16:
-			ReadScaleAndConvert<int16_t>(datafile, TrRecord, trdatapoints, target.get());
-			break;
+			return NT_I16;
 		case DFT_int32:
-			ReadScaleAndConvert<int32_t>(datafile, TrRecord, trdatapoints, target.get());
-			break;
+			return NT_I32;
 		case DFT_float:
-			ReadScaleAndConvert<float>(datafile, TrRecord, trdatapoints, target.get());
-			break;
-		case DFT_double:
-			ReadScaleAndConvert<double>(datafile, TrRecord, trdatapoints, target.get());
-			break;
+			return NT_FP32;
 		default:
-			throw std::runtime_error("unknown data format type");
-			break;
+			return NT_FP64;
 		}
+	}
+
+	/// <summary>
+	/// write ibw header, the trace data encoded by encoder (by calling write_data) and the wave note
+	/// </summary>
+	template<typename WriteData> static unsigned WriteIBW(hkTreeNode& TrRecord, std::size_t trdatapoints,
+		const SampleEncoder& encoder, std::ostream& outfile, std::string& wavename, MetadataBlockCache* blocks,
+		WriteData&& write_data)
+	{
+        unsigned err{0};
+        assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
+		std::string xunit, yunit;
+		yunit = TrRecord.get(Trace::YUnit); // assuming the string is zero terminated...
+		xunit = TrRecord.get(Trace::XUnit);
+		double x0 = TrRecord.get(Trace::XStart), deltax = TrRecord.get(Trace::XInterval);
 
-		std::string note{ MakeWaveNote(TrRecord) };
+		std::string note{ MakeWaveNote(TrRecord, blocks) };
+		if (encoder.type() == ExportDataType::Native) {
+			// wave holds raw samples, physical value = ScaleFactor * sample
+			std::ostringstream scale;
+			scale.imbue(std::locale::classic());
+			scale << "ScaleFactor=" << std::setprecision(17) << encoder.outputScaler() << " " << yunit << "\n";
+			note += scale.str();
+		}
 
 		BinHeader5 bh{};
 		// make sure the packing of the structs is as expected:
@@ -121,9 +146,9 @@ namespace hkLib {
 
 		bh.version = 5;
 		bh.noteSize = int32_t(note.size());
-		bh.wfmSize = int32_t(numbytes_wh + sizeof(double) * trdatapoints);
+		bh.wfmSize = int32_t(numbytes_wh + encoder.outputSampleSize() * trdatapoints);
 		// we will calculate checksum later, all other entries in bh remain 0
-		wh.type = NT_FP64;
+		wh.type = IgorWaveType(encoder.outputFormat());
         if(wavename.length()>MAX_WAVE_NAME5){
             err|=WARNFLAG_WNAMETRUNCATED;
             // truncate front of wavename:
@@ -146,11 +171,58 @@ namespace hkLib {
 
 		outfile.write(reinterpret_cast<char*>(&bh), sizeof(bh));
 		outfile.write(reinterpret_cast<char*>(&wh), numbytes_wh);
-		outfile.write(reinterpret_cast<char*>(target.get()), sizeof(double) * trdatapoints);
+		write_data();
 		outfile.write(note.data(), note.size());
         return err;
 	}
 
+    unsigned ExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+		ExportDataType dtype, MetadataBlockCache* blocks)
+	{
+		TraceChunkReader chunks(datafile, TrRecord);
+		return ExportTrace(chunks, TrRecord, outfile, wavename, dtype, blocks);
+	}
+
+	unsigned ExportTrace(TraceChunkReader& chunks, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+		ExportDataType dtype, MetadataBlockCache* blocks)
+	{
+		SampleEncoder encoder(dtype, chunks.dataFormat(), chunks.needsSwap(), chunks.scaler());
+		return WriteIBW(TrRecord, chunks.size(), encoder, outfile, wavename, blocks, [&] {
+			for (auto raw = chunks.nextRaw(); !raw.empty(); raw = chunks.nextRaw()) {
+				const auto data = encoder.encode(raw.data(), raw.size() / chunks.sampleSize());
+				outfile.write(data.data(), data.size());
+			}
+		});
+	}
+
+	unsigned ExportTrace(const TraceView& trace, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+		ExportDataType dtype, MetadataBlockCache* blocks)
+	{
+		SampleEncoder encoder(dtype, trace.dataFormat(), trace.needsSwap(), trace.scaler());
+		return WriteIBW(TrRecord, trace.size(), encoder, outfile, wavename, blocks, [&] {
+			// encode chunk-wise, so no converted copy of the complete trace is needed
+			const auto raw = trace.rawBytes();
+			for (std::size_t i = 0; i < trace.size(); i += TraceChunkReader::DefaultChunkSamples) {
+				const auto n = std::min(TraceChunkReader::DefaultChunkSamples, trace.size() - i);
+				const auto data = encoder.encode(raw.data() + i * trace.sampleSize(), n);
+				outfile.write(data.data(), data.size());
+			}
+		});
+	}
+
+	unsigned ExportTrace(std::span<const double> data, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+		ExportDataType dtype, MetadataBlockCache* blocks)
+	{
+		if (dtype == ExportDataType::Native) {
+			throw std::invalid_argument("export of native data type requires raw trace data");
+		}
+		SampleEncoder encoder(dtype, DFT_double, false, 1.0);
+		return WriteIBW(TrRecord, data.size(), encoder, outfile, wavename, blocks, [&] {
+			const auto encoded = encoder.encode(data);
+			outfile.write(encoded.data(), encoded.size());
+		});
+	}
+
 	// Warning: this ist not recognize as a valid record by Igor!
 	void WriteIgorPlatformRecord(std::ostream& outfile)
 	{
@@ -177,9 +249,12 @@ namespace hkLib {
 		outfile.write(reinterpret_cast<char*>(&pfhr), sizeof(PackedFileRecordHeader));
 	}
 
-    unsigned ExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix)
+	/// <summary>
+	/// collect all traces of the pulse tree and the corresponding wavenames
+	/// </summary>
+	static void CollectTraces(DatFile& datf, const std::string& prefix, std::vector<hkTreeNode*>& traces,
+		std::vector<std::string>& wavenames)
 	{
-        unsigned err{0};
 		int groupcount = 0;
 		for (auto& group : datf.GetPulTree().GetRootNode().Children) {
 			++groupcount;
@@ -192,18 +267,80 @@ namespace hkLib {
 					int tracecount = 0;
 					for (auto& trace : sweep.Children) {
 						++tracecount;
-						std::stringstream wavename;
-						wavename << prefix << "_" << groupcount << "_" << seriescount << "_" << sweepcount << "_";
-						wavename << formTraceName(trace, tracecount);
-						std::string filename = path + wavename.str() + ".ibw";
-						std::ofstream outfile(filename, std::ios::binary | std::ios::out);
-                        auto wname = wavename.str();
-                        err |= ExportTrace(datafile, trace, outfile, wname);
+						traces.push_back(&trace);
+						wavenames.push_back(prefix + "_" + std::to_string(groupcount) + "_" + std::to_string(seriescount) +
+							"_" + std::to_string(sweepcount) + "_" + formTraceName(trace, tracecount));
 					}
 				}
 			}
 		}
+	}
+
+    unsigned ExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix,
+		unsigned num_threads, ExportDataType dtype)
+	{
+		if (const auto* mapped = getMappedFileBuf(datafile); mapped && num_threads != 1) {
+			return ExportAllTraces(PositionalReader(mapped->getMapping()), datf, path, prefix, num_threads, dtype);
+		}
+        unsigned err{0};
+		// collect traces first, so they can be read in file order
+		std::vector<hkTreeNode*> traces;
+		std::vector<std::string> wavenames;
+		CollectTraces(datf, prefix, traces, wavenames);
+		// parameters of root, group, series and sweep are formatted once, not for every trace
+		MetadataBlockCache blocks(MetadataBlockCache::Format::WaveNote);
+		// traces already in the trace cache are exported right away (unless raw samples are needed),
+		// the others are batch-read
+		auto* cache = dtype != ExportDataType::Native ? &datf.GetTraceCache() : nullptr;
+		std::vector<hkTreeNode*> to_read;
+		std::vector<std::size_t> to_read_index;
+		for (std::size_t i = 0; i < traces.size(); ++i) {
+			if (auto data = cache ? cache->find(traces[i]) : nullptr) {
+				std::ofstream outfile(path + wavenames[i] + ".ibw", std::ios::binary | std::ios::out);
+				err |= ExportTrace(*data, *traces[i], outfile, wavenames[i], dtype, &blocks);
+			}
+			else if (traces[i]->get(Trace::DataPoints) > TraceChunkReader::DefaultChunkSamples) {
+				// very long traces are streamed in chunks rather than read as a whole
+				std::ofstream outfile(path + wavenames[i] + ".ibw", std::ios::binary | std::ios::out);
+				err |= ExportTrace(datafile, *traces[i], outfile, wavenames[i], dtype, &blocks);
+			}
+			else {
+				to_read.push_back(traces[i]);
+				to_read_index.push_back(i);
+			}
+		}
+		TraceBatchReader reader(datafile);
+		reader.read({ to_read.data(), to_read.size() }, [&](std::size_t k, const TraceView& data) {
+			const auto i = to_read_index[k];
+			std::string filename = path + wavenames[i] + ".ibw";
+			std::ofstream outfile(filename, std::ios::binary | std::ios::out);
+			err |= ExportTrace(data, *traces[i], outfile, wavenames[i], dtype, &blocks);
+		});
         return err;
 	}
 
+	unsigned ExportAllTraces(const PositionalReader& reader, DatFile& datf, const std::string& path,
+		const std::string& prefix, unsigned num_threads, ExportDataType dtype)
+	{
+		std::vector<hkTreeNode*> traces;
+		std::vector<std::string> wavenames;
+		CollectTraces(datf, prefix, traces, wavenames);
+		// parameters of root, group, series and sweep are formatted once, not for every trace
+		MetadataBlockCache blocks(MetadataBlockCache::Format::WaveNote);
+		auto* cache = dtype != ExportDataType::Native ? &datf.GetTraceCache() : nullptr;
+		unsigned err{ 0 };
+		// each worker reads, converts and writes whole traces, every trace goes to its own file
+		RunOrderedPipeline(traces.size(), num_threads,
+			[&](std::size_t i) {
+				std::ofstream outfile(path + wavenames[i] + ".ibw", std::ios::binary | std::ios::out);
+				if (auto data = cache ? cache->find(traces[i]) : nullptr) {
+					return ExportTrace(*data, *traces[i], outfile, wavenames[i], dtype, &blocks);
+				}
+				TraceChunkReader chunks(reader, *traces[i]);
+				return ExportTrace(chunks, *traces[i], outfile, wavenames[i], dtype, &blocks);
+			},
+			[&](std::size_t, unsigned trace_err) { err |= trace_err; });
+		return err;
+	}
+
 }
@@ -23,6 +23,14 @@
 #pragma once
 
 #include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include "DatFile.h"
+#include "TraceView.h"
+#include "TraceChunkReader.h"
+#include "SampleEncoder.h"
+#include "MetadataBlockCache.h"
 
 namespace hkLib {
     struct PackedFileRecordHeader {
@@ -58,8 +66,41 @@ namespace hkLib {
 
     void WriteIgorPlatformRecord(std::ostream& outfile);
     void WriteIgorProcedureRecord(std::ostream& outfile);
-    unsigned ExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix);
-    unsigned ExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename);
+    /// <summary>
+    /// export all traces of datf as individual ibw files. If datafile is memory mapped,
+    /// the traces are exported in parallel (see overload below), output is the same in any case.
+    /// </summary>
+    /// <param name="num_threads">number of threads, 0: one per core, 1: serial export</param>
+    /// <param name="dtype">data type of exported waves</param>
+    unsigned ExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix,
+        unsigned num_threads = 0, ExportDataType dtype = ExportDataType::Float64);
+    /// <summary>
+    /// export all traces of datf as individual ibw files, reading, converting and writing
+    /// traces on num_threads worker threads (0: one per core)
+    /// </summary>
+    unsigned ExportAllTraces(const PositionalReader& reader, DatFile& datf, const std::string& path,
+        const std::string& prefix, unsigned num_threads = 0, ExportDataType dtype = ExportDataType::Float64);
+    /// <summary>
+    /// Export trace as Igor binary wave. With dtype Float32 the wave is single precision (NT_FP32),
+    /// with dtype Native it holds the raw samples (NT_I16, NT_I32, ...) and the wave note
+    /// contains the entry ScaleFactor to convert them to physical units.
+    /// If blocks (format WaveNote) is given, the wave note parts of root, group, series and sweep are taken
+    /// from it, so they are formatted only once when exporting many traces.
+    /// </summary>
+    unsigned ExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+        ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
+    /// <summary>
+    /// export trace read chunk-wise, i.e. in constant memory regardless of the length of the trace
+    /// </summary>
+    unsigned ExportTrace(TraceChunkReader& chunks, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+        ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
+    unsigned ExportTrace(const TraceView& trace, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+        ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
+    /// <summary>
+    /// export converted trace data, dtype Native is not supported (throws std::invalid_argument)
+    /// </summary>
+    unsigned ExportTrace(std::span<const double> data, hkTreeNode& TrRecord, std::ostream& outfile, std::string& wavename,
+        ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
 
 }
 
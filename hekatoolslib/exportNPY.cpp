@@ -27,13 +27,28 @@
 #include <sstream>
 #include <stdexcept>
 #include <memory>
+#include <optional>
 #include <cstring>
 #include <cassert>
+#include <locale>
+#include <iomanip>
 #include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
 #include <cstddef>
+#include <span>
 #include "helpers.h"
 #include "hkTree.h"
 #include "DatFile.h"
+#include "TraceView.h"
+#include "TraceBatchReader.h"
+#include "TraceChunkReader.h"
+#include "SampleEncoder.h"
+#include "ExportManifest.h"
+#include "machineinfo.h"
+#include "ParallelPipeline.h"
+#include "PositionalReader.h"
 #include "PMparameters.h"
 #include "exportNPY.h"
 
@@ -61,82 +76,78 @@ namespace hkLib {
         os.seekp(0, std::ios::end);
     }
 
-    static std::ostream& writeNpy(std::ostream& os, const std::vector<double>& v, bool raw_only)
+    /// <summary>
+    /// numpy type descriptor for samples of dataformat in machine byte order
+    /// </summary>
+    static std::string npyDescr(char dataformat)
     {
-        if (!raw_only) {
-            os << NPY_MAGIC << NPY_VERSION_MAJOR << NPY_VERSION_MINOR << '\0' << '\0' <<
-                "{'descr': 'f8', 'fortran_order': False, 'shape': (" << v.size() << ",), }";
-            // NOTE: 'f8': double in native byte order, '<f8': double in little endian byte order
-            fixNpyHeader(os);
+        if (dataformat == DFT_double) {
+            return "f8"; // NOTE: 'f8': double in native byte order, '<f8': double in little endian byte order
+        }
+        std::string descr(1, MachineIsLittleEndian() ? '<' : '>');
+        switch (dataformat) {
+        case DFT_int16:
+            return descr + "i2";
+        case DFT_int32:
+            return descr + "i4";
+        default:
+            return descr + "f4";
         }
-        os.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(double));
-        return os;
     }
 
-	static std::ostream& writeNpyArray(std::ostream& os, const std::vector<std::vector<double> >& v)
-	{
-        auto n_points = v.front().size();
-        auto n_traces = v.size();
+    static std::ostream& writeNpyHeader(std::ostream& os, std::size_t count, char dataformat = DFT_double)
+    {
         os << NPY_MAGIC << NPY_VERSION_MAJOR << NPY_VERSION_MINOR << '\0' << '\0' <<
-			"{'descr': 'f8', 'fortran_order': False, 'shape': (" << n_traces << ", "
-			<< n_points << "), }";
-		// NOTE: 'f8': double in native byte order, '<f8': double in little endian byte order
+            "{'descr': '" << npyDescr(dataformat) << "', 'fortran_order': False, 'shape': (" << count << ",), }";
         fixNpyHeader(os);
+        return os;
+    }
 
-        for (auto& v2 : v) {
-            assert(v2.size() == n_points);
-            os.write(reinterpret_cast<const char*>(v2.data()), n_points * sizeof(double));
-        }
-		return os;
-	}
-
-    static std::vector<double> read_data(std::istream& datafile, const hkTreeNode& TrRecord)
+    static std::ostream& writeNpyArrayHeader(std::ostream& os, std::size_t n_traces, std::size_t n_points)
     {
-        assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
-        auto dataformat = TrRecord.getChar(TrDataFormat);
-        auto trdatapoints = TrRecord.extractValue<uint32_t>(TrDataPoints);
-        std::vector<double> tr_data(trdatapoints);
-        switch (dataformat)
-        {
-        case DFT_int16:
-            ReadScaleAndConvert<int16_t>(datafile, TrRecord, tr_data.size(), tr_data.data());
-            break;
-        case DFT_int32:
-            ReadScaleAndConvert<int32_t>(datafile, TrRecord, tr_data.size(), tr_data.data());
-            break;
-        case DFT_float:
-            ReadScaleAndConvert<float>(datafile, TrRecord, tr_data.size(), tr_data.data());
-            break;
-        case DFT_double:
-            ReadScaleAndConvert<double>(datafile, TrRecord, tr_data.size(), tr_data.data());
-            break;
-        default:
-            throw std::runtime_error{ "unknown data format type" };
-            break;
-        }
+        os << NPY_MAGIC << NPY_VERSION_MAJOR << NPY_VERSION_MINOR << '\0' << '\0' <<
+            "{'descr': 'f8', 'fortran_order': False, 'shape': (" << n_traces << ", "
+            << n_points << "), }";
+        // NOTE: 'f8': double in native byte order, '<f8': double in little endian byte order
+        fixNpyHeader(os);
+        return os;
+    }
 
-        return tr_data;
+    void NPYorBINExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+        ExportDataType dtype, MetadataBlockCache* blocks)
+    {
+        TraceChunkReader chunks(datafile, TrRecord);
+        NPYorBINExportTrace(chunks, TrRecord, std::move(filename), createJSON, dtype, blocks);
     }
 
-    void NPYorBINExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON = true)
+    /// <summary>
+    /// write npy (or raw binary) file with count samples encoded by encoder, the data is written by write_data(os),
+    /// and (optionally) the JSON file with the metadata
+    /// </summary>
+    template<typename WriteData> static void WriteNpyOrBin(hkTreeNode& TrRecord, std::size_t count,
+        const SampleEncoder& encoder, std::filesystem::path filename, bool createJSON, MetadataBlockCache* blocks,
+        WriteData&& write_data)
     {
         assert(TrRecord.getLevel() == hkTreeNode::LevelTrace);
-        locale_manager lm;
-        lm.setLocale("C");
-        auto yunit = TrRecord.getString(TrYUnit);
-        auto xunit = TrRecord.getString(TrXUnit);
-        auto x0 = TrRecord.extractLongReal(TrXStart);
-        auto deltax = TrRecord.extractLongReal(TrXInterval);
+        auto yunit = TrRecord.get(Trace::YUnit);
+        auto xunit = TrRecord.get(Trace::XUnit);
+        auto x0 = TrRecord.get(Trace::XStart);
+        auto deltax = TrRecord.get(Trace::XInterval);
 
-        auto tr_data = read_data(datafile, TrRecord);
         
         std::ofstream outfile(filename, std::ios::binary | std::ios::out);
         if (!outfile)
         {
             throw std::runtime_error{ "could not create file" };
         }
+        // the C locale is imbued rather than set globally, so traces can be exported by several threads at once
+        outfile.imbue(std::locale::classic());
         bool binexport = filename.extension() != ".npy";
-        if (!writeNpy(outfile, tr_data, binexport))
+        if (!binexport) {
+            writeNpyHeader(outfile, count, encoder.outputFormat());
+        }
+        write_data(outfile);
+        if (!outfile)
         {
             throw std::runtime_error{ "error while writing npy file" };
         }
@@ -147,70 +158,109 @@ namespace hkLib {
             if (!jsonfile) {
                 throw std::runtime_error{ "could not create JSON file" };
             }
+            jsonfile.imbue(std::locale::classic());
             jsonfile << std::scientific << "{ \"x_0\": " << x0 << ", \"delta_x\": " << deltax
-                << ", \"numpnts\": " << tr_data.size() << ", \"unit_x\": \"" << xunit <<
-                "\", \"unit_y\": \"" << yunit << "\", \"params\": { " <<
-                "\"trace\": " << std::defaultfloat;
-            formatParamListExportJSON(TrRecord, parametersTrace, jsonfile);
-            jsonfile << ", \"sweep\": ";
-            const auto sweep = TrRecord.getParent();
-            formatParamListExportJSON(*sweep, parametersSweep, jsonfile);
-            jsonfile << ", \"series\": ";
-            const auto series = sweep->getParent();
-            formatParamListExportJSON(*series, parametersSeries, jsonfile);
-            jsonfile << ", \"group\": ";
-            const auto group = series->getParent();
-            formatParamListExportJSON(*group, parametersGroup, jsonfile);
-            jsonfile << ", \"root\": ";
-            const auto root = group->getParent();
-            formatParamListExportJSON(*root, parametersRoot, jsonfile);
-            jsonfile << " } }";
+                << ", \"numpnts\": " << count << ", \"unit_x\": \"" << xunit <<
+                "\", \"unit_y\": \"" << yunit << "\", ";
+            if (encoder.type() != ExportDataType::Float64) {
+                // physical value = scale_factor * sample
+                jsonfile << "\"dtype\": \"" << ExportDataTypeName(encoder.type()) << "\", \"scale_factor\": "
+                    << std::defaultfloat << std::setprecision(17) << encoder.outputScaler() << std::setprecision(6) << ", ";
+            }
+            std::optional<MetadataBlockCache> local;
+            if (!blocks) {
+                blocks = &local.emplace(MetadataBlockCache::Format::JSON);
+            }
+            assert(blocks->getFormat() == MetadataBlockCache::Format::JSON);
+            const auto& sweep = *TrRecord.getParent();
+            const auto& series = *sweep.getParent();
+            const auto& group = *series.getParent();
+            std::string params{ "\"params\": { \"trace\": " };
+            blocks->append(TrRecord, params);
+            params.append(", \"sweep\": ").append(blocks->get(sweep));
+            params.append(", \"series\": ").append(blocks->get(series));
+            params.append(", \"group\": ").append(blocks->get(group));
+            params.append(", \"root\": ").append(blocks->get(*group.getParent()));
+            params.append(" } }");
+            jsonfile << params;
             if (!jsonfile) {
                 throw std::runtime_error{ "error while writing JSON file" };
             }
         }
     }
 
+    void NPYorBINExportTrace(TraceChunkReader& chunks, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+        ExportDataType dtype, MetadataBlockCache* blocks)
+    {
+        SampleEncoder encoder(dtype, chunks.dataFormat(), chunks.needsSwap(), chunks.scaler());
+        WriteNpyOrBin(TrRecord, chunks.size(), encoder, std::move(filename), createJSON, blocks, [&](std::ostream& os) {
+            for (auto raw = chunks.nextRaw(); !raw.empty(); raw = chunks.nextRaw()) {
+                const auto data = encoder.encode(raw.data(), raw.size() / chunks.sampleSize());
+                os.write(data.data(), data.size());
+            }
+        });
+    }
+
+    void NPYorBINExportTrace(const TraceView& trace, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+        ExportDataType dtype, MetadataBlockCache* blocks)
+    {
+        SampleEncoder encoder(dtype, trace.dataFormat(), trace.needsSwap(), trace.scaler());
+        WriteNpyOrBin(TrRecord, trace.size(), encoder, std::move(filename), createJSON, blocks, [&](std::ostream& os) {
+            // encode chunk-wise, so no converted copy of the complete trace is needed
+            const auto raw = trace.rawBytes();
+            for (std::size_t i = 0; i < trace.size(); i += TraceChunkReader::DefaultChunkSamples) {
+                const auto n = std::min(TraceChunkReader::DefaultChunkSamples, trace.size() - i);
+                const auto data = encoder.encode(raw.data() + i * trace.sampleSize(), n);
+                os.write(data.data(), data.size());
+            }
+        });
+    }
+
+    void NPYorBINExportTrace(std::span<const double> tr_data, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+        ExportDataType dtype, MetadataBlockCache* blocks)
+    {
+        if (dtype == ExportDataType::Native) {
+            throw std::invalid_argument("export of native data type requires raw trace data");
+        }
+        SampleEncoder encoder(dtype, DFT_double, false, 1.0);
+        WriteNpyOrBin(TrRecord, tr_data.size(), encoder, std::move(filename), createJSON, blocks, [&](std::ostream& os) {
+            const auto data = encoder.encode(tr_data);
+            os.write(data.data(), data.size());
+        });
+    }
+
     static int GetTraceID(const hkTreeNode& n)
     {
-        return n.extractInt32(TrTraceID);
+        return n.get(Trace::TraceID);
     }
 
     void NPYExportTreeSweepsAsArray(std::istream& datafile, const hkTreeView& tree, const std::string_view& path,
-        const std::string_view& prefix, bool createJSON)
+        const std::string_view& prefix, bool createJSON, TraceCache* cache)
     {
         auto series_list = tree.GetViewListForLevel(hkTreeNode::LevelSeries);
+        // one file per trace ID, so the parameters of series and sweeps are used several times
+        MetadataBlockCache blocks(MetadataBlockCache::Format::JSON);
         for (const auto* series : series_list) {
             // we need one array per Series and TraceID
-            // containing all sweeps
-            // get range of trace IDs
-            int seriesID = series->p_node->extractInt32(SeSeriesCount);
-            int groupID = series->p_node->getParent()->extractInt32(GrGroupCount);
-            auto ID_min = std::numeric_limits<int>::max();
-            auto ID_max = std::numeric_limits<int>::min();
+            // containing all sweeps, traces are grouped by ID in one pass
+            int seriesID = series->p_node->get(Series::SeriesCount);
+            int groupID = series->p_node->getParent()->get(Group::GroupCount);
+            std::map<int, std::vector<const hkTreeNode*>> traces_by_ID;
             for (const auto& sweep : series->children) {
                 for (const auto& trace : sweep.children) {
-                    auto ID = GetTraceID(*trace.p_node);
-                    ID_min = std::min(ID_min, ID);
-                    ID_max = std::max(ID_max, ID);
+                    traces_by_ID[GetTraceID(*trace.p_node)].push_back(trace.p_node);
                 }
             }
-            for (auto i = ID_min; i <= ID_max; ++i) {
-                // gather traces
-                std::vector<const hkTreeNode*> traces;
-                for (const auto& sweep : series->children) {
-                    for (const auto& trace : sweep.children) {
-                        auto ID = GetTraceID(*trace.p_node);
-                        if (ID == i) {
-                            traces.push_back(trace.p_node);
-                        }
-                    }
-                }
-                std::vector<std::vector<double> > data;
-                data.reserve(traces.size());
-                for (const auto* p_trace : traces) {
-                    data.emplace_back(read_data(datafile, *p_trace));
+            for (const auto& [i, traces] : traces_by_ID) {
+                // sweeps can differ in length, shorter ones are padded with NaN
+                std::vector<std::size_t> lengths;
+                lengths.reserve(traces.size());
+                for (const auto* trace : traces) {
+                    lengths.push_back(trace->get(Trace::DataPoints));
                 }
+                const auto n_points = *std::max_element(lengths.begin(), lengths.end());
+                const bool is_ragged = std::any_of(lengths.begin(), lengths.end(),
+                    [n_points](std::size_t n) { return n != n_points; });
                 const auto& trace1 = *traces.front();
                 std::string filename{ path };
                 filename += prefix;
@@ -221,47 +271,73 @@ namespace hkLib {
                 {
                     throw std::runtime_error{ "could not create file " + filename };
                 }
-                writeNpyArray(outfile, data);
+                outfile.imbue(std::locale::classic());
+                writeNpyArrayHeader(outfile, traces.size(), n_points);
+                // each sweep is streamed into the file, so at most one sweep is held in memory
+                for (std::size_t k = 0; k < traces.size(); ++k) {
+                    if (auto cached = cache ? cache->find(traces[k]) : nullptr) {
+                        outfile.write(reinterpret_cast<const char*>(cached->data()), cached->size() * sizeof(double));
+                    }
+                    else {
+                        TraceChunkReader chunks(datafile, *traces[k]);
+                        for (auto chunk = chunks.next(); !chunk.empty(); chunk = chunks.next()) {
+                            outfile.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(double));
+                        }
+                    }
+                    if (lengths[k] < n_points) {
+                        const std::vector<double> padding(n_points - lengths[k], std::numeric_limits<double>::quiet_NaN());
+                        outfile.write(reinterpret_cast<const char*>(padding.data()), padding.size() * sizeof(double));
+                    }
+                }
+                if (!outfile)
+                {
+                    throw std::runtime_error{ "error while writing npy file " + filename };
+                }
                 if (createJSON) {
-                    locale_manager lm;
-                    lm.setLocale("C");
                     std::filesystem::path filepath(filename);
                     filepath.replace_extension("json");
                     std::ofstream jsonfile(filepath);
                     if (!jsonfile) {
                         throw std::runtime_error{ "could not create JSON file" };
                     }
-                    auto yunit = trace1.getString(TrYUnit);
-                    auto xunit = trace1.getString(TrXUnit);
-                    auto x0 = trace1.extractLongReal(TrXStart);
-                    auto deltax = trace1.extractLongReal(TrXInterval);
+                    jsonfile.imbue(std::locale::classic());
+                    auto yunit = trace1.get(Trace::YUnit);
+                    auto xunit = trace1.get(Trace::XUnit);
+                    auto x0 = trace1.get(Trace::XStart);
+                    auto deltax = trace1.get(Trace::XInterval);
                     jsonfile << std::scientific << "{\n\"x_0\": " << x0 << ",\n\"delta_x\": " << deltax
-                        << ",\n\"numpnts\": " << data.front().size() << ",\n\"unit_x\": \"" << xunit <<
+                        << ",\n\"numpnts\": " << n_points << ",\n\"unit_x\": \"" << xunit <<
                         "\",\n\"unit_y\": \"" << yunit << "\","
                         << std::defaultfloat;
-                    jsonfile << "\n\"series\": ";
-                    formatParamListExportJSON(*series->p_node, parametersSeries, jsonfile);
-                    jsonfile << ",\n\"group\": ";
+                    if (is_ragged) {
+                        // number of valid points of each sweep, the rest of the row is NaN
+                        jsonfile << "\n\"numpnts_sweeps\": [";
+                        for (std::size_t k = 0; k < lengths.size(); ++k) {
+                            jsonfile << (k ? ", " : "") << lengths[k];
+                        }
+                        jsonfile << "],";
+                    }
                     const auto group = series->p_node->getParent();
-                    formatParamListExportJSON(*group, parametersGroup, jsonfile);
-                    jsonfile << ",\n\"root\": ";
-                    const auto root = group->getParent();
-                    formatParamListExportJSON(*root, parametersRoot, jsonfile);
-                    jsonfile << ",\n\"sweeps\": [\n";
+                    jsonfile << "\n\"series\": " << blocks.get(*series->p_node)
+                        << ",\n\"group\": " << blocks.get(*group)
+                        << ",\n\"root\": " << blocks.get(*group->getParent())
+                        << ",\n\"sweeps\": [\n";
+                    std::string entry;
                     bool is_first = true;
                     for (auto trace : traces) {
                         auto sweep = trace->getParent();
+                        entry.clear();
                         if (is_first) {
                             is_first = false;
                         }
                         else {
-                            jsonfile << ",\n";
+                            entry.append(",\n");
                         }
-                        jsonfile << "{\"trace\": ";
-                        formatParamListExportJSON(*trace, parametersTrace, jsonfile);
-                        jsonfile << ",\n\"sweep\": ";
-                        formatParamListExportJSON(*sweep, parametersSweep, jsonfile);
-                        jsonfile << "\n}";
+                        entry.append("{\"trace\": ");
+                        blocks.append(*trace, entry);
+                        entry.append(",\n\"sweep\": ").append(blocks.get(*sweep));
+                        entry.append("\n}");
+                        jsonfile << entry;
                     }
                     jsonfile << "]\n}\n";
                     if (!jsonfile) {
@@ -272,7 +348,11 @@ namespace hkLib {
         } // end series loop
     }
 
-    void NPYExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix)
+    /// <summary>
+    /// collect all traces of the pulse tree and the corresponding export filenames
+    /// </summary>
+    static void CollectTraces(DatFile& datf, const std::string& path, const std::string& prefix,
+        std::vector<hkTreeNode*>& traces, std::vector<std::string>& filenames)
     {
         auto& root = datf.GetPulTree().GetRootNode();
         int groupcount = 0;
@@ -287,15 +367,118 @@ namespace hkLib {
                     int tracecount = 0;
                     for (auto& trace : sweep.Children) {
                         ++tracecount;
-                        std::stringstream wavename;
-                        wavename << prefix << "_" << groupcount << "_" << seriescount << "_" << sweepcount << "_";
-                        wavename << formTraceName(trace, tracecount);
-                        std::string filename = path + wavename.str() + ".npy";
-                        NPYorBINExportTrace(datafile, trace, filename, true);
+                        traces.push_back(&trace);
+                        filenames.push_back(path + prefix + "_" + std::to_string(groupcount) + "_" +
+                            std::to_string(seriescount) + "_" + std::to_string(sweepcount) + "_" +
+                            formTraceName(trace, tracecount) + ".npy");
                     }
                 }
             }
         }
     }
 
+    /// <summary>
+    /// open manifest file for the export of all traces, named after prefix
+    /// </summary>
+    static std::ofstream OpenManifest(const std::string& path, const std::string& prefix)
+    {
+        std::ofstream manifest(path + prefix + "_manifest.jsonl");
+        if (!manifest) {
+            throw std::runtime_error{ "could not create manifest file" };
+        }
+        return manifest;
+    }
+
+    static std::string FileNameOnly(const std::string& filename)
+    {
+        return std::filesystem::path(filename).filename().string();
+    }
+
+    void NPYExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix,
+        unsigned num_threads, ExportDataType dtype, bool createManifest)
+    {
+        if (const auto* mapped = getMappedFileBuf(datafile); mapped && num_threads != 1) {
+            NPYExportAllTraces(PositionalReader(mapped->getMapping()), datf, path, prefix, num_threads, dtype, createManifest);
+            return;
+        }
+        // collect traces first, so they can be read in file order
+        std::vector<hkTreeNode*> traces;
+        std::vector<std::string> filenames;
+        CollectTraces(datf, path, prefix, traces, filenames);
+        const bool createJSON = !createManifest;
+        // parameters of root, group, series and sweep are formatted once, not for every trace
+        MetadataBlockCache blocks(MetadataBlockCache::Format::JSON);
+        // traces already in the trace cache are exported right away (unless raw samples are needed),
+        // the others are batch-read
+        auto* cache = dtype != ExportDataType::Native ? &datf.GetTraceCache() : nullptr;
+        std::vector<hkTreeNode*> to_read;
+        std::vector<std::size_t> to_read_index;
+        for (std::size_t i = 0; i < traces.size(); ++i) {
+            if (auto data = cache ? cache->find(traces[i]) : nullptr) {
+                NPYorBINExportTrace(*data, *traces[i], filenames[i], createJSON, dtype, &blocks);
+            }
+            else if (traces[i]->get(Trace::DataPoints) > TraceChunkReader::DefaultChunkSamples) {
+                // very long traces are streamed in chunks rather than read as a whole
+                NPYorBINExportTrace(datafile, *traces[i], filenames[i], createJSON, dtype, &blocks);
+            }
+            else {
+                to_read.push_back(traces[i]);
+                to_read_index.push_back(i);
+            }
+        }
+        TraceBatchReader reader(datafile);
+        reader.read({ to_read.data(), to_read.size() }, [&](std::size_t k, const TraceView& trace) {
+            const auto i = to_read_index[k];
+            NPYorBINExportTrace(trace, *traces[i], filenames[i], createJSON, dtype, &blocks);
+        });
+        if (createManifest) {
+            auto manifest_file = OpenManifest(path, prefix);
+            ManifestWriter manifest(manifest_file, dtype);
+            for (std::size_t i = 0; i < traces.size(); ++i) {
+                manifest.addTrace(*traces[i], FileNameOnly(filenames[i]));
+            }
+            if (!manifest_file) {
+                throw std::runtime_error{ "error while writing manifest file" };
+            }
+        }
+    }
+
+    void NPYExportAllTraces(const PositionalReader& reader, DatFile& datf, const std::string& path,
+        const std::string& prefix, unsigned num_threads, ExportDataType dtype, bool createManifest)
+    {
+        std::vector<hkTreeNode*> traces;
+        std::vector<std::string> filenames;
+        CollectTraces(datf, path, prefix, traces, filenames);
+        const bool createJSON = !createManifest;
+        // parameters of root, group, series and sweep are formatted once, not for every trace
+        MetadataBlockCache blocks(MetadataBlockCache::Format::JSON);
+        std::ofstream manifest_file;
+        if (createManifest) {
+            manifest_file = OpenManifest(path, prefix);
+        }
+        ManifestWriter manifest(manifest_file, dtype);
+        auto* cache = dtype != ExportDataType::Native ? &datf.GetTraceCache() : nullptr;
+        // each worker reads, converts and writes whole traces, every trace goes to its own file,
+        // the manifest is written in tree order on this thread
+        RunOrderedPipeline(traces.size(), num_threads,
+            [&](std::size_t i) {
+                if (auto data = cache ? cache->find(traces[i]) : nullptr) {
+                    NPYorBINExportTrace(*data, *traces[i], filenames[i], createJSON, dtype, &blocks);
+                }
+                else {
+                    TraceChunkReader chunks(reader, *traces[i]);
+                    NPYorBINExportTrace(chunks, *traces[i], filenames[i], createJSON, dtype, &blocks);
+                }
+                return true;
+            },
+            [&](std::size_t i, bool) {
+                if (createManifest) {
+                    manifest.addTrace(*traces[i], FileNameOnly(filenames[i]));
+                }
+            });
+        if (createManifest && !manifest_file) {
+            throw std::runtime_error{ "error while writing manifest file" };
+        }
+    }
+
 }
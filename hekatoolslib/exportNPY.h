@@ -24,10 +24,16 @@
 
 #include <istream>
 #include <filesystem>
+#include <span>
 #include <string_view>
 #include "DatFile.h"
 #include "hkTree.h"
 #include "hkTreeView.h"
+#include "TraceView.h"
+#include "TraceChunkReader.h"
+#include "SampleEncoder.h"
+#include "TraceCache.h"
+#include "MetadataBlockCache.h"
 
 namespace hkLib {
 
@@ -42,10 +48,46 @@ namespace hkLib {
 	/// <param name="TrRecord">hkTreeNode of the trace record</param>
 	/// <param name="filename">export filename</param>
 	/// <param name="createJSON">true if JSON metadata file should be created</param>
-	void NPYorBINExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON);
+	/// <param name="dtype">data type of exported samples; for Float32 and Native the JSON file contains
+	/// the entries dtype and scale_factor (physical value = scale_factor * sample)</param>
+	/// <param name="blocks">optional cache (format JSON) for the parameters of root, group, series and sweep,
+	/// so they are formatted only once when exporting many traces</param>
+	void NPYorBINExportTrace(std::istream& datafile, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+		ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
 
+	/// <summary>
+	/// Export trace data already loaded (e.g. by TraceBatchReader) as either npy or raw binary, see above.
+	/// </summary>
+	void NPYorBINExportTrace(const TraceView& trace, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+		ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
+
+	/// <summary>
+	/// Export trace read chunk-wise, i.e. in constant memory regardless of the length of the trace, see above.
+	/// </summary>
+	void NPYorBINExportTrace(TraceChunkReader& chunks, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+		ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
+
+	/// <summary>
+	/// Export converted trace data (e.g. from the trace cache) as either npy or raw binary, see above.
+	/// dtype Native is not supported (throws std::invalid_argument).
+	/// </summary>
+	void NPYorBINExportTrace(std::span<const double> tr_data, hkTreeNode& TrRecord, std::filesystem::path filename, bool createJSON,
+		ExportDataType dtype = ExportDataType::Float64, MetadataBlockCache* blocks = nullptr);
+
+	/// <summary>
+	/// Export one array per series and trace ID, containing the traces of all sweeps.
+	/// The sweeps are streamed into the file one by one, so memory use is bounded by one sweep.
+	/// Sweeps shorter than the longest one are padded with NaN, their lengths are then
+	/// listed in the JSON file (numpnts_sweeps).
+	/// </summary>
+	/// <param name="datafile">heka data stream</param>
+	/// <param name="tree">tree view selecting the series, sweeps and traces to export</param>
+	/// <param name="path">path in which exported files will be saved</param>
+	/// <param name="prefix">filename prefix</param>
+	/// <param name="createJSON">true if JSON metadata files should be created</param>
+	/// <param name="cache">optional trace cache to take already converted traces from</param>
 	void NPYExportTreeSweepsAsArray(std::istream& datafile, const hkTreeView& tree, const std::string_view& path,
-		const std::string_view& prefix, bool createJSON);
+		const std::string_view& prefix, bool createJSON, TraceCache* cache = nullptr);
 
 	
 	/// <summary>
@@ -56,7 +98,21 @@ namespace hkLib {
 	/// <param name="datf">datafile object</param>
 	/// <param name="path">path in which exporteed files will be saved</param>
 	/// <param name="prefix">tracename prefix (selected by user)</param>
-	void NPYExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix);
+	/// <param name="num_threads">number of threads, 0: one per core, 1: serial export;
+	/// the export is only parallel if datafile is memory mapped, the output is the same in any case</param>
+	/// <param name="dtype">data type of exported samples</param>
+	/// <param name="createManifest">if true, instead of one JSON file per trace a single manifest
+	/// (JSON Lines, see ManifestWriter) named &lt;prefix&gt;_manifest.jsonl is created</param>
+	void NPYExportAllTraces(std::istream& datafile, DatFile& datf, const std::string& path, const std::string& prefix,
+		unsigned num_threads = 0, ExportDataType dtype = ExportDataType::Float64, bool createManifest = false);
+
+	/// <summary>
+	/// Export all trace in NPY format, reading, converting and writing traces
+	/// on num_threads worker threads (0: one per core)
+	/// </summary>
+	void NPYExportAllTraces(const PositionalReader& reader, DatFile& datf, const std::string& path,
+		const std::string& prefix, unsigned num_threads = 0, ExportDataType dtype = ExportDataType::Float64,
+		bool createManifest = false);
 }
 
 #endif // !EXPORT_NPY_H
@@ -18,7 +18,7 @@
 */
 
 #include <cinttypes>
-#include <sstream>
+#include <string>
 #include <cassert>
 #include "hkTree.h"
 #include "DatFile.h"
@@ -123,29 +123,29 @@ namespace hkLib {
     std::string formTraceName(const hkTreeNode& tr, int count)
     {
         assert(tr.getLevel() == hkTreeNode::LevelTrace);
-        int datakind = tr.extractUInt16(TrDataKind);
-        std::stringstream trace_ext;
+        int datakind = tr.get(Trace::DataKind);
+        std::string trace_ext;
         if (datakind & IsImon && !global_hkSettings.ext_Imon.empty()) {
-            trace_ext << global_hkSettings.ext_Imon;
+            trace_ext = global_hkSettings.ext_Imon;
         }
         else if (datakind & IsVmon && !global_hkSettings.ext_Vmon.empty()) {
-            trace_ext << global_hkSettings.ext_Vmon;
+            trace_ext = global_hkSettings.ext_Vmon;
         }
         else {
-            auto lable =  tr.getString(TrLabel);
+            auto lable =  tr.get(Trace::Label);
             if (lable.empty()) {
                 if (datakind & IsLeak && !global_hkSettings.ext_Leak.empty()) {
-                    trace_ext << global_hkSettings.ext_Leak;
+                    trace_ext = global_hkSettings.ext_Leak;
                 }
                 else {
-                    trace_ext << "trace_" << count;
+                    trace_ext = "trace_" + std::to_string(count);
                 }
             }
             else {
-                trace_ext << hkLib::iso_8859_1_to_utf8(lable);
+                trace_ext = hkLib::iso_8859_1_to_utf8(lable);
             }
         }
-        return trace_ext.str();
+        return trace_ext;
     }
 
 }
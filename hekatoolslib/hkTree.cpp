@@ -22,9 +22,12 @@
 #include <cstddef>
 #include <cassert>
 #include <cstring>
+#include <utility>
 #include "DatFile.h"
 #include "hkTree.h"
 #include "helpers.h"
+#include "MappedFile.h"
+#include "PositionalReader.h"
 
 namespace hkLib {
 
@@ -32,29 +35,29 @@ namespace hkLib {
 		assert(tree->getID() == ExtPul);
 		switch (level) {
 		case LevelRoot:
-			tree->time0 = extractValue(RoStartTime, 0.0);
+			tree->time0 = get(Root::StartTime, 0.0);
 			break;
 		case LevelGroup:
 		// there is no time info in Group records
 			if (Children.empty())
 			{
 				// resort to root time
-				tree->time0 = Parent->extractValue(RoStartTime, 0.0);
+				tree->time0 = Parent->get(Root::StartTime, 0.0);
 			}
 			else
 			{
-				tree->time0 = Children.at(0).extractValue(SeTime, 0.0);
+				tree->time0 = Children.at(0).get(Series::Time, 0.0);
 			}
 			break;
 		case LevelSeries:
-			tree->time0 = extractValue(SeTime, 0.0);
+			tree->time0 = get(Series::Time, 0.0);
 			break;
 		case LevelSweep:
-			tree->time0 = extractValue(SwTime, 0.0);
+			tree->time0 = get(Sweep::Time, 0.0);
 			break;
 		case LevelTrace:
 			// resort to sweep time
-			tree->time0 = Parent->extractValue(SwTime, 0.0);
+			tree->time0 = Parent->get(Sweep::Time, 0.0);
 			break;
 		default:
 			throw std::runtime_error("unexpected tree level");
@@ -76,41 +79,230 @@ namespace hkLib {
 	};
     constexpr auto TreeRootHeaderSize = offsetof(TreeRoot,LevelSizes);
 
-	void hkLib::hkTree::LoadToNode(hkTreeNode* parent, hkTreeNode& node, char** pdata, char* data_end, int level)
+	void hkTree::LoadNodes(const char* data, const char* data_end)
 	{
-		node.tree = this;
-		auto size = static_cast<std::size_t>(LevelSizes.at(level));
-		node.level = level;
-		node.isSwapped = isSwapped;
-		node.Parent = parent;
-		node.Data = std::span(*pdata, size);
-		*pdata += size;
-		std::uint32_t nchildren;
-        if (*pdata + sizeof(std::uint32_t) > data_end) throw std::runtime_error("not enough data");
-		std::memcpy(&nchildren, *pdata, sizeof(std::uint32_t));
-		if (isSwapped) { swapInPlace(nchildren); }
-		*pdata += sizeof(std::uint32_t);
-		node.Children.resize(nchildren);
-		for (auto& child : node.Children) {
-			LoadToNode(&node, child, pdata, data_end, level + 1);
-		}
-	}
-
-	bool hkTree::InitFromStream(const std::string_view& id, std::istream& infile, int offset, unsigned int len)
+		const auto nlevels = LevelSizes.size();
+		auto readNumChildren = [&](const char* p) {
+			std::uint32_t nchildren;
+			if (p + sizeof(std::uint32_t) > data_end) throw std::runtime_error("not enough data");
+			std::memcpy(&nchildren, p, sizeof(std::uint32_t));
+			if (isSwapped) { swapInPlace(nchildren); }
+			return nchildren;
+		};
+		// The tree is stored depth-first, each record being followed by the number of its children.
+		// We walk it iteratively, keeping the number of siblings still to be read at each level on a stack.
+		// 1st pass: validate and count nodes per level
+		std::vector<std::size_t> counts(nlevels, 0);
+		std::vector<std::uint32_t> pending;
+		pending.reserve(nlevels + 1);
+		pending.push_back(1); // the root
+		const char* p = data;
+		while (!pending.empty()) {
+			if (pending.back() == 0) {
+				pending.pop_back();
+				continue;
+			}
+			--pending.back();
+			const auto level = pending.size() - 1;
+			if (level >= nlevels) throw std::runtime_error("tree has more levels than declared");
+			const auto size = static_cast<std::size_t>(LevelSizes[level]);
+			if (size > static_cast<std::size_t>(data_end - p)) throw std::runtime_error("not enough data");
+			p += size;
+			pending.push_back(readNumChildren(p));
+			p += sizeof(std::uint32_t);
+			++counts[level];
+		}
+		if (p != data_end) {
+			throw std::runtime_error("bytes read != bytes in buffer");
+		}
+
+		// 2nd pass: fill node arena, level by level. Since the children of each node
+		// are visited before any other node of their level, they end up adjacent.
+		LevelStart.assign(nlevels + 1, 0);
+		for (std::size_t l = 0; l < nlevels; ++l) {
+			LevelStart[l + 1] = LevelStart[l] + counts[l];
+		}
+		Nodes.clear();
+		Nodes.resize(LevelStart.back());
+		std::vector<std::size_t> next(LevelStart.begin(), LevelStart.end());
+		std::vector<hkTreeNode*> parents;
+		parents.reserve(nlevels + 1);
+		parents.push_back(nullptr);
+		pending.push_back(1);
+		p = data;
+		while (!pending.empty()) {
+			if (pending.back() == 0) {
+				pending.pop_back();
+				parents.pop_back();
+				continue;
+			}
+			--pending.back();
+			const auto level = pending.size() - 1;
+			const auto size = static_cast<std::size_t>(LevelSizes[level]);
+			auto& node = Nodes[next[level]++];
+			node.tree = this;
+			node.level = static_cast<int>(level);
+			node.isSwapped = isSwapped;
+			node.Parent = parents.back();
+			node.Data = std::span(p, size);
+			p += size;
+			const auto nchildren = readNumChildren(p);
+			p += sizeof(std::uint32_t);
+			node.Children = NodeRange<hkTreeNode>(Nodes.data() + next[level + 1], nchildren);
+			pending.push_back(nchildren);
+			parents.push_back(&node);
+		}
+	}
+
+	void hkTree::LoadNodes(const char* data, const char* data_end, std::span<const hkTreeNodeLayout> layout)
+	{
+		// Same node arena as above, but the structure is taken from the layout. Only the records
+		// are checked to lie within the tree data, so a layout not matching the data is detected
+		// when (most likely) the counts or offsets do not fit, but it cannot do any harm.
+		const auto nlevels = LevelSizes.size();
+		const auto first = static_cast<std::size_t>(data - TreeData), end = static_cast<std::size_t>(data_end - TreeData);
+		LevelStart.assign(nlevels + 1, 0);
+		std::size_t level_count = 1; // the root
+		for (std::size_t l = 0; l < nlevels; ++l) {
+			LevelStart[l + 1] = LevelStart[l] + level_count;
+			if (LevelStart[l + 1] > layout.size()) throw std::runtime_error("node layout does not match tree");
+			level_count = 0;
+			for (auto i = LevelStart[l]; i < LevelStart[l + 1]; ++i) {
+				level_count += layout[i].nchildren;
+			}
+		}
+		if (level_count != 0 || LevelStart.back() != layout.size()) {
+			throw std::runtime_error("node layout does not match tree");
+		}
+		Nodes.clear();
+		Nodes.resize(layout.size());
+		std::size_t next_child = 1;
+		for (std::size_t l = 0; l < nlevels; ++l) {
+			const auto size = static_cast<std::size_t>(LevelSizes[l]);
+			for (auto i = LevelStart[l]; i < LevelStart[l + 1]; ++i) {
+				// each record is followed by the number of its children
+				const std::size_t offset = layout[i].offset;
+				if (offset < first || offset > end || size + sizeof(std::uint32_t) > end - offset) {
+					throw std::runtime_error("node layout does not match tree");
+				}
+				auto* p = data + (offset - first);
+				auto& node = Nodes[i];
+				node.tree = this;
+				node.level = static_cast<int>(l);
+				node.isSwapped = isSwapped;
+				node.Data = std::span(p, size);
+				node.Children = NodeRange<hkTreeNode>(Nodes.data() + next_child, layout[i].nchildren);
+				for (auto& child : node.Children) {
+					child.Parent = &node;
+				}
+				next_child += layout[i].nchildren;
+			}
+		}
+	}
+
+	std::vector<hkTreeNodeLayout> hkTree::GetLayout() const
+	{
+		std::vector<hkTreeNodeLayout> layout;
+		layout.reserve(Nodes.size());
+		for (const auto& node : Nodes) {
+			layout.push_back({ static_cast<std::uint32_t>(node.Data.data() - TreeData),
+				static_cast<std::uint32_t>(node.Children.size()) });
+		}
+		return layout;
+	}
+
+	bool hkTree::ConvertToNativeByteOrder(std::span<const std::vector<hkRecordField>> fields)
+	{
+		if (!isSwapped || !isValid()) {
+			return false;
+		}
+		if (TreeData != Data.get()) {
+			// the tree data is not owned (e.g. it is part of a read-only memory mapping),
+			// convert a copy of it
+			auto copy = std::make_unique<char[]>(TreeSize);
+			std::memcpy(copy.get(), TreeData, TreeSize);
+			for (auto& node : Nodes) {
+				node.Data = std::span<const char>(copy.get() + (node.Data.data() - TreeData), node.Data.size());
+			}
+			Data = std::move(copy);
+			Mapping.reset();
+			TreeData = Data.get();
+		}
+		char* const tree = Data.get();
+		for (std::size_t l = 0; l < LevelSizes.size(); ++l) {
+			const auto level_fields = l < fields.size() ? std::span(fields[l]) : std::span<const hkRecordField>{};
+			for (auto& node : GetLevelNodes(static_cast<int>(l))) {
+				char* record = tree + (node.Data.data() - TreeData);
+				for (const auto& f : level_fields) {
+					if (std::size_t(f.offset) + f.size <= node.Data.size()) {
+						std::reverse(record + f.offset, record + f.offset + f.size);
+					}
+				}
+				// number of children, always present after the record
+				auto* nchildren = record + node.Data.size();
+				std::reverse(nchildren, nchildren + sizeof(std::uint32_t));
+				node.isSwapped = false;
+			}
+		}
+		const std::uint32_t root[2] = { MagicNumber, static_cast<std::uint32_t>(LevelSizes.size()) };
+		std::memcpy(tree, root, TreeRootHeaderSize);
+		std::memcpy(tree + TreeRootHeaderSize, LevelSizes.data(), LevelSizes.size() * sizeof(std::uint32_t));
+		isSwapped = false;
+		return true;
+	}
+
+	bool hkTree::InitFromStream(const std::string_view& id, std::istream& infile, std::uint64_t offset, std::uint64_t len,
+		std::span<const hkTreeNodeLayout> layout)
 	{
 		assert(!!infile);
-		if (offset < 0 || len == 0) throw std::runtime_error("invalid tree data offset or length");
-		Data = std::make_unique<char[]>(len);
-		infile.seekg(offset, std::ios::beg).read(Data.get(), len);
+		if (len == 0) throw std::runtime_error("invalid tree data offset or length");
+		if (const auto* mapped = getMappedFileBuf(infile)) {
+			// zero-copy: use data in memory mapping directly
+			auto filedata = mapped->getMapping()->span();
+			if (offset > filedata.size() || len > filedata.size() - offset) {
+				return false;
+			}
+			Mapping = mapped->getMapping();
+			Data.reset();
+			return this->InitFromBuffer(id, filedata.data() + offset, static_cast<std::size_t>(len), layout);
+		}
+		if (!std::in_range<std::size_t>(len) || !std::in_range<std::streamoff>(offset)) {
+			return false;
+		}
+		Mapping.reset();
+		Data = std::make_unique<char[]>(static_cast<std::size_t>(len));
+		infile.seekg(static_cast<std::streamoff>(offset), std::ios::beg).read(Data.get(), static_cast<std::streamsize>(len));
 		if (!infile) {
 			infile.clear();
 			return false;
 		}
-		bool res = this->InitFromBuffer(id, Data.get(), len);
+		bool res = this->InitFromBuffer(id, Data.get(), static_cast<std::size_t>(len), layout);
 		return res;
 	}
 
-	bool hkTree::InitFromBuffer(const std::string_view& id, char* buffer, std::size_t len)
+	bool hkTree::InitFromStream(const std::string_view& id, const PositionalReader& reader, std::uint64_t offset, std::uint64_t len,
+		std::span<const hkTreeNodeLayout> layout)
+	{
+		if (len == 0) throw std::runtime_error("invalid tree data offset or length");
+		if (offset > reader.size() || len > reader.size() - offset) {
+			return false;
+		}
+		// both fit into std::size_t now, as reader.size() does
+		const auto pos = static_cast<std::size_t>(offset), nbytes = static_cast<std::size_t>(len);
+		if (reader.getMapping()) {
+			// zero-copy: use data in memory mapping directly
+			Mapping = reader.getMapping();
+			Data.reset();
+			return this->InitFromBuffer(id, Mapping->data() + pos, nbytes, layout);
+		}
+		Mapping.reset();
+		Data = std::make_unique<char[]>(nbytes);
+		reader.read(pos, Data.get(), nbytes);
+		return this->InitFromBuffer(id, Data.get(), nbytes, layout);
+	}
+
+	bool hkTree::InitFromBuffer(const std::string_view& id, const char* buffer, std::size_t len,
+		std::span<const hkTreeNodeLayout> layout)
 	{
         if (len < TreeRootHeaderSize) throw std::runtime_error("invalid TreeRoot (too few bytes in file)");
 		ID = id;
@@ -133,18 +325,22 @@ namespace hkLib {
         if(isSwapped){
             for(auto& l : LevelSizes) swapInPlace(l);
         }
-        char* data = buffer + root_bytes; // start of first tree node
-		LoadToNode(nullptr, RootNode, &data, buffer + len, 0);
-		if (data - buffer != static_cast<std::ptrdiff_t>(len)) {
-			throw std::runtime_error("bytes read != bytes in buffer");
-		}
+        if (LevelSizes.empty()) throw std::runtime_error("invalid TreeRoot (no levels)");
+        TreeData = buffer;
+        TreeSize = len;
+        if (layout.empty()) {
+            LoadNodes(buffer + root_bytes, buffer + len); // start of first tree node
+        }
+        else {
+            LoadNodes(buffer + root_bytes, buffer + len, layout);
+        }
 		return true;
 	}
 
 	hkTreeNode& hkTree::GetRootNode() 
 	{ 
 		if(isValid()) {
-		return RootNode;
+		return Nodes.front();
 		} else {
 			throw std::runtime_error("trying to get root node from invalid hkTree");
 		}
@@ -152,7 +348,15 @@ namespace hkLib {
 
 	bool hkTree::isValid()
 	{
-		return LevelSizes.size()!=0 && !RootNode.Data.empty();
+		return LevelSizes.size()!=0 && !Nodes.empty() && !Nodes.front().Data.empty();
+	}
+
+	std::span<hkTreeNode> hkTree::GetLevelNodes(int level)
+	{
+		if (level < 0 || static_cast<std::size_t>(level) + 1 >= LevelStart.size()) {
+			return {};
+		}
+		return std::span(Nodes).subspan(LevelStart[level], LevelStart[level + 1] - LevelStart[level]);
 	}
 
 	char hkTreeNode::getChar(std::size_t offset) const
@@ -26,12 +26,16 @@
 #include <ostream>
 #include <vector>
 #include <array>
+#include <compare>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <algorithm>
+#include <cassert>
 #include <memory>
 #include <limits>
+#include <stdexcept>
 #include <type_traits>
 #include <cstring>
 #include <cstdint>
@@ -197,31 +201,124 @@ namespace hkLib {
     std::ostream& operator<<(std::ostream& os, const UserParamDescr&);
 
     class hkTree;
+    class MappedFile;
+    class PositionalReader;
+
+    /// <summary>
+    /// Position of a node record within the tree data and the number of its children.
+    /// A list of these, level by level in the order of hkTree::GetLevelNodes, describes
+    /// the structure of a tree (e.g. as stored in a DatIndex), so the tree can be set up without parsing it.
+    /// </summary>
+    struct hkTreeNodeLayout {
+        std::uint32_t offset; //!< offset of record from start of tree data
+        std::uint32_t nchildren;
+    };
+
+    /// <summary>
+    /// A numeric field of a record (offset and size in bytes), used to convert records to native byte order.
+    /// </summary>
+    struct hkRecordField {
+        std::uint32_t offset;
+        std::uint32_t size;
+        auto operator<=>(const hkRecordField&) const = default;
+    };
+
+    /// <summary>
+    /// Range of nodes stored contiguously in the node arena of a hkTree,
+    /// used for the children of a node. Behaves like a (non-owning) container.
+    /// </summary>
+    /// <typeparam name="Node">node type</typeparam>
+    template<typename Node> class NodeRange {
+        Node* first{ nullptr };
+        std::size_t count{ 0 };
+    public:
+        NodeRange() = default;
+        NodeRange(Node* p, std::size_t n) : first{ p }, count{ n } {};
+        Node* begin() const { return first; };
+        Node* end() const { return first + count; };
+        std::size_t size() const { return count; };
+        bool empty() const { return count == 0; };
+        Node& operator[](std::size_t i) const { return first[i]; };
+        Node& at(std::size_t i) const
+        {
+            if (i >= count) {
+                throw std::out_of_range("child index out of range");
+            }
+            return first[i];
+        }
+        Node& front() const { return at(0); };
+        Node& back() const { return at(count - 1); };
+    };
+
+    /// <summary>
+    /// Compile-time descriptor of a numeric field of a tree record: type, offset and level
+    /// of the record. Used with the typed accessors of hkTreeNode, e.g. node.get(Trace::DataScaler),
+    /// the descriptors of the known fields are defined in RecordFields.h.
+    /// </summary>
+    template<typename T, std::size_t Offset, int Level> struct hkField {
+        static_assert(std::is_arithmetic_v<T>, "must be arithmetic type");
+        using value_type = T;
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t end = Offset + sizeof(T); //!< record size needed to read the field
+        static constexpr int level = Level;
+    };
+
+    /// <summary>
+    /// Compile-time descriptor of a string field (char array of fixed size, usually zero terminated)
+    /// of a tree record, cf. hkField.
+    /// </summary>
+    template<std::size_t Size, std::size_t Offset, int Level> struct hkStringField {
+        using value_type = std::string_view;
+        static constexpr std::size_t size = Size;
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t end = Offset + Size;
+        static constexpr int level = Level;
+    };
 
     /// <summary>
     /// A node in the tree (pul., pgf, amp, etc. tree)
     /// </summary>
     struct hkTreeNode {
-    private:
+    public:
+        /// <summary>
+        /// extract a value from record data, swaps bytes if needed,
+        /// the caller must make sure that offset + sizeof(T) does not exceed the record size
+        /// </summary>
         template<typename T> T extractValueNoCheck(std::size_t offset) const noexcept
         {
             static_assert(std::is_arithmetic_v<T>, "must be arithmetic type");
             T t{};
             auto src = Data.data() + offset;
-            if (!isSwapped) {
-                std::copy(src, src + sizeof t, reinterpret_cast<char*>(&t));
+            if (!isSwapped) [[likely]] {
+                // plain unaligned load
+                std::memcpy(&t, src, sizeof t);
             }
             else {
                 std::reverse_copy(src, src + sizeof t, reinterpret_cast<char*>(&t));
             }
             return t;
         }
+    private:
         template<typename T> bool checkOffset(std::size_t offset) const noexcept
         {
             return (Data.size() >= offset + sizeof(T));
         }
+        template<typename T, std::size_t Offset, int Level> T getUnchecked(hkField<T, Offset, Level>) const noexcept
+        {
+            assert(level < 0 || level == Level);
+            return extractValueNoCheck<T>(Offset);
+        }
+        template<std::size_t Size, std::size_t Offset, int Level> std::string_view getUnchecked(
+            hkStringField<Size, Offset, Level>) const noexcept
+        {
+            assert(level < 0 || level == Level);
+            const auto* p = Data.data() + Offset;
+            // not necessarily zero terminated if the string fills the field
+            return std::string_view(p, std::find(p, p + Size, '\0') - p);
+        }
     public:
         hkTreeNode() : Parent{ nullptr }, Data{ }, Children{}, level{ -1 }, isSwapped{ false } {};
+        hkTreeNode& operator=(hkTreeNode&&) = default;
         hkTreeNode(hkTreeNode&&) = default;
         hkTreeNode(const hkTreeNode&) = delete;
         hkTreeNode& operator=(const hkTreeNode&) = delete;
@@ -272,6 +369,49 @@ namespace hkLib {
             }
             return extractValueNoCheck<T>(offset);
         }
+        /// <summary>
+        /// typed access to a field (see hkField and hkStringField),
+        /// throws std::out_of_range if the record is too small to contain it
+        /// </summary>
+        template<typename Field> typename Field::value_type get(Field) const
+        {
+            if (Data.size() < Field::end) {
+                throw std::out_of_range("offset too large while accessing tree node");
+            }
+            return getUnchecked(Field{});
+        }
+
+        /// <summary>
+        /// typed access to a field, returns defaultValue if the record is too small to contain it
+        /// </summary>
+        template<typename Field> typename Field::value_type get(Field, typename Field::value_type defaultValue) const noexcept
+        {
+            return Data.size() < Field::end ? defaultValue : getUnchecked(Field{});
+        }
+
+        /// <summary>
+        /// Read several fields at once, the record size is checked only once,
+        /// e.g. auto [points, scaler] = node.getFields(Trace::DataPoints, Trace::DataScaler);
+        /// throws std::out_of_range if the record is too small to contain all of them
+        /// </summary>
+        /// <returns>tuple of the values</returns>
+        template<typename... Fields> std::tuple<typename Fields::value_type...> getFields(Fields...) const
+        {
+            static_assert(sizeof...(Fields) > 0, "no fields given");
+            if (Data.size() < std::max({ Fields::end... })) {
+                throw std::out_of_range("offset too large while accessing tree node");
+            }
+            return { getUnchecked(Fields{})... };
+        }
+
+        /// <summary>
+        /// check if the record is large enough to contain all given fields
+        /// </summary>
+        template<typename... Fields> bool hasFields(Fields...) const noexcept
+        {
+            return Data.size() >= std::max({ Fields::end... });
+        }
+
         enum TreeLevel {
             LevelRoot = 0,
             LevelGroup = 1, // for pul tree
@@ -324,8 +464,8 @@ namespace hkLib {
 
     public:
         hkTreeNode* Parent;
-        std::span<char> Data;
-        std::vector<hkTreeNode> Children;
+        std::span<const char> Data; //!< record data, within the tree data
+        NodeRange<hkTreeNode> Children; //!< children are stored contiguously in the node arena of the tree
         int level;
         bool isSwapped;
 
@@ -335,27 +475,52 @@ namespace hkLib {
     class hkTree
     {
         std::vector<int32_t> LevelSizes;
-        hkTreeNode RootNode;
+        std::vector<hkTreeNode> Nodes; //!< all nodes of the tree, stored level by level
+        std::vector<std::size_t> LevelStart; //!< index of first node of each level in Nodes, plus end index
         std::string ID;
         std::unique_ptr<char[]> Data{};
+        std::shared_ptr<MappedFile> Mapping{}; //!< keeps memory mapping alive if tree data points into it
+        const char* TreeData{}; //!< start of tree data (i.e. of TreeRoot)
+        std::size_t TreeSize{}; //!< size of tree data in bytes
         double time0{};
         bool isSwapped;
-        void LoadToNode(hkTreeNode* parent, hkTreeNode& node, char** pdata, char* data_end, int level);
+        void LoadNodes(const char* data, const char* data_end);
+        void LoadNodes(const char* data, const char* data_end, std::span<const hkTreeNodeLayout> layout);
     public:
-        hkTree() : LevelSizes{}, RootNode{}, isSwapped{ false } {};
+        hkTree() : LevelSizes{}, Nodes{}, LevelStart{}, isSwapped{ false } {};
+        hkTree(const hkTree&) = delete;
+        hkTree& operator=(const hkTree&) = delete;
         std::string getID() {
             return ID;
         };
 
         /// <summary>
-        /// Initialize tree from istream
+        /// Initialize tree from istream.
+        /// If infile is a MappedFileStream, the tree will point directly into the
+        /// memory mapping instead of copying the data.
         /// </summary>
         /// <param name="id">id (pgf, pul, ...) of tree</param>
         /// <param name="infile">input stream (usually a filestream)</param>
         /// <param name="offset">offset of start of tree in infile stream</param>
         /// <param name="len">length in bytes of tree data in file (this data contains the total of the tree)</param>
+        /// <param name="layout">optional node layout (see GetLayout), if given the tree is not parsed,
+        /// but the layout is checked against the tree data, throws std::runtime_error if it does not fit</param>
+        /// <returns>true on success</returns>
+        bool InitFromStream(const std::string_view& id, std::istream& infile, std::uint64_t offset, std::uint64_t len,
+            std::span<const hkTreeNodeLayout> layout = {});
+
+        /// <summary>
+        /// Initialize tree using a positional reader, does not touch any stream position.
+        /// If the reader operates on a memory mapping, the tree will point directly into it.
+        /// </summary>
+        /// <param name="id">id (pgf, pul, ...) of tree</param>
+        /// <param name="reader">reader of the file containing the tree</param>
+        /// <param name="offset">file offset of start of tree</param>
+        /// <param name="len">length in bytes of tree data in file (this data contains the total of the tree)</param>
+        /// <param name="layout">optional node layout, see above</param>
         /// <returns>true on success</returns>
-        bool InitFromStream(const std::string_view& id, std::istream& infile, int offset, unsigned int len);
+        bool InitFromStream(const std::string_view& id, const PositionalReader& reader, std::uint64_t offset, std::uint64_t len,
+            std::span<const hkTreeNodeLayout> layout = {});
 
         /// <summary>
         /// Initialize tree from data buffered in memory
@@ -363,10 +528,39 @@ namespace hkLib {
         /// <param name="id">id (pgf, pul, ...) of tree</param>
         /// <param name="buffer">pointer to data stored in memory, must be permanent for lifetime of hkTree</param>
         /// <param name="len">length in bytes of buffer (buffer contains the total of the tree)</param>
+        /// <param name="layout">optional node layout, see InitFromStream</param>
         /// <returns>true on success</returns>
-        bool InitFromBuffer(const std::string_view& id, char* buffer, std::size_t len);
+        bool InitFromBuffer(const std::string_view& id, const char* buffer, std::size_t len,
+            std::span<const hkTreeNodeLayout> layout = {});
+
+        /// <summary>
+        /// node layout of the tree, level by level, can be passed to InitFromStream
+        /// to set up the same tree again without parsing it
+        /// </summary>
+        std::vector<hkTreeNodeLayout> GetLayout() const;
+
+        /// <summary>
+        /// Convert the tree data in place to native byte order: the given numeric fields of all records,
+        /// the number of children stored after each record, and the tree root header.
+        /// Afterwards neither the tree nor its nodes are marked as swapped, so accessors do not need to
+        /// swap bytes anymore. Fields not listed stay in file byte order and can no longer be read as numbers.
+        /// Tree data not owned by the tree (e.g. in a read-only memory mapping) is copied first.
+        /// </summary>
+        /// <param name="fields">fields[level] lists the numeric fields of the records of that level,
+        /// fields must not overlap, fields exceeding the record size are skipped</param>
+        /// <returns>true if the tree has been converted, false if it was in native byte order already</returns>
+        bool ConvertToNativeByteOrder(std::span<const std::vector<hkRecordField>> fields);
         hkTreeNode& GetRootNode();
         std::size_t GetNumLevels() { return LevelSizes.size(); };    //!< return number of levels this tree has
+
+        /// <summary>
+        /// Get all nodes of a level. Nodes are ordered as they appear in the tree, i.e.
+        /// the children of each node are adjacent, and in the order of their parents.
+        /// Allows for linear scans, e.g. over all traces, without walking the tree.
+        /// </summary>
+        /// <param name="level">tree level</param>
+        /// <returns>span of nodes, empty if level does not exist</returns>
+        std::span<hkTreeNode> GetLevelNodes(int level);
         bool getIsSwapped() const { return isSwapped; };
         bool isValid();
         friend hkTreeNode;
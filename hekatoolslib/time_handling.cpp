@@ -54,7 +54,13 @@ namespace hkLib {
     {
         auto unixtime = PMtime2time_t(t);
         char buffer[BUFF_SIZE]{};
-        auto mtm = gmtime(&unixtime);
+        // reentrant versions of gmtime, since metadata may be formatted by several threads at once
+        std::tm tm_buf{};
+#ifdef _WIN32
+        auto mtm = gmtime_s(&tm_buf, &unixtime) == 0 ? &tm_buf : nullptr;
+#else
+        auto mtm = gmtime_r(&unixtime, &tm_buf);
+#endif
         if (mtm) {
             auto count = std::strftime(buffer, BUFF_SIZE, fmt_str, mtm);
             assert(count != 0);
@@ -0,0 +1,159 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// size classes, exact allocation, budget and statistics of BufferPool
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "BufferPool.h"
+
+using namespace hkLib;
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { ++failures; std::cerr << "check failed: " #cond " (line " << __LINE__ << ")\n"; } } while (0)
+
+    constexpr std::size_t K = 4096; // a power of two above MinPooledSize
+
+    void testExactSize()
+    {
+        BufferPool pool;
+        auto buf = pool.acquire(K + 1);
+        CHECK(buf.size() == K + 1);
+        CHECK(buf.capacity() == K + 1); // not rounded up to 2 K
+        CHECK(pool.getStats().misses == 1 && pool.getStats().hits == 0);
+        pool.release(std::move(buf));
+        CHECK(buf.empty());
+        CHECK(pool.getStats().buffers == 1 && pool.getStats().bytes == (K + 1) * sizeof(double));
+    }
+
+    void testSizeClasses()
+    {
+        BufferPool pool;
+        pool.release(pool.acquire(K + 100));
+        // same class, but too small: a new buffer is allocated
+        auto larger = pool.acquire(K + 200);
+        CHECK(larger.capacity() == K + 200);
+        CHECK(pool.getStats().hits == 0 && pool.getStats().buffers == 1);
+        // same class, large enough
+        auto smaller = pool.acquire(K + 50);
+        CHECK(smaller.size() == K + 50 && smaller.capacity() == K + 100);
+        CHECK(pool.getStats().hits == 1 && pool.getStats().buffers == 0 && pool.getStats().bytes == 0);
+        pool.release(std::move(smaller));
+        pool.release(std::move(larger));
+
+        // a buffer of the next class serves any request of this class
+        pool.clear();
+        pool.release(pool.acquire(2 * K + 1));
+        auto from_next = pool.acquire(2 * K - 1);
+        CHECK(from_next.capacity() == 2 * K + 1);
+        pool.release(std::move(from_next));
+        // but buffers two classes up are not used
+        auto too_large = pool.acquire(K / 2 + 1);
+        CHECK(too_large.capacity() == K / 2 + 1);
+        CHECK(pool.getStats().buffers == 1);
+
+        // small buffers are not pooled
+        pool.clear();
+        pool.release(pool.acquire(BufferPool::MinPooledSize - 1));
+        CHECK(pool.getStats().buffers == 0);
+    }
+
+    void testReuseKeepsData()
+    {
+        // a reused buffer is not cleared, so converting into it needs no zero-fill
+        BufferPool pool;
+        auto buf = pool.acquire(K);
+        for (std::size_t i = 0; i < K; ++i) buf[i] = double(i);
+        const auto* p = buf.data();
+        pool.release(std::move(buf));
+        auto again = pool.acquire(K - 10);
+        CHECK(again.data() == p && again.size() == K - 10);
+        CHECK(again[K - 11] == double(K - 11));
+    }
+
+    void testBudget()
+    {
+        BufferPool pool(3 * K * sizeof(double));
+        std::vector<BufferPool::Buffer> bufs;
+        for (int i = 0; i < 4; ++i) bufs.push_back(pool.acquire(K));
+        for (auto& b : bufs) pool.release(std::move(b));
+        // the fourth buffer exceeds the budget and is freed
+        CHECK(pool.getStats().buffers == 3 && pool.getStats().bytes == 3 * K * sizeof(double));
+        pool.setBudget(K * sizeof(double));
+        CHECK(pool.getStats().buffers == 1 && pool.getStats().bytes == K * sizeof(double));
+        CHECK(pool.getStats().budget == K * sizeof(double));
+        pool.clear();
+        CHECK(pool.getStats().buffers == 0 && pool.getStats().bytes == 0);
+    }
+
+    void testShare()
+    {
+        BufferPool pool;
+        {
+            auto shared = pool.share(pool.acquire(K));
+            auto copy = shared;
+            CHECK(pool.getStats().buffers == 0);
+        }
+        CHECK(pool.getStats().buffers == 1);
+    }
+
+    void testConcurrentUse()
+    {
+        BufferPool pool;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&pool, t] {
+                for (std::size_t i = 0; i < 200; ++i) {
+                    auto buf = pool.acquire(K + (i * 37 + t) % K);
+                    buf.back() = 1.0;
+                    pool.release(std::move(buf));
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        const auto stats = pool.getStats();
+        CHECK(stats.hits + stats.misses == 800);
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < stats.buffers; ++i) {
+            bytes += pool.acquire(K).capacity() * sizeof(double); // all buffers are in class K
+        }
+        CHECK(bytes == stats.bytes);
+    }
+}
+
+int main()
+{
+    testExactSize();
+    testSizeClasses();
+    testReuseKeepsData();
+    testBudget();
+    testShare();
+    testConcurrentUse();
+    if (failures) {
+        std::cerr << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
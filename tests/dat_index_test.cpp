@@ -0,0 +1,344 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Sidecar index (DatIndex) of a small synthetic bundle file: creating it in the background
+// (DatFile::CreateIndex), Save and Load with a matching stamp, and rejection of the index
+// after the size, modification time or bundle header of the data file has changed,
+// or if the index file is truncated.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <vector>
+#include "DatFile.h"
+#include "DatIndex.h"
+#include "machineinfo.h"
+#include "PositionalReader.h"
+#include "RecordFields.h"
+
+using namespace hkLib;
+namespace fs = std::filesystem;
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { ++failures; std::cerr << "check failed: " #cond " (line " << __LINE__ << ")\n"; } } while (0)
+
+    constexpr std::size_t NTraces = 4, NPoints = 100;
+    constexpr double Scaler = 0.5;
+
+    // trace k holds the samples 10 k, 10 k + 1, ...
+    std::int16_t sample(std::size_t trace, std::size_t i)
+    {
+        return static_cast<std::int16_t>(10 * trace + i);
+    }
+
+    template<typename T> void put(std::vector<char>& buf, T value)
+    {
+        const auto pos = buf.size();
+        buf.resize(pos + sizeof(T));
+        std::memcpy(buf.data() + pos, &value, sizeof(T));
+    }
+
+    template<typename Field> void set(std::vector<char>& record, Field, typename Field::value_type value)
+    {
+        std::memcpy(record.data() + Field::offset, &value, sizeof(value));
+    }
+
+    void addNode(std::vector<char>& tree, const std::vector<char>& record, std::uint32_t nchildren)
+    {
+        tree.insert(tree.end(), record.begin(), record.end());
+        put(tree, nchildren);
+    }
+
+    std::vector<char> treeHeader(const std::vector<std::uint32_t>& sizes)
+    {
+        std::vector<char> tree;
+        put(tree, std::uint32_t(0x54726565)); // "Tree"
+        put(tree, static_cast<std::uint32_t>(sizes.size()));
+        for (auto size : sizes) {
+            put(tree, size);
+        }
+        return tree;
+    }
+
+    // pulse tree with one group and series, two sweeps of two traces each (in native byte order)
+    void createFile(const fs::path& path)
+    {
+        constexpr std::uint32_t DataStart = BundleHeaderSize;
+        std::vector<char> data;
+        for (std::size_t k = 0; k < NTraces; ++k) {
+            for (std::size_t i = 0; i < NPoints; ++i) {
+                put(data, sample(k, i));
+            }
+        }
+
+        const std::vector<std::uint32_t> sizes{ 544, 128, 1728, 352, 512 };
+        auto pul = treeHeader(sizes);
+        addNode(pul, std::vector<char>(sizes[0]), 1);
+        addNode(pul, std::vector<char>(sizes[1]), 1);
+        addNode(pul, std::vector<char>(sizes[2]), 2);
+        for (std::size_t sweep = 0; sweep < 2; ++sweep) {
+            addNode(pul, std::vector<char>(sizes[3]), 2);
+            for (std::size_t tr = 0; tr < 2; ++tr) {
+                const auto k = 2 * sweep + tr;
+                std::vector<char> record(sizes[4]);
+                set(record, Trace::Data, static_cast<std::uint32_t>(DataStart + k * NPoints * sizeof(std::int16_t)));
+                set(record, Trace::DataPoints, static_cast<std::uint32_t>(NPoints));
+                set(record, Trace::DataKind, static_cast<std::uint16_t>(MachineIsLittleEndian() ? LittleEndianBit : 0));
+                set(record, Trace::DataFormat, char(DFT_int16));
+                set(record, Trace::DataScaler, Scaler);
+                set(record, Trace::XInterval, 1e-4);
+                addNode(pul, record, 0);
+            }
+        }
+        auto pgf = treeHeader({ 512, 248, 400, 88 });
+        addNode(pgf, std::vector<char>(512), 0);
+
+        BundleHeader header{};
+        std::memcpy(header.Signature, BundleSignature, sizeof header.Signature);
+        std::strcpy(header.Version, "v2x90");
+        header.Time = 1.5e9;
+        header.Items = 3;
+        header.IsLittleEndian = MachineIsLittleEndian();
+        std::uint32_t start = DataStart;
+        int item = 0;
+        for (auto [ext, content] : { std::pair{ ExtDat, &data }, std::pair{ ExtPul, &pul }, std::pair{ ExtPgf, &pgf } }) {
+            header.BundleItems[item].Start = start;
+            header.BundleItems[item].Length = static_cast<std::uint32_t>(content->size());
+            std::strcpy(header.BundleItems[item].Extension, ext);
+            start += static_cast<std::uint32_t>(content->size());
+            ++item;
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), BundleHeaderSize);
+        for (const auto* content : { &data, &pul, &pgf }) {
+            out.write(content->data(), content->size());
+        }
+        if (!out) {
+            throw std::runtime_error("cannot write test file");
+        }
+    }
+
+    DatIndex::FileStamp stampOf(const fs::path& path)
+    {
+        std::vector<char> header(BundleHeaderSize);
+        std::ifstream infile(path, std::ios::binary);
+        infile.read(header.data(), BundleHeaderSize);
+        DatIndex::FileStamp stamp;
+        if (!infile || !DatIndex::GetStamp(path, header, stamp)) {
+            throw std::runtime_error("cannot determine stamp of test file");
+        }
+        return stamp;
+    }
+
+    // initialize with IndexMode::Use, returns true if the index has been used
+    bool openWithIndex(DatFile& datfile, const fs::path& path)
+    {
+        std::ifstream infile(path, std::ios::binary);
+        return datfile.InitFromStream(infile, path, IndexMode::Use);
+    }
+
+    void checkStats(DatFile& datfile)
+    {
+        const auto traces = datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace);
+        CHECK(traces.size() == NTraces);
+        for (std::size_t k = 0; k < traces.size(); ++k) {
+            const auto* stats = datfile.GetTraceStats(traces[k]);
+            CHECK(stats != nullptr);
+            if (stats) {
+                CHECK(stats->min == Scaler * sample(k, 0));
+                CHECK(stats->max == Scaler * sample(k, NPoints - 1));
+                CHECK(stats->mean == Scaler * (sample(k, 0) + sample(k, NPoints - 1)) / 2.0);
+            }
+        }
+    }
+
+    void testCreateInBackground(const fs::path& path)
+    {
+        const auto indexpath = DatIndex::PathFor(path);
+        DatFile datfile;
+        CHECK(!openWithIndex(datfile, path));
+        CHECK(datfile.canCreateIndex());
+        CHECK(datfile.GetTraceStats(datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace)[0]) == nullptr);
+        PositionalReader reader(path);
+        // stopped before it is done, e.g. because the file is closed
+        std::stop_source stop;
+        stop.request_stop();
+        CHECK(!datfile.CreateIndex(reader, stop.get_token()));
+        CHECK(!fs::exists(indexpath));
+        CHECK(datfile.CreateIndex(reader));
+        CHECK(fs::exists(indexpath));
+
+        DatFile indexed;
+        CHECK(openWithIndex(indexed, path));
+        CHECK(!indexed.canCreateIndex());
+        CHECK(!indexed.CreateIndex(reader));
+        checkStats(indexed);
+
+        // without path, no index can be created
+        DatFile plain;
+        std::ifstream infile(path, std::ios::binary);
+        plain.InitFromStream(infile);
+        CHECK(!plain.canCreateIndex());
+    }
+
+    void testSaveAndLoad(const fs::path& path)
+    {
+        const auto indexpath = DatIndex::PathFor(path);
+        const auto stamp = stampOf(path);
+        auto index = DatIndex::Load(indexpath, stamp);
+        CHECK(index.has_value());
+        if (!index) {
+            return;
+        }
+        CHECK(index->getTraces().size() == NTraces);
+        CHECK(index->getLayout(ExtPul).size() == 1 + 1 + 1 + 2 + NTraces);
+        CHECK(index->getLayout(ExtAmp).empty());
+
+        // saved again, it reads the same
+        auto copypath = indexpath;
+        copypath += ".copy";
+        index->Save(copypath);
+        CHECK(!fs::exists(copypath.string() + ".tmp"));
+        const auto copy = DatIndex::Load(copypath, stamp);
+        CHECK(copy.has_value());
+        if (copy) {
+            CHECK(copy->getTraces().size() == index->getTraces().size());
+            for (std::size_t k = 0; k < copy->getTraces().size() && k < index->getTraces().size(); ++k) {
+                const auto& a = index->getTraces()[k];
+                const auto& b = copy->getTraces()[k];
+                CHECK(a.data_offset == b.data_offset && a.points == b.points && a.format == b.format
+                    && a.scaler == b.scaler && a.stats.min == b.stats.min && a.stats.max == b.stats.max
+                    && a.stats.mean == b.stats.mean);
+            }
+            const auto la = index->getLayout(ExtPul), lb = copy->getLayout(ExtPul);
+            CHECK(la.size() == lb.size());
+            for (std::size_t i = 0; i < la.size() && i < lb.size(); ++i) {
+                CHECK(la[i].offset == lb[i].offset && la[i].nchildren == lb[i].nchildren);
+            }
+        }
+
+        // another state of the data file
+        auto other = stamp;
+        other.size += 1;
+        CHECK(!DatIndex::Load(copypath, other));
+        other = stamp;
+        other.mtime += 1;
+        CHECK(!DatIndex::Load(copypath, other));
+        other = stamp;
+        other.header_hash ^= 1;
+        CHECK(!DatIndex::Load(copypath, other));
+
+        // truncated index files
+        const auto size = fs::file_size(copypath);
+        for (auto cut : { std::uintmax_t(1), std::uintmax_t(9), size / 2, size - 4 }) {
+            fs::resize_file(copypath, size - cut);
+            CHECK(!DatIndex::Load(copypath, stamp));
+        }
+        fs::remove(copypath);
+        CHECK(!DatIndex::Load(copypath, stamp));
+    }
+
+    // changes of the data file make DatFile ignore the index
+    void testOutdated(const fs::path& path)
+    {
+        DatFile datfile;
+        CHECK(openWithIndex(datfile, path));
+
+        // modification time
+        const auto mtime = fs::last_write_time(path);
+        fs::last_write_time(path, mtime + std::chrono::seconds(2));
+        CHECK(!openWithIndex(datfile, path));
+        CHECK(datfile.canCreateIndex());
+        fs::last_write_time(path, mtime);
+        CHECK(openWithIndex(datfile, path));
+
+        // bundle header, same size and time
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(offsetof(BundleHeader, Version));
+            file.write("v2x91", 5);
+        }
+        fs::last_write_time(path, mtime);
+        CHECK(!openWithIndex(datfile, path));
+
+        // size
+        createFile(path);
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::app);
+            file.put('\0');
+        }
+        fs::last_write_time(path, mtime);
+        CHECK(!openWithIndex(datfile, path));
+
+        // truncated index
+        createFile(path);
+        fs::last_write_time(path, mtime);
+        CHECK(openWithIndex(datfile, path));
+        const auto indexpath = DatIndex::PathFor(path);
+        fs::resize_file(indexpath, fs::file_size(indexpath) - 1);
+        CHECK(!openWithIndex(datfile, path));
+        CHECK(datfile.GetTraceStats(datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace)[0]) == nullptr);
+
+        // UseOrCreate replaces the invalid index right away
+        {
+            std::ifstream infile(path, std::ios::binary);
+            CHECK(!datfile.InitFromStream(infile, path, IndexMode::UseOrCreate));
+            CHECK(!datfile.canCreateIndex());
+        }
+        CHECK(openWithIndex(datfile, path));
+        checkStats(datfile);
+    }
+}
+
+int main()
+{
+    const auto path = fs::temp_directory_path() / "pmbrowser_dat_index_test.dat";
+    const auto indexpath = DatIndex::PathFor(path);
+    std::error_code ec;
+    try {
+        fs::remove(indexpath, ec);
+        createFile(path);
+        testCreateInBackground(path);
+        testSaveAndLoad(path);
+        testOutdated(path);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "unexpected exception: " << e.what() << '\n';
+        ++failures;
+    }
+    fs::remove(path, ec);
+    fs::remove(indexpath, ec);
+    if (failures) {
+        std::cerr << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Reads a synthetic bundle file larger than 4 GB (created as a sparse file), with the pulse tree
+// and trace data beyond 2 GB and traces whose data extend beyond 4 GB, through a memory mapped stream,
+// a plain std::ifstream and a PositionalReader. Then the file is truncated to check that trace data
+// and trees outside of the file are rejected.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "DatFile.h"
+#include "MappedFile.h"
+#include "PositionalReader.h"
+#include "RecordFields.h"
+#include "TraceBatchReader.h"
+#include "TraceView.h"
+
+using namespace hkLib;
+namespace fs = std::filesystem;
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { ++failures; std::cerr << "check failed: " #cond " (line " << __LINE__ << ")\n"; } } while (0)
+
+    constexpr std::uint64_t GiB = std::uint64_t(1) << 30;
+    constexpr std::uint64_t PulOffset = 3 * GiB; // beyond the signed 32-bit limit
+    constexpr std::uint64_t FileSize = 4 * GiB + (std::uint64_t(1) << 20);
+
+    struct TraceSpec {
+        std::uint32_t offset;
+        std::uint32_t npoints;
+        char format;
+        std::int32_t interleave_size, interleave_skip;
+        int sweep;
+    };
+
+    // contiguous int16 data beyond 2 GB, two interleaved int16 channels crossing the 4 GB boundary
+    // and a double trace just below them
+    const std::vector<TraceSpec> Traces{
+        { 0x80000010u, 1000, DFT_int16, 0, 0, 0 },
+        { 0xFFFF8000u, 10000, DFT_int16, 128, 256, 1 },
+        { 0xFFFF8080u, 10000, DFT_int16, 128, 256, 1 },
+        { 0xFFFF7C00u, 100, DFT_double, 0, 0, 2 },
+    };
+    constexpr int NumSweeps = 3;
+    constexpr double Scaler = 1e-3;
+
+    double rawValue(std::size_t trace, std::size_t k)
+    {
+        return double(std::int64_t((k * 7 + trace * 13) % 3000) - 1500);
+    }
+
+    double expectedValue(std::size_t trace, std::size_t k)
+    {
+        return Traces[trace].format == DFT_double ? rawValue(trace, k) : rawValue(trace, k) * Scaler;
+    }
+
+    // trees are written in machine byte order, depth first, each record followed by its number of children
+    class TreeWriter {
+    public:
+        explicit TreeWriter(std::vector<std::uint32_t> levelsizes) : sizes{ std::move(levelsizes) }
+        {
+            append(MagicNumber);
+            append(static_cast<std::uint32_t>(sizes.size()));
+            for (auto s : sizes) append(s);
+        }
+        std::vector<char> record(int level) const { return std::vector<char>(sizes.at(level)); }
+        void add(const std::vector<char>& rec, std::uint32_t nchildren)
+        {
+            data.insert(data.end(), rec.begin(), rec.end());
+            append(nchildren);
+        }
+        const std::vector<char>& bytes() const { return data; }
+
+    private:
+        template<typename T> void append(T v)
+        {
+            const auto* p = reinterpret_cast<const char*>(&v);
+            data.insert(data.end(), p, p + sizeof(T));
+        }
+        std::vector<std::uint32_t> sizes;
+        std::vector<char> data;
+    };
+
+    template<typename T> void put(std::vector<char>& rec, std::size_t offset, T v)
+    {
+        std::memcpy(rec.data() + offset, &v, sizeof(T));
+    }
+
+    void writeAt(std::fstream& f, std::uint64_t offset, std::span<const char> bytes)
+    {
+        f.seekp(static_cast<std::streamoff>(offset)).write(bytes.data(), bytes.size());
+    }
+
+    void createFile(const fs::path& path)
+    {
+        TreeWriter pul({ 544, 128, 1728, 352, 512 });
+        pul.add(pul.record(hkTreeNode::LevelRoot), 1);
+        pul.add(pul.record(hkTreeNode::LevelGroup), 1);
+        pul.add(pul.record(hkTreeNode::LevelSeries), NumSweeps);
+        for (int sweep = 0; sweep < NumSweeps; ++sweep) {
+            std::uint32_t ntraces = 0;
+            for (const auto& t : Traces) ntraces += t.sweep == sweep;
+            pul.add(pul.record(hkTreeNode::LevelSweep), ntraces);
+            for (std::size_t i = 0; i < Traces.size(); ++i) {
+                const auto& t = Traces[i];
+                if (t.sweep != sweep) continue;
+                auto rec = pul.record(hkTreeNode::LevelTrace);
+                put<std::int32_t>(rec, TrTraceID, static_cast<std::int32_t>(i + 1));
+                put<std::uint32_t>(rec, TrData, t.offset);
+                put<std::uint32_t>(rec, TrDataPoints, t.npoints);
+                put<std::uint16_t>(rec, TrDataKind, MachineIsLittleEndian() ? LittleEndianBit : 0);
+                put<char>(rec, TrDataFormat, t.format);
+                put<double>(rec, TrDataScaler, t.format == DFT_double ? 1.0 : Scaler);
+                put<double>(rec, TrXInterval, 1e-4);
+                put<std::int32_t>(rec, TrInterleaveSize, t.interleave_size);
+                put<std::int32_t>(rec, TrInterleaveSkip, t.interleave_skip);
+                pul.add(rec, 0);
+            }
+        }
+        TreeWriter pgf({ 512, 248, 400, 88 });
+        pgf.add(pgf.record(hkTreeNode::LevelRoot), 0);
+
+        BundleHeader bh{};
+        std::memcpy(bh.Signature, BundleSignature, sizeof(bh.Signature));
+        bh.Items = 3;
+        bh.IsLittleEndian = MachineIsLittleEndian();
+        const auto pgfoffset = static_cast<std::uint32_t>(BundleHeaderSize);
+        bh.BundleItems[0] = { pgfoffset, static_cast<std::uint32_t>(pgf.bytes().size()), ".pgf" };
+        bh.BundleItems[1] = { static_cast<std::uint32_t>(PulOffset), static_cast<std::uint32_t>(pul.bytes().size()), ".pul" };
+        bh.BundleItems[2] = { 0x80000000u, 0x7FFFFFFFu, ".dat" };
+
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        writeAt(f, 0, std::span(reinterpret_cast<const char*>(&bh), BundleHeaderSize));
+        writeAt(f, pgfoffset, pgf.bytes());
+        writeAt(f, PulOffset, pul.bytes());
+        for (std::size_t i = 0; i < Traces.size(); ++i) {
+            const auto& t = Traces[i];
+            const std::size_t samplesize = TraceView::sampleSizeOf(t.format);
+            std::vector<char> raw(t.npoints * samplesize);
+            for (std::size_t k = 0; k < t.npoints; ++k) {
+                if (t.format == DFT_double) {
+                    const double v = rawValue(i, k);
+                    std::memcpy(raw.data() + k * samplesize, &v, samplesize);
+                }
+                else {
+                    const auto v = static_cast<std::int16_t>(rawValue(i, k));
+                    std::memcpy(raw.data() + k * samplesize, &v, samplesize);
+                }
+            }
+            const std::size_t blocksize = t.interleave_size ? t.interleave_size : raw.size(),
+                blockskip = t.interleave_size ? t.interleave_skip : raw.size();
+            for (std::size_t b = 0; b * blocksize < raw.size(); ++b) {
+                writeAt(f, t.offset + b * blockskip,
+                    std::span(raw).subspan(b * blocksize, std::min(blocksize, raw.size() - b * blocksize)));
+            }
+        }
+        f.close();
+        if (!f) {
+            throw std::runtime_error("cannot write test file");
+        }
+        // the rest of the file is a hole, so it needs (almost) no space on disk
+        fs::resize_file(path, FileSize);
+    }
+
+    bool matches(std::size_t trace, std::span<const double> values)
+    {
+        if (values.size() != Traces[trace].npoints) {
+            return false;
+        }
+        for (std::size_t k = 0; k < values.size(); ++k) {
+            if (values[k] != expectedValue(trace, k)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Source> void checkTraces(Source& source, DatFile& datfile)
+    {
+        const auto traces = datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace);
+        CHECK(traces.size() == Traces.size());
+        for (std::size_t i = 0; i < traces.size(); ++i) {
+            CHECK(TraceDataOffset(traces[i]) == Traces[i].offset);
+            CHECK(matches(i, TraceView(source, traces[i]).toVector()));
+            std::vector<double> values(traces[i].get(Trace::DataPoints));
+            ReadScaleAndConvert(source, traces[i], values.data());
+            CHECK(matches(i, values));
+            const auto n = traces[i].get(Trace::DataPoints);
+            const auto window = TraceView(source, traces[i], n / 2, n).toVector();
+            CHECK(window.size() == n - n / 2 && window.back() == expectedValue(i, n - 1));
+        }
+    }
+
+    template<typename Source> void checkRejected(Source& source, DatFile& datfile)
+    {
+        const auto traces = datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace);
+        for (std::size_t i = 0; i < traces.size(); ++i) {
+            const auto& t = Traces[i];
+            const std::uint64_t nbytes = t.npoints * TraceView::sampleSizeOf(t.format);
+            std::uint64_t end = t.offset + nbytes;
+            if (t.interleave_size) {
+                const std::uint64_t lastblock = (nbytes - 1) / t.interleave_size;
+                end = t.offset + lastblock * t.interleave_skip + (nbytes - lastblock * t.interleave_size);
+            }
+            const bool outside = end > 4 * GiB;
+            if constexpr (std::is_base_of_v<std::istream, Source>) {
+                source.clear(); // a failed read leaves the stream in fail state
+            }
+            bool threw = false;
+            try {
+                CHECK(matches(i, TraceView(source, traces[i]).toVector()));
+            }
+            catch (const std::runtime_error&) {
+                threw = true;
+            }
+            CHECK(threw == outside);
+        }
+    }
+
+    template<typename Source> bool initRejected(Source& source)
+    {
+        DatFile datfile;
+        try {
+            datfile.InitFromStream(source);
+        }
+        catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    const auto path = fs::temp_directory_path() / "pmbrowser_large_file_test.dat";
+    try {
+        createFile(path);
+        CHECK(fs::file_size(path) > 4 * GiB);
+        {
+            MappedFileStream infile(path);
+            CHECK(bool(infile));
+            DatFile datfile;
+            datfile.InitFromStream(infile);
+            checkTraces(infile, datfile);
+        }
+        {
+            std::ifstream infile(path, std::ios::binary);
+            DatFile datfile;
+            datfile.InitFromStream(infile);
+            checkTraces(infile, datfile);
+            // the interleaved channels of sweep 2 are gathered together
+            const auto traces = datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace);
+            std::vector<const hkTreeNode*> records;
+            for (const auto& tr : traces) records.push_back(&tr);
+            std::size_t count = 0;
+            TraceBatchReader(infile).read(records, [&](std::size_t i, const TraceView& trace) {
+                CHECK(matches(i, trace.toVector()));
+                ++count;
+            });
+            CHECK(count == Traces.size());
+        }
+        {
+            PositionalReader reader(path);
+            DatFile datfile;
+            datfile.InitFromStream(reader);
+            checkTraces(reader, datfile);
+        }
+
+        // trace data beyond the end of the file
+        fs::resize_file(path, 4 * GiB);
+        {
+            MappedFileStream infile(path);
+            DatFile datfile;
+            datfile.InitFromStream(infile);
+            checkRejected(infile, datfile);
+        }
+        {
+            std::ifstream infile(path, std::ios::binary);
+            DatFile datfile;
+            datfile.InitFromStream(infile);
+            checkRejected(infile, datfile);
+        }
+        {
+            PositionalReader reader(path);
+            DatFile datfile;
+            datfile.InitFromStream(reader);
+            checkRejected(reader, datfile);
+        }
+
+        // pulse tree extends beyond the end of the file
+        fs::resize_file(path, PulOffset + 100);
+        {
+            MappedFileStream infile(path);
+            CHECK(initRejected(infile));
+        }
+        {
+            std::ifstream infile(path, std::ios::binary);
+            CHECK(initRejected(infile));
+        }
+        {
+            PositionalReader reader(path);
+            CHECK(initRejected(reader));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "error " << e.what() << '\n';
+        ++failures;
+    }
+    fs::remove(path);
+    if (failures) {
+        std::cerr << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// LRU order, byte accounting (charged by buffer capacity), budget changes and statistics of TraceCache
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "hkTree.h"
+#include "TraceCache.h"
+
+using namespace hkLib;
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { ++failures; std::cerr << "check failed: " #cond " (line " << __LINE__ << ")\n"; } } while (0)
+
+    constexpr std::size_t N = 1000; // samples per trace
+
+    TraceCache::TraceData makeData(std::size_t size, std::size_t capacity = 0)
+    {
+        auto v = std::make_shared<std::vector<double>>();
+        v->reserve(std::max(size, capacity));
+        v->resize(size, 1.0);
+        return v;
+    }
+
+    // bytes charged for an entry with a buffer of the given capacity
+    std::size_t chargeOf(std::size_t capacity)
+    {
+        TraceCache cache;
+        hkTreeNode node;
+        cache.insert(&node, makeData(capacity));
+        return cache.getStats().bytes;
+    }
+
+    void testByteAccounting()
+    {
+        const auto one = chargeOf(N);
+        CHECK(one >= N * sizeof(double));
+        const auto overhead = one - N * sizeof(double);
+        CHECK(chargeOf(2 * N) == 2 * N * sizeof(double) + overhead);
+
+        hkTreeNode a, b;
+        TraceCache cache;
+        cache.insert(&a, makeData(N));
+        cache.insert(&b, makeData(N));
+        CHECK(cache.getStats().bytes == 2 * one);
+        CHECK(cache.getStats().entries == 2);
+        // replacing an entry charges only the new data
+        cache.insert(&a, makeData(2 * N));
+        CHECK(cache.getStats().bytes == one + 2 * N * sizeof(double) + overhead);
+        CHECK(cache.getStats().entries == 2);
+        // the whole allocation counts, not just the samples in use
+        cache.insert(&b, makeData(10, 4 * N));
+        CHECK(cache.getStats().bytes == 2 * N * sizeof(double) + 4 * N * sizeof(double) + 2 * overhead);
+        cache.clear();
+        CHECK(cache.getStats().bytes == 0 && cache.getStats().entries == 0);
+        CHECK(!cache.contains(&a) && !cache.contains(&b));
+    }
+
+    void testLruOrder()
+    {
+        const auto one = chargeOf(N);
+        hkTreeNode a, b, c, d;
+        TraceCache cache(3 * one);
+        cache.insert(&a, makeData(N));
+        cache.insert(&b, makeData(N));
+        cache.insert(&c, makeData(N));
+        CHECK(cache.find(&a) != nullptr); // a becomes most recently used
+        cache.insert(&d, makeData(N));
+        CHECK(cache.contains(&a) && !cache.contains(&b) && cache.contains(&c) && cache.contains(&d));
+        CHECK(cache.getStats().evictions == 1);
+        CHECK(cache.getStats().bytes == 3 * one);
+
+        // contains() does not change the order
+        CHECK(cache.contains(&c));
+        cache.insert(&b, makeData(N));
+        CHECK(!cache.contains(&c) && cache.contains(&a) && cache.contains(&d) && cache.contains(&b));
+        CHECK(cache.getStats().evictions == 2);
+    }
+
+    void testBudget()
+    {
+        const auto one = chargeOf(N);
+        hkTreeNode a, b, c, big;
+        TraceCache cache(3 * one);
+        cache.insert(&a, makeData(N));
+        cache.insert(&b, makeData(N));
+        cache.insert(&c, makeData(N));
+        // entries larger than the budget are not stored and don't evict anything
+        cache.insert(&big, makeData(4 * N));
+        CHECK(!cache.contains(&big));
+        CHECK(cache.getStats().entries == 3 && cache.getStats().evictions == 0);
+
+        // shrinking the budget evicts the least recently used entries
+        auto held = cache.find(&a);
+        cache.setBudget(2 * one);
+        CHECK(cache.getBudget() == 2 * one);
+        CHECK(cache.contains(&a) && !cache.contains(&b) && cache.contains(&c));
+        CHECK(cache.getStats().bytes == 2 * one);
+        cache.setBudget(0);
+        CHECK(cache.getStats().entries == 0 && cache.getStats().bytes == 0);
+        CHECK(cache.getStats().evictions == 3);
+        // evicted data stays valid for its holders
+        CHECK(held && held->size() == N && held->front() == 1.0);
+    }
+
+    void testStats()
+    {
+        hkTreeNode a, b;
+        TraceCache cache;
+        CHECK(cache.find(&a) == nullptr);
+        cache.insert(&a, makeData(N));
+        CHECK(cache.find(&a) != nullptr);
+        CHECK(cache.find(&a) != nullptr);
+        CHECK(cache.find(&b) == nullptr);
+        cache.contains(&a);
+        auto stats = cache.getStats();
+        CHECK(stats.hits == 2 && stats.misses == 2);
+        cache.insert(&b, nullptr); // ignored
+        CHECK(cache.getStats().entries == 1);
+        cache.resetStats();
+        stats = cache.getStats();
+        CHECK(stats.hits == 0 && stats.misses == 0 && stats.evictions == 0 && stats.entries == 1);
+    }
+}
+
+int main()
+{
+    testByteAccounting();
+    testLruOrder();
+    testBudget();
+    testStats();
+    if (failures) {
+        std::cerr << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,347 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Loads a synthetic bundle file stored in non-native byte order, with pul, pgf and amp trees
+// filled with pseudo-random record data, with and without conversion to native byte order
+// (DatFile::setConvertTreesToNative). Every value of the parameter tables (PMparameters.h) and
+// every field of RecordFields.h must read the same either way.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "DatFile.h"
+#include "machineinfo.h"
+#include "MappedFile.h"
+#include "PMparameters.h"
+#include "RecordFields.h"
+
+using namespace hkLib;
+namespace fs = std::filesystem;
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { ++failures; std::cerr << "check failed: " #cond " (line " << __LINE__ << ")\n"; } } while (0)
+
+    // append a value in non-native byte order
+    template<typename T> void putSwapped(std::vector<char>& buf, T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(std::begin(bytes), std::end(bytes));
+        buf.insert(buf.end(), std::begin(bytes), std::end(bytes));
+    }
+
+    template<typename T> void setSwapped(std::vector<char>& buf, std::size_t offset, T value)
+    {
+        std::vector<char> bytes;
+        putSwapped(bytes, value);
+        std::copy(bytes.begin(), bytes.end(), buf.begin() + offset);
+    }
+
+    // Pseudo-random record bytes. The bytes are limited to 0x38...0x41, so that any double
+    // is finite and of moderate size (also as a date), and any 8 bytes are rarely a palindrome,
+    // i.e. a field that is not converted reads a different value.
+    class RecordBytes {
+        std::uint32_t state{ 12345 };
+    public:
+        char next()
+        {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<char>(0x38 + (state >> 24) % 10);
+        }
+    };
+
+    std::size_t recordSize(std::span<const PMparameter> params, std::size_t min_size = 0)
+    {
+        std::size_t size = min_size;
+        for (const auto& p : params) {
+            size = std::max(size, p.offset + 400); // largest parameter is a 400 char string
+        }
+        return size;
+    }
+
+    // a tree with one chain of records, the last level has n_last records
+    std::vector<char> makeTree(const std::vector<std::size_t>& sizes, std::uint32_t n_last, RecordBytes& rnd)
+    {
+        std::vector<char> tree;
+        putSwapped(tree, std::uint32_t(0x54726565)); // "Tree"
+        putSwapped(tree, static_cast<std::uint32_t>(sizes.size()));
+        for (auto size : sizes) {
+            putSwapped(tree, static_cast<std::uint32_t>(size));
+        }
+        for (std::size_t level = 0; level < sizes.size(); ++level) {
+            const bool last = level + 1 == sizes.size();
+            for (std::uint32_t i = 0; i < (last ? n_last : 1); ++i) {
+                for (std::size_t k = 0; k < sizes[level]; ++k) {
+                    tree.push_back(rnd.next());
+                }
+                putSwapped(tree, last ? std::uint32_t(0) : (level + 2 == sizes.size() ? n_last : 1));
+            }
+        }
+        return tree;
+    }
+
+    void createFile(const fs::path& path)
+    {
+        RecordBytes rnd;
+        const auto pul = makeTree({ recordSize(parametersRoot), recordSize(parametersGroup),
+            recordSize(parametersSeries, SeOldAmpState + AmplifierStateSize), recordSize(parametersSweep),
+            recordSize(parametersTrace) }, 2, rnd);
+        const auto pgf = makeTree({ recordSize(parametersStimRoot), recordSize(parametersStimulation),
+            recordSize(parametersChannel), recordSize(parametersStimSegment) }, 3, rnd);
+        const auto amp = makeTree({ 128, 16, AmAmplifierState + AmplifierStateSize }, 2, rnd);
+
+        std::vector<char> file(BundleHeaderSize);
+        std::strcpy(file.data(), BundleSignature);
+        std::strcpy(file.data() + offsetof(BundleHeader, Version), "v2x90");
+        setSwapped(file, offsetof(BundleHeader, Time), 1.5e9);
+        setSwapped(file, offsetof(BundleHeader, Items), std::int32_t(4));
+        file[offsetof(BundleHeader, IsLittleEndian)] = !MachineIsLittleEndian();
+        const std::vector<char> data(1024);
+        std::size_t start = BundleHeaderSize, item = 0;
+        const std::pair<const char*, const std::vector<char>*> items[] = {
+            { ExtDat, &data }, { ExtPul, &pul }, { ExtPgf, &pgf }, { ExtAmp, &amp } };
+        for (auto [ext, content] : items) {
+            const auto pos = offsetof(BundleHeader, BundleItems) + item * sizeof(BundleItem);
+            setSwapped(file, pos + offsetof(BundleItem, Start), static_cast<std::uint32_t>(start));
+            setSwapped(file, pos + offsetof(BundleItem, Length), static_cast<std::uint32_t>(content->size()));
+            std::strcpy(file.data() + pos + offsetof(BundleItem, Extension), ext);
+            start += content->size();
+            ++item;
+        }
+        for (const auto* content : { &data, &pul, &pgf, &amp }) {
+            file.insert(file.end(), content->begin(), content->end());
+        }
+        std::ofstream out(path, std::ios::binary);
+        out.write(file.data(), file.size());
+        if (!out) {
+            throw std::runtime_error("cannot write test file");
+        }
+    }
+
+    // values as text, numbers by their bytes (also comparing NaNs)
+    template<typename Field> std::string valueOf(const hkTreeNode& node, Field field)
+    {
+        const auto value = node.get(field);
+        if constexpr (std::is_same_v<typename Field::value_type, std::string_view>) {
+            return std::string(value);
+        }
+        else {
+            unsigned char bytes[sizeof(value)];
+            std::memcpy(bytes, &value, sizeof(value));
+            std::ostringstream s;
+            s << std::hex;
+            for (auto b : bytes) {
+                s << std::setw(2) << std::setfill('0') << int(b);
+            }
+            return s.str();
+        }
+    }
+
+    template<typename... Fields> void addFields(std::vector<std::string>& values, const hkTreeNode& node, Fields... fields)
+    {
+        (values.push_back(valueOf(node, fields)), ...);
+    }
+
+    void addParameters(std::vector<std::string>& values, const hkTreeNode& node, std::span<const PMparameter> params)
+    {
+        for (const auto& p : params) {
+            std::ostringstream s;
+            s << p.name << '=';
+            p.formatValueOnly(node, s);
+            values.push_back(s.str());
+        }
+    }
+
+    void addAmpState(std::vector<std::string>& values, const hkTreeNode& node, std::size_t offset)
+    {
+        hkTreeNode amprecord;
+        amprecord.isSwapped = node.getIsSwapped();
+        amprecord.Data = node.Data.subspan(offset, AmplifierStateSize);
+        addParameters(values, amprecord, parametersAmpplifierState);
+    }
+
+    // all values of the parameter tables and the record fields, in tree order
+    std::vector<std::string> allValues(DatFile& datfile)
+    {
+        std::vector<std::string> values;
+        auto& pul = datfile.GetPulTree();
+        for (auto& node : pul.GetLevelNodes(hkTreeNode::LevelRoot)) {
+            addParameters(values, node, parametersRoot);
+            addFields(values, node, Root::VersionName, Root::StartTime);
+        }
+        for (auto& node : pul.GetLevelNodes(hkTreeNode::LevelGroup)) {
+            addParameters(values, node, parametersGroup);
+            addFields(values, node, Group::Label, Group::GroupCount);
+        }
+        for (auto& node : pul.GetLevelNodes(hkTreeNode::LevelSeries)) {
+            addParameters(values, node, parametersSeries);
+            addAmpState(values, node, SeOldAmpState);
+            addFields(values, node, Series::Label, Series::SeriesCount, Series::AmplStateFlag,
+                Series::AmplStateRef, Series::Time);
+        }
+        for (auto& node : pul.GetLevelNodes(hkTreeNode::LevelSweep)) {
+            addParameters(values, node, parametersSweep);
+            addFields(values, node, Sweep::Label, Sweep::StimCount, Sweep::SweepCount, Sweep::Time, Sweep::Timer);
+        }
+        for (auto& node : pul.GetLevelNodes(hkTreeNode::LevelTrace)) {
+            addParameters(values, node, parametersTrace);
+            addFields(values, node, Trace::Label, Trace::TraceID, Trace::Data, Trace::DataPoints, Trace::DataKind,
+                Trace::RecordingMode, Trace::DataFormat, Trace::DataScaler, Trace::YUnit, Trace::XInterval,
+                Trace::XStart, Trace::XUnit, Trace::SealResistance, Trace::CSlow, Trace::GSeries, Trace::RsValue,
+                Trace::LinkDAChannel, Trace::InterleaveSize, Trace::InterleaveSkip, Trace::Holding);
+        }
+
+        auto& pgf = datfile.GetPgfTree();
+        for (auto& node : pgf.GetLevelNodes(0)) {
+            addParameters(values, node, parametersStimRoot);
+        }
+        for (auto& node : pgf.GetLevelNodes(hkTreeNode::StimulationLevel)) {
+            addParameters(values, node, parametersStimulation);
+            addFields(values, node, Stimulation::EntryName, Stimulation::FileName, Stimulation::DataStartSegment,
+                Stimulation::DataStartTime, Stimulation::NumberSweeps, Stimulation::ActualDacChannels,
+                Stimulation::ExtTrigger, Stimulation::HasLockIn);
+        }
+        for (auto& node : pgf.GetLevelNodes(hkTreeNode::ChannelLevel)) {
+            addParameters(values, node, parametersChannel);
+            addFields(values, node, Channel::LinkedChannel, Channel::AdcChannel, Channel::AdcMode,
+                Channel::SetLastSegVmemb, Channel::DacChannel, Channel::DacMode, Channel::DacUnit, Channel::Holding);
+        }
+        for (auto& node : pgf.GetLevelNodes(hkTreeNode::StimSegmentLevel)) {
+            addParameters(values, node, parametersStimSegment);
+            addFields(values, node, Segment::Class, Segment::VoltageIncMode, Segment::DurationIncMode,
+                Segment::Voltage, Segment::VoltageSource, Segment::DeltaVFactor, Segment::DeltaVIncrement,
+                Segment::Duration, Segment::DurationSource, Segment::DeltaTFactor, Segment::DeltaTIncrement);
+        }
+
+        auto& amp = datfile.GetAmpTree();
+        for (auto& node : amp.GetLevelNodes(hkTreeNode::LevelRoot)) {
+            addFields(values, node, AmpRoot::AmplifierName, AmpRoot::Amplifier, AmpRoot::ADBoard);
+        }
+        for (auto& node : amp.GetLevelNodes(AmpState::L)) {
+            addAmpState(values, node, AmAmplifierState);
+            addFields(values, node, AmpState::StateCount);
+        }
+        return values;
+    }
+
+    bool treesSwapped(DatFile& datfile, bool swapped)
+    {
+        for (auto* tree : { &datfile.GetPulTree(), &datfile.GetPgfTree(), &datfile.GetAmpTree() }) {
+            if (tree->getIsSwapped() != swapped) {
+                return false;
+            }
+            for (std::size_t level = 0; level < tree->GetNumLevels(); ++level) {
+                for (const auto& node : tree->GetLevelNodes(static_cast<int>(level))) {
+                    if (node.getIsSwapped() != swapped) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    void checkSameValues(const std::vector<std::string>& reference, const std::vector<std::string>& values)
+    {
+        CHECK(reference.size() == values.size());
+        const auto n = std::min(reference.size(), values.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            if (reference[i] != values[i]) {
+                ++failures;
+                std::cerr << "value differs after conversion: " << reference[i] << " vs. " << values[i] << '\n';
+            }
+        }
+    }
+}
+
+int main()
+{
+    const auto path = fs::temp_directory_path() / "pmbrowser_tree_byte_order_test.dat";
+    try {
+        createFile(path);
+        std::vector<std::string> reference;
+        {
+            // by default, trees are not converted
+            std::ifstream infile(path, std::ios::binary);
+            DatFile datfile;
+            CHECK(!datfile.getConvertTreesToNative());
+            datfile.InitFromStream(infile);
+            CHECK(datfile.getIsSwapped());
+            CHECK(treesSwapped(datfile, true));
+            CHECK(datfile.GetPulTree().GetLevelNodes(hkTreeNode::LevelTrace).size() == 2);
+            CHECK(datfile.GetPgfTree().GetLevelNodes(hkTreeNode::StimSegmentLevel).size() == 3);
+            CHECK(datfile.GetAmpTree().GetLevelNodes(AmpState::L).size() == 2);
+            reference = allValues(datfile);
+        }
+        {
+            std::ifstream infile(path, std::ios::binary);
+            DatFile datfile;
+            datfile.setConvertTreesToNative(true);
+            datfile.InitFromStream(infile);
+            CHECK(datfile.getIsSwapped());
+            CHECK(treesSwapped(datfile, false));
+            checkSameValues(reference, allValues(datfile));
+        }
+        {
+            // converted trees are copied from the read-only mapping, the mapping stays as it is
+            MappedFileStream infile(path);
+            CHECK(bool(infile));
+            DatFile converted;
+            converted.setConvertTreesToNative(true);
+            converted.InitFromStream(infile);
+            CHECK(treesSwapped(converted, false));
+            checkSameValues(reference, allValues(converted));
+            infile.clear();
+            infile.seekg(0);
+            DatFile plain;
+            plain.InitFromStream(infile);
+            CHECK(treesSwapped(plain, true));
+            checkSameValues(reference, allValues(plain));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "unexpected exception: " << e.what() << '\n';
+        ++failures;
+    }
+    std::error_code ec;
+    fs::remove(path, ec);
+    if (failures) {
+        std::cerr << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,294 @@
+/*
+    Copyright 2026 Christian R. Halaszovich
+
+     This file is part of PMbrowser.
+
+    PMbrowser is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    PMbrowser is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with PMbrowser.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// TreeQuery on a small synthetic pulse tree: label, range, equals (numbers and texts), regex
+// and time window predicates, and pruning of branches without selected traces
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "DatFile.h"
+#include "RecordFields.h"
+#include "TreeQuery.h"
+
+using namespace hkLib;
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { ++failures; std::cerr << "check failed: " #cond " (line " << __LINE__ << ")\n"; } } while (0)
+
+    // two groups, each with two series of two sweeps of two traces
+    constexpr int N = 2;
+    constexpr double StartTime = 1000.0;
+    const char* const GroupLabels[N] = { "ctrl", "drug" };
+    const char* const SeriesLabels[N] = { "IV", "ramp" };
+    const char* const TraceLabels[N] = { "Imon", "Vmon" };
+
+    // series time relative to start of tree
+    double seriesTime(int g, int s) { return 100.0 * g + 10.0 * s; }
+    double sweepTime(int g, int s, int w) { return seriesTime(g, s) + w; }
+    double rs(int g, int s, int w, int t) { return 1e6 * (1 + 10 * g + 4 * s + 2 * w + t); }
+    char recordingMode(int g) { return g == 0 ? VClamp : CClamp; }
+
+    struct TraceId {
+        int g, s, w, t;
+    };
+    using Selection = std::function<bool(const TraceId&)>;
+
+    template<typename Field> void set(std::vector<char>& record, Field, typename Field::value_type value)
+    {
+        std::memcpy(record.data() + Field::offset, &value, sizeof(value));
+    }
+
+    void setLabel(std::vector<char>& record, std::size_t offset, const char* label)
+    {
+        std::strcpy(record.data() + offset, label);
+    }
+
+    template<typename T> void put(std::string& buf, T value)
+    {
+        buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void addNode(std::string& tree, const std::vector<char>& record, std::uint32_t nchildren)
+    {
+        tree.append(record.data(), record.size());
+        put(tree, nchildren);
+    }
+
+    void makeTree(hkTree& tree)
+    {
+        const std::uint32_t sizes[] = { 544, 128, 1728, 352, 512 };
+        std::string buf;
+        put(buf, std::uint32_t(0x54726565)); // "Tree"
+        put(buf, std::uint32_t(std::size(sizes)));
+        for (auto size : sizes) {
+            put(buf, size);
+        }
+        std::vector<char> root(sizes[0]);
+        set(root, Root::StartTime, StartTime);
+        addNode(buf, root, N);
+        for (int g = 0; g < N; ++g) {
+            std::vector<char> group(sizes[1]);
+            setLabel(group, GrLabel, GroupLabels[g]);
+            addNode(buf, group, N);
+            for (int s = 0; s < N; ++s) {
+                std::vector<char> series(sizes[2]);
+                setLabel(series, SeLabel, SeriesLabels[s]);
+                set(series, Series::Time, StartTime + seriesTime(g, s));
+                addNode(buf, series, N);
+                for (int w = 0; w < N; ++w) {
+                    std::vector<char> sweep(sizes[3]);
+                    set(sweep, Sweep::Time, StartTime + sweepTime(g, s, w));
+                    addNode(buf, sweep, N);
+                    for (int t = 0; t < N; ++t) {
+                        std::vector<char> trace(sizes[4]);
+                        setLabel(trace, TrLabel, TraceLabels[t]);
+                        set(trace, Trace::TraceID, t + 1);
+                        set(trace, Trace::RecordingMode, recordingMode(g));
+                        set(trace, Trace::GSeries, 1.0 / rs(g, s, w, t));
+                        addNode(buf, trace, 0);
+                    }
+                }
+            }
+        }
+        std::istringstream stream(buf);
+        tree.InitFromStream(ExtPul, stream, 0, buf.size());
+        tree.GetRootNode().setAsTime0();
+    }
+
+    std::vector<std::string> names(const std::vector<const hkTreeNode*>& traces)
+    {
+        std::vector<std::string> result;
+        for (const auto* trace : traces) {
+            const auto* sweep = trace->getParent();
+            const auto* series = sweep->getParent();
+            const auto* group = series->getParent();
+            auto index = [](const hkTreeNode* node) { return node - &node->getParent()->Children.at(0); };
+            result.push_back(std::to_string(index(group)) + std::to_string(index(series))
+                + std::to_string(index(sweep)) + std::to_string(index(trace)));
+        }
+        return result;
+    }
+
+    std::vector<std::string> expected(const Selection& selected)
+    {
+        std::vector<std::string> result;
+        for (int g = 0; g < N; ++g) {
+            for (int s = 0; s < N; ++s) {
+                for (int w = 0; w < N; ++w) {
+                    for (int t = 0; t < N; ++t) {
+                        if (selected({ g, s, w, t })) {
+                            result.push_back(std::to_string(g) + std::to_string(s) + std::to_string(w) + std::to_string(t));
+                        }
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    // every branch of the view leads to a selected trace
+    bool pruned(const hkNodeView& view)
+    {
+        if (view.p_node->getLevel() == hkTreeNode::LevelTrace) {
+            return view.children.empty();
+        }
+        if (view.children.empty()) {
+            return false;
+        }
+        for (const auto& child : view.children) {
+            if (!pruned(child)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void checkQuery(hkTree& tree, const TreeQuery& query, const Selection& selected, int line)
+    {
+        const auto view = query.run(tree);
+        const auto result = names(view.GetNodeListForLevel(hkTreeNode::LevelTrace));
+        const auto want = expected(selected);
+        if (result != want) {
+            ++failures;
+            std::cerr << "query (line " << line << ") selected " << result.size() << " traces, expected " << want.size() << '\n';
+        }
+        CHECK(view.root.p_node == &tree.GetRootNode());
+        if (want.empty()) {
+            CHECK(view.root.children.empty());
+        }
+        else {
+            CHECK(pruned(view.root));
+        }
+    }
+
+#define CHECK_QUERY(query, selected) checkQuery(tree, query, selected, __LINE__)
+
+    void testQueries(hkTree& tree)
+    {
+        CHECK_QUERY(TreeQuery(), [](const TraceId&) { return true; });
+
+        // ranges, "Rs" is the inverse of Gseries
+        CHECK_QUERY(TreeQuery().range(hkTreeNode::LevelTrace, "Rs", 5e6, 12e6), [](const TraceId& id) {
+            const auto v = rs(id.g, id.s, id.w, id.t);
+            return v >= 5e6 && v <= 12e6; });
+        CHECK_QUERY(TreeQuery().range(hkTreeNode::LevelTrace, "Rs", 20e6, 1e9), [](const TraceId&) { return false; });
+        CHECK_QUERY(TreeQuery().range(hkTreeNode::LevelSeries, "Rel. SeTime", 5.0, 100.0), [](const TraceId& id) {
+            return seriesTime(id.g, id.s) >= 5.0 && seriesTime(id.g, id.s) <= 100.0; });
+
+        // equals, numbers (codes of enumerations) and texts
+        CHECK_QUERY(TreeQuery().equals(hkTreeNode::LevelTrace, "Recording Mode", double(CClamp)),
+            [](const TraceId& id) { return recordingMode(id.g) == CClamp; });
+        CHECK_QUERY(TreeQuery().equals(hkTreeNode::LevelSeries, "SeLabel", "ramp"),
+            [](const TraceId& id) { return id.s == 1; });
+        CHECK_QUERY(TreeQuery().equals(hkTreeNode::LevelSeries, "SeLabel", "ram"), [](const TraceId&) { return false; });
+
+        // regular expressions, on text parameters and labels
+        CHECK_QUERY(TreeQuery().matches(hkTreeNode::LevelGroup, "GrLabel", "^dr"), [](const TraceId& id) { return id.g == 1; });
+        CHECK_QUERY(TreeQuery().label(hkTreeNode::LevelSeries, "^I").label(hkTreeNode::LevelTrace, "V"),
+            [](const TraceId& id) { return id.s == 0 && id.t == 1; });
+        CHECK_QUERY(TreeQuery().label(hkTreeNode::LevelGroup, "trl|rug").label(hkTreeNode::LevelTrace, "mon$"),
+            [](const TraceId&) { return true; });
+
+        // time windows [t_start, t_end)
+        CHECK_QUERY(TreeQuery().timeWindow(hkTreeNode::LevelSeries, 10.0, 110.0), [](const TraceId& id) {
+            return seriesTime(id.g, id.s) >= 10.0 && seriesTime(id.g, id.s) < 110.0; });
+        CHECK_QUERY(TreeQuery().timeWindow(hkTreeNode::LevelSweep, 10.5, 101.0), [](const TraceId& id) {
+            const auto t = sweepTime(id.g, id.s, id.w);
+            return t >= 10.5 && t < 101.0; });
+
+        // predicates of several levels must all hold
+        CHECK_QUERY(TreeQuery().matches(hkTreeNode::LevelGroup, "GrLabel", "ctrl")
+            .timeWindow(hkTreeNode::LevelSweep, 0.0, 10.5).range(hkTreeNode::LevelTrace, "Rs", 0.0, 2.5e6),
+            [](const TraceId& id) { return id.g == 0 && sweepTime(id.g, id.s, id.w) < 10.5 && rs(id.g, id.s, id.w, id.t) <= 2.5e6; });
+    }
+
+    void testPruning(hkTree& tree)
+    {
+        // traces only in the second sweep of the first series of each group,
+        // the other series (and sweeps) are omitted, not kept without children
+        const auto view = TreeQuery().timeWindow(hkTreeNode::LevelSweep, 0.5, 1.5)
+            .label(hkTreeNode::LevelTrace, "Imon").run(tree);
+        CHECK(view.root.children.size() == 1);
+        CHECK(view.GetNodeListForLevel(hkTreeNode::LevelGroup).size() == 1);
+        CHECK(view.GetNodeListForLevel(hkTreeNode::LevelSeries).size() == 1);
+        CHECK(view.GetNodeListForLevel(hkTreeNode::LevelSweep).size() == 1);
+        CHECK(view.GetNodeListForLevel(hkTreeNode::LevelTrace).size() == 1);
+        CHECK(pruned(view.root));
+    }
+
+    void testInvalidQueries()
+    {
+        bool thrown = false;
+        try { TreeQuery().range(hkTreeNode::LevelSeries, "SeLabel", 0.0, 1.0); }
+        catch (const std::invalid_argument&) { thrown = true; }
+        CHECK(thrown);
+        thrown = false;
+        try { TreeQuery().equals(hkTreeNode::LevelTrace, "Rs", "1"); }
+        catch (const std::invalid_argument&) { thrown = true; }
+        CHECK(thrown);
+        thrown = false;
+        try { TreeQuery().range(hkTreeNode::LevelTrace, "no such parameter", 0.0, 1.0); }
+        catch (const std::invalid_argument&) { thrown = true; }
+        CHECK(thrown);
+        thrown = false;
+        try { TreeQuery().timeWindow(hkTreeNode::LevelTrace, 0.0, 1.0); }
+        catch (const std::invalid_argument&) { thrown = true; }
+        CHECK(thrown);
+        thrown = false;
+        try { TreeQuery().label(hkTreeNode::LevelSeries, "(unbalanced"); }
+        catch (const std::regex_error&) { thrown = true; }
+        CHECK(thrown);
+        TreeQuery query;
+        try { query.range(hkTreeNode::LevelTrace, "no such parameter", 0.0, 1.0); }
+        catch (const std::invalid_argument&) {}
+        CHECK(query.empty());
+    }
+}
+
+int main()
+{
+    try {
+        hkTree tree;
+        makeTree(tree);
+        testQueries(tree);
+        testPruning(tree);
+        testInvalidQueries();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "unexpected exception: " << e.what() << '\n';
+        ++failures;
+    }
+    if (failures) {
+        std::cerr << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}